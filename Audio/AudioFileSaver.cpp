@@ -163,16 +163,10 @@ AudioFileWriter::close(void)
 //////////////////////////////// AudioFileSaver ///////////////////////////////
 
 
-AudioFileSaver::~AudioFileSaver()
-{
-  if (this->writer != nullptr)
-    delete this->writer;
-}
-
 AudioFileSaver::AudioFileSaver(
     AudioFileParams const &params,
     QObject *parent) :
-  GenericDataSaver(this->writer = new AudioFileWriter(params), parent)
+  GenericDataSaver(new AudioFileWriter(params), parent)
 {
   this->params = params;
   this->setSampleRate(params.sampRate);
@@ -38,6 +38,7 @@ void
 DataSaverConfig::deserialize(Suscan::Object const &conf)
 {
   LOAD(path);
+  LOAD(compress);
 }
 
 Suscan::Object &&
@@ -48,6 +49,7 @@ DataSaverConfig::serialize(void)
   obj.setClass("DataSaverConfig");
 
   STORE(path);
+  STORE(compress);
 
   return this->persist(obj);
 }
@@ -67,6 +69,12 @@ DataSaverUI::connectAll(void)
         SIGNAL(clicked(bool)),
         this,
         SLOT(onRecordStartStop(void)));
+
+  connect(
+        this->ui->compressCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onToggleCompress(void)));
 }
 
 // Setters
@@ -119,9 +127,35 @@ DataSaverUI::setRecordState(bool state)
   this->ui->recordStartStopButton->setChecked(state);
 
   this->ui->recordStartStopButton->setText(state ? "Stop" : "Record");
+  this->ui->compressCheck->setEnabled(!state);
 
   if (!state)
     this->ui->ioBwProgress->setValue(0);
+  else
+    this->ui->metricsLabel->setText("N/A");
+}
+
+void
+DataSaverUI::setMetrics(GenericDataSaverMetrics const &metrics)
+{
+  QString text =
+      SuWidgetsHelpers::formatBinaryQuantity(
+        static_cast<qint64>(metrics.bytesPerSecond)) + "/s";
+
+  if (metrics.drops > 0)
+    text += ", " + QString::number(metrics.drops) + " drops";
+
+  this->ui->metricsLabel->setText(text);
+  this->ui->metricsLabel->setToolTip(metrics.toString());
+}
+
+void
+DataSaverUI::setCompressionAvailable(bool available)
+{
+  this->ui->compressCheck->setVisible(available);
+
+  if (!available)
+    this->ui->compressCheck->setChecked(false);
 }
 
 // Getters
@@ -137,6 +171,13 @@ DataSaverUI::getRecordSavePath(void) const
   return this->ui->savePath->text().toStdString();
 }
 
+bool
+DataSaverUI::getCompress(void) const
+{
+  return !this->ui->compressCheck->isHidden()
+      && this->ui->compressCheck->isChecked();
+}
+
 
 DataSaverUI::DataSaverUI(QWidget *parent) :
   GenericDataSaverUI(parent),
@@ -146,6 +187,9 @@ DataSaverUI::DataSaverUI(QWidget *parent) :
 
   this->setRecordSavePath(QDir::currentPath().toStdString());
 
+  // Only meaningful for complex baseband captures. Owner decides.
+  this->setCompressionAvailable(false);
+
   this->connectAll();
 }
 
@@ -167,6 +211,8 @@ DataSaverUI::applyConfig(void)
 {
   if (this->config->path.size() > 0)
     this->setRecordSavePath(this->config->path);
+
+  this->ui->compressCheck->setChecked(this->config->compress);
 }
 
 ///////////////////////////////// Slots ////////////////////////////////////////
@@ -198,6 +244,15 @@ DataSaverUI::onRecordStartStop(void)
         this->ui->recordStartStopButton->isChecked()
         ? "Stop"
         : "Record");
+  this->ui->compressCheck->setEnabled(
+        !this->ui->recordStartStopButton->isChecked());
 
   emit recordStateChanged(this->ui->recordStartStopButton->isChecked());
 }
+
+void
+DataSaverUI::onToggleCompress(void)
+{
+  if (this->config != nullptr)
+    this->config->compress = this->ui->compressCheck->isChecked();
+}
@@ -30,6 +30,12 @@ NetForwarderUI::connectAll(void)
         SIGNAL(clicked(bool)),
         this,
         SLOT(onForwardStartStop(void)));
+
+  connect(
+        this->ui->socketTypeCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onSocketTypeChanged(void)));
 }
 
 NetForwarderUI::NetForwarderUI(QWidget *parent) :
@@ -44,6 +50,7 @@ NetForwarderUI::NetForwarderUI(QWidget *parent) :
   this->ui->spinGrid->addWidget(this->spinner);
 
   this->connectAll();
+  this->onSocketTypeChanged();
 }
 
 NetForwarderUI::~NetForwarderUI()
@@ -91,8 +98,8 @@ NetForwarderUI::setForwardState(bool state)
   this->ui->udpStartStopButton->setChecked(state);
 
   this->ui->hostEdit->setEnabled(!state);
-  this->ui->portSpin->setEnabled(!state);
-  this->ui->frameLen->setEnabled(!state);
+  this->ui->socketTypeCombo->setEnabled(!state);
+  this->onSocketTypeChanged();
 
   this->ui->udpStartStopButton->setText(state ? "Stop" : "Forward");
 
@@ -135,6 +142,48 @@ void
 NetForwarderUI::setTcp(bool tcp)
 {
   this->ui->socketTypeCombo->setCurrentIndex(tcp ? 1 : 0);
+  this->onSocketTypeChanged();
+}
+
+void
+NetForwarderUI::setListen(bool listen)
+{
+  if (listen)
+    this->ui->socketTypeCombo->setCurrentIndex(2);
+  else if (this->getListen())
+    this->ui->socketTypeCombo->setCurrentIndex(1);
+
+  this->onSocketTypeChanged();
+}
+
+void
+NetForwarderUI::setSharedMemory(bool shm)
+{
+  if (shm)
+    this->ui->socketTypeCombo->setCurrentIndex(3);
+  else if (this->getSharedMemory())
+    this->ui->socketTypeCombo->setCurrentIndex(0);
+
+  this->onSocketTypeChanged();
+}
+
+void
+NetForwarderUI::setSlowClientPolicy(SlowClientPolicy policy)
+{
+  this->ui->slowClientCombo->setCurrentIndex(
+        policy == SLOW_CLIENT_POLICY_DISCONNECT ? 1 : 0);
+}
+
+void
+NetForwarderUI::setMetrics(GenericDataSaverMetrics const &metrics)
+{
+  this->ui->ioBwProgress->setToolTip(metrics.toString());
+}
+
+void
+NetForwarderUI::setHeader(bool header)
+{
+  this->ui->headerCheck->setChecked(header);
 }
 
 std::string
@@ -164,7 +213,35 @@ NetForwarderUI::getForwardState(void) const
 bool
 NetForwarderUI::getTcp(void) const
 {
-  return this->ui->socketTypeCombo->currentIndex() == 1;
+  int index = this->ui->socketTypeCombo->currentIndex();
+
+  return index == 1 || index == 2;
+}
+
+bool
+NetForwarderUI::getListen(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() == 2;
+}
+
+bool
+NetForwarderUI::getSharedMemory(void) const
+{
+  return this->ui->socketTypeCombo->currentIndex() == 3;
+}
+
+SlowClientPolicy
+NetForwarderUI::getSlowClientPolicy(void) const
+{
+  return this->ui->slowClientCombo->currentIndex() == 1
+      ? SLOW_CLIENT_POLICY_DISCONNECT
+      : SLOW_CLIENT_POLICY_DROP;
+}
+
+bool
+NetForwarderUI::getHeader(void) const
+{
+  return this->ui->headerCheck->isChecked();
 }
 
 ///////////////////////////////// Slots ///////////////////////////////////////
@@ -178,3 +255,17 @@ NetForwarderUI::onForwardStartStop(void)
 
   emit forwardStateChanged(this->ui->udpStartStopButton->isChecked());
 }
+
+void
+NetForwarderUI::onSocketTypeChanged(void)
+{
+  bool editable = !this->getForwardState();
+  bool shm = this->getSharedMemory();
+
+  // In shared memory mode the host field holds the segment name
+  this->ui->label_28->setText(shm ? "Segment" : "Host");
+  this->ui->portSpin->setEnabled(editable && !shm);
+  this->ui->frameLen->setEnabled(editable && !shm);
+  this->ui->headerCheck->setEnabled(editable && !shm);
+  this->ui->slowClientCombo->setEnabled(editable && this->getListen());
+}
@@ -18,24 +18,24 @@
 //
 
 #include <RMSViewTab.h>
+#include <RMSLog.h>
 #include <QMessageBox>
 #include <cctype>
 #include "ui_RMSViewTab.h"
-#include <sstream>
 #include <utility>
 #include <string>
+#include <cstring>
 #include <QDateTime>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <complex.h>
 #include <QToolTip>
-#define MAX_LINE_SIZE  4096
 #define TIMER_INTERVAL_MS 100
 using namespace SigDigger;
 
-RMSViewTab::RMSViewTab(QWidget *parent, QTcpSocket *socket) :
+RMSViewTab::RMSViewTab(QWidget *parent, RMSStream *stream) :
   QWidget(parent),
-  socket(socket),
+  m_stream(stream),
   ui(new Ui::RMSViewTab)
 {
   setlocale(LC_ALL, "C");
@@ -54,8 +54,13 @@ RMSViewTab::RMSViewTab(QWidget *parent, QTcpSocket *socket) :
 
   this->timer.start(TIMER_INTERVAL_MS);
 
-  if (socket != nullptr)
-    this->processSocketData();
+  // Measures that arrived before the tab was opened are only in the
+  // stream summary. The plot starts now.
+  if (m_stream != nullptr)
+    m_stream->setKeepMeasures(true);
+
+  // Streams do not go back to live once stopped, so no room for logs
+  this->ui->openButton->setVisible(m_stream == nullptr);
 
   this->connectAll();
 
@@ -80,10 +85,12 @@ RMSViewTab::setIntegrationTimeMode(qreal min, qreal max)
 qreal
 RMSViewTab::getCurrentTimeDelta() const
 {
-  if (intTimeMode())
-    return ui->intSpin->value() * ui->timeSpinBox->timeValue();
+  qreal decimation = SCAST(qreal, m_decimation);
+
+  if (intTimeMode() && !m_haveLog)
+    return decimation * ui->intSpin->value() * ui->timeSpinBox->timeValue();
   else
-    return ui->intSpin->value() / rate;
+    return decimation * ui->intSpin->value() / rate;
 }
 
 bool
@@ -114,7 +121,8 @@ void
 RMSViewTab::setSampleRate(qreal rate)
 {
   this->rate = rate;
-  this->ui->waveform->setSampleRate(rate / this->ui->intSpin->value());
+  this->ui->waveform->setSampleRate(
+        rate / this->ui->intSpin->value() / SCAST(qreal, m_decimation));
 
   bool blocked = ui->averageTimeSpinBox->blockSignals(true);
   this->ui->averageTimeSpinBox->setTimeMin(1. / rate);
@@ -238,7 +246,10 @@ RMSViewTab::saveToMatlab(QString const &path)
     return false;
   }
 
-  fprintf(fp, "RATE=%.9f;\n", this->rate / this->ui->intSpin->value());
+  fprintf(
+        fp,
+        "RATE=%.9f;\n",
+        this->rate / this->ui->intSpin->value() / SCAST(qreal, m_decimation));
   fprintf(fp, "TIMESTAMP=%.6f;\n", this->first);
   fprintf(fp, "X=[\n");
   for (size_t i = 0; i < this->data.size(); ++i)
@@ -263,16 +274,10 @@ RMSViewTab::integrateMeasure(qreal timestamp, SUFLOAT mag)
 
   if (++this->accum_ctr == intLen) {
     this->energy_accum /= intLen;
-    this->data.push_back(
-          this->energy_accum
-          + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(this->energy_accum)));
+    this->appendMeasure(this->energy_accum);
     this->last = timestamp;
     this->accum_ctr = 0;
     this->energy_accum = 0;
-    this->ui->waveform->refreshData();
-    if (this->ui->autoFitButton->isChecked())
-      this->fitVertical();
-    this->ui->waveform->invalidate();
   } else {
     if (m_haveCurrSamplePoint) {
       if (this->data.size() == 0) {
@@ -290,88 +295,160 @@ RMSViewTab::integrateMeasure(qreal timestamp, SUFLOAT mag)
   }
 }
 
+//
+// The history keeps every measure (at decreasing resolution as they get
+// older), and `data' is a view of it with one point per m_decimation
+// measures. When the view gets too long, the decimation doubles and the
+// view is rebuilt, so its size stays bounded no matter how long we run.
+//
+void
+RMSViewTab::appendMeasure(SUFLOAT mag)
+{
+  RMSHistoryBucket bucket;
+  quint64 size;
+
+  m_history.push(mag);
+  size = m_history.size();
+
+  if (size % m_decimation == 0) {
+    if (m_history.query(size - m_decimation, size, bucket))
+      mag = bucket.mean;
+
+    this->data.push_back(mag + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(mag)));
+  }
+
+  if (this->data.size() > RMS_VIEW_TAB_MAX_DISPLAY) {
+    m_decimation *= 2;
+    this->rebuildData();
+  }
+
+  m_dirty = true;
+}
+
+void
+RMSViewTab::rebuildData(void)
+{
+  std::vector<float> means;
+  size_t i;
+
+  m_history.render(means, m_decimation);
+
+  this->data.resize(means.size());
+  for (i = 0; i < means.size(); ++i)
+    this->data[i] =
+        means[i] + SU_I * SU_ASFLOAT(SU_POWER_DB_RAW(means[i]));
+
+  this->ui->waveform->setSampleRate(
+        this->rate
+        / this->ui->intSpin->value()
+        / SCAST(qreal, m_decimation));
+}
+
 bool
-RMSViewTab::parseLine(void)
+RMSViewTab::loadLog(QString const &path)
 {
-  SUFLOAT mag, db;
+  RMSLogReader reader;
   QDateTime date;
-  long sec;
-  qreal usec;
-  qreal rate;
-  std::vector<std::string> fields;
-  std::istringstream iss(this->line);
-
-  // Description line allows commas and stuff
-  if (line.compare(0, 5, "DESC,") == 0) {
-    emit titleChanged(QString(line.c_str() + 5));
-    return true;
+
+  if (!reader.open(path)) {
+    QMessageBox::critical(
+          this,
+          "Open power log",
+          "Failed to open power log: " + reader.getError());
+    return false;
   }
 
-  for (std::string token; std::getline(iss, token, ','); )
-    fields.push_back(std::move(token));
+  if (!userClear(
+        "Opening a power log will overwrite the current plot. "
+        "Do you want to save it first?"))
+    return false;
 
-  if (fields.size() == 2) {
-    if (fields[0] == "RATE") {
-      if (sscanf(fields[1].c_str(), "%lf", &rate) < 1)
-        return false;
+  // A log replaces live data until the capture is started again
+  if (ui->stopButton->isChecked())
+    ui->stopButton->setChecked(false);
 
-      this->setSampleRate(rate);
-    } else {
-      return false;
-    }
-  } else if (fields.size() == 4) {
-    if (sscanf(fields[0].c_str(), "%ld", &sec) < 1)
-      return false;
-    if (sscanf(fields[1].c_str(), "%lf", &usec) < 1)
-      return false;
-    if (sscanf(fields[2].c_str(), "%e", &mag) < 1)
-      return false;
-    if (sscanf(fields[3].c_str(), "%g", &db) < 1)
-      return false;
+  if (!m_haveLog)
+    m_liveRate = this->rate;
+  m_haveLog = true;
 
-    this->feed(SCAST(qreal, sec) + usec, SCAST(qreal, mag));
+  this->onValueChanged(0);
 
-    return true;
-  }
+  bool blocked = ui->intSpin->blockSignals(true);
+  ui->intSpin->setValue(1);
+  ui->intSpin->blockSignals(blocked);
+
+  reader.load(m_history);
+
+  while (m_history.size() / m_decimation > RMS_VIEW_TAB_MAX_DISPLAY)
+    m_decimation *= 2;
+
+  this->rate  = reader.getRate();
+  this->first = reader.getFirstTimeStamp();
+  this->last  = reader.getLastTimeStamp();
+  this->rebuildData();
+  this->setSampleRate(this->rate);
+
+  date.setSecsSinceEpoch(SCAST(qint64, this->first));
+  this->ui->sinceLabel->setText("Since: " + date.toString());
+  date.setSecsSinceEpoch(SCAST(qint64, this->last));
+  this->ui->lastLabel->setText("Last: " + date.toString());
+
+  if (!this->ui->dateTimeEdit->isEnabled())
+    this->ui->dateTimeEdit->setDateTime(
+          QDateTime::fromSecsSinceEpoch(SCAST(qint64, this->first)));
+  this->refreshUi();
 
-  return false;
+  m_dirty = true;
+  this->refreshWaveform();
+  this->onResetZoom();
+
+  return true;
 }
 
+// Redraws are paced by the timer, not by the arrival of measures
 void
-RMSViewTab::processSocketData(void)
+RMSViewTab::refreshWaveform(void)
 {
-  char c;
+  if (!m_dirty)
+    return;
 
-  while (this->socket->bytesAvailable() > 0) {
-    if (this->socket->read(&c, 1) < 1) {
-      this->disconnectSocket();
-      return;
-    }
+  this->ui->waveform->refreshData();
+  if (this->ui->autoFitButton->isChecked())
+    this->fitVertical();
+  this->ui->waveform->invalidate();
 
-    if (c == '\n') {
-      this->parseLine();
-      this->line.clear();
-    } else if (isprint(c)) {
-      this->line += c;
-      if (this->line.size() >= MAX_LINE_SIZE) {
-        this->line.clear();
-        this->disconnect();
-        QMessageBox::critical(
-              this,
-              "Max line size exceeded",
-              "Remote peer attempted to flood us. Preventively disconnected");
-      }
-    }
+  m_dirty = false;
+}
+
+void
+RMSViewTab::drainStream(void)
+{
+  RMSStreamInfo info = m_stream->getInfo();
+
+  if (info.titleSerial != m_titleSerial) {
+    m_titleSerial = info.titleSerial;
+    emit titleChanged(info.title);
+  }
+
+  if (info.rateSerial != m_rateSerial) {
+    m_rateSerial = info.rateSerial;
+    this->setSampleRate(info.rate);
   }
+
+  if (m_stream->takeMeasures(m_measures))
+    for (auto const &m : m_measures)
+      this->feed(m.timeStamp, m.mag);
+
+  if (!info.online)
+    this->detachStream();
 }
 
 void
-RMSViewTab::disconnectSocket(void)
+RMSViewTab::detachStream(void)
 {
-  if (this->socket != nullptr) {
-    this->socket->close();
-    delete this->socket;
-    this->socket = nullptr;
+  if (m_stream != nullptr) {
+    m_stream->setKeepMeasures(false);
+    m_stream = nullptr;
 
     this->ui->stopButton->setEnabled(false);
     this->ui->stopButton->setChecked(false);
@@ -506,14 +583,6 @@ RMSViewTab::connectAll(void)
         this,
         SLOT(onTimeout()));
 
-  if (socket != nullptr){
-    connect(
-          this->socket,
-          SIGNAL(disconnected()),
-          this,
-          SLOT(onSocketDisconnected()));
-  }
-
   connect(
         this->ui->stopButton,
         SIGNAL(toggled(bool)),
@@ -538,6 +607,12 @@ RMSViewTab::connectAll(void)
         this,
         SLOT(onSave()));
 
+  connect(
+        this->ui->openButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onOpen()));
+
   connect(
         this->ui->resetButton,
         SIGNAL(clicked(bool)),
@@ -601,7 +676,9 @@ RMSViewTab::running() const
 
 RMSViewTab::~RMSViewTab()
 {
-  this->disconnectSocket();
+  if (m_stream != nullptr)
+    m_stream->setKeepMeasures(false);
+
   delete ui;
 }
 
@@ -639,6 +716,12 @@ RMSViewTab::setAutoFit(bool enabled)
   toggleModes(ui->autoFitButton);
 }
 
+void
+RMSViewTab::setHistoryMemory(size_t bytes)
+{
+  m_history.setMemoryLimit(bytes);
+}
+
 void
 RMSViewTab::setAutoScroll(bool enabled)
 {
@@ -662,13 +745,30 @@ RMSViewTab::onSave(void)
     this->saveToMatlab(fileName);
 }
 
+void
+RMSViewTab::onOpen(void)
+{
+  QString fileName =
+      QFileDialog::getOpenFileName(
+        this,
+        "Open power log",
+        QString(),
+        "SigDigger power logs (*." RMS_LOG_EXTENSION ");;All files (*)");
+
+  if (fileName.size() > 0)
+    this->loadLog(fileName);
+}
+
 void
 RMSViewTab::onToggleStartStop(void)
 {
   if (m_running != ui->stopButton->isChecked()) {
     if (m_running) {
       // Disconnect
-      this->disconnectSocket();
+      if (m_stream != nullptr) {
+        this->detachStream();
+        emit closeRequested();
+      }
     } else {
       // Starting
       if (!userClear(
@@ -677,6 +777,11 @@ RMSViewTab::onToggleStartStop(void)
         return;
       }
 
+      if (m_haveLog) {
+        m_haveLog = false;
+        this->setSampleRate(m_liveRate);
+      }
+
       onValueChanged(0);
     }
     m_running = ui->stopButton->isChecked();
@@ -687,8 +792,10 @@ RMSViewTab::onToggleStartStop(void)
 void
 RMSViewTab::onTimeout(void)
 {
-  if (this->socket != nullptr)
-    this->processSocketData();
+  if (m_stream != nullptr)
+    this->drainStream();
+
+  this->refreshWaveform();
 }
 
 void
@@ -708,13 +815,6 @@ RMSViewTab::onResetZoom(void)
   this->ui->waveform->zoomHorizontalReset();
 }
 
-void
-RMSViewTab::onSocketDisconnected(void)
-{
-  this->socket = nullptr;
-  this->disconnectSocket();
-}
-
 void
 RMSViewTab::onValueChanged(int)
 {
@@ -723,6 +823,9 @@ RMSViewTab::onValueChanged(int)
   this->ui->sinceLabel->setText("Since: N/A");
   this->ui->lastLabel->setText("Last: N/A");
   this->data.clear();
+  m_history.clear();
+  m_decimation = 1;
+  m_dirty = false;
   this->ui->waveform->setSampleRate(rate / this->ui->intSpin->value());
   this->ui->waveform->refreshData();
   if (this->ui->autoFitButton->isChecked())
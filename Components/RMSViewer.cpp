@@ -19,9 +19,18 @@
 
 #include <RMSViewer.h>
 #include <RMSViewTab.h>
+#include <RMSStream.h>
+#include <RMSIngestWorker.h>
 #include <QMessageBox>
+#include <QTcpSocket>
+#include <QTabBar>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <RMSLog.h>
 #include <RMSViewerSettingsDialog.h>
 #include <QMessageBox>
+#include <sigutils/types.h>
+#include <algorithm>
 
 #include "ui_RMSViewer.h"
 
@@ -31,32 +40,143 @@ RMSViewer::RMSViewer(QWidget *parent) :
   QMainWindow(parent),
   ui(new Ui::RMSViewer)
 {
+  int i, threads = std::max(
+        1,
+        std::min(QThread::idealThreadCount(), RMS_VIEWER_MAX_INGEST_THREADS));
+
   ui->setupUi(this);
 
   this->settingsDialog = new RMSViewerSettingsDialog(this);
   this->settingsDialog->setWindowTitle("TCP server settings");
+
+  // The summary is always there
+  this->ui->serverTabWidget->tabBar()->setTabButton(
+        0,
+        QTabBar::RightSide,
+        nullptr);
+  this->ui->serverTabWidget->tabBar()->setTabButton(
+        0,
+        QTabBar::LeftSide,
+        nullptr);
+
+  for (i = 0; i < threads; ++i) {
+    QThread *thread = new QThread();
+    RMSIngestWorker *worker = new RMSIngestWorker();
+
+    worker->moveToThread(thread);
+    thread->start();
+
+    this->ingestThreads.push_back(thread);
+    this->ingestWorkers.push_back(worker);
+  }
+
+  this->summaryTimer.start(RMS_VIEWER_SUMMARY_INTERVAL_MS);
+
   this->connectAll();
 }
 
 void
-RMSViewer::openNewView(QTcpSocket *socket)
+RMSViewer::addStream(QTcpSocket *socket)
 {
-  RMSViewTab *tab = new RMSViewTab(this, socket);
+  RMSStream *stream = new RMSStream(socket->peerAddress().toString());
+  RMSIngestWorker *worker = this->ingestWorkers[this->nextWorker];
+  QThread *thread = this->ingestThreads[this->nextWorker];
+  int row = static_cast<int>(this->streams.size());
+  int i;
+
+  this->nextWorker = (this->nextWorker + 1) % this->ingestWorkers.size();
+
+  this->streams.push_back(stream);
+  this->owners[stream] = worker;
+
+  this->ui->summaryTable->insertRow(row);
+  for (i = 0; i < this->ui->summaryTable->columnCount(); ++i)
+    this->ui->summaryTable->setItem(row, i, new QTableWidgetItem());
+  this->refreshSummaryRow(row);
+
+  // From now on, the socket belongs to the worker
+  socket->setParent(nullptr);
+  socket->moveToThread(thread);
+  QMetaObject::invokeMethod(
+        worker,
+        "onAdopt",
+        Qt::QueuedConnection,
+        Q_ARG(QTcpSocket *, socket),
+        Q_ARG(SigDigger::RMSStream *, stream));
 
-  int ndx = this->ui->serverTabWidget->addTab(
-        tab,
-        "Power graph [" + socket->peerAddress().toString() + "]");
+  this->ui->stackedWidget->setCurrentIndex(0);
+}
 
-  connect(
-        tab,
-        SIGNAL(titleChanged(QString)),
-        this,
-        SLOT(onTitleChanged(QString)));
+void
+RMSViewer::openView(RMSStream *stream)
+{
+  RMSViewTab *tab = this->views.value(stream, nullptr);
+  int ndx;
+
+  if (tab == nullptr) {
+    tab = new RMSViewTab(this, stream);
+
+    ndx = this->ui->serverTabWidget->addTab(
+          tab,
+          "Power graph [" + stream->getInfo().peer + "]");
+
+    connect(
+          tab,
+          SIGNAL(titleChanged(QString)),
+          this,
+          SLOT(onTitleChanged(QString)));
+
+    connect(
+          tab,
+          SIGNAL(closeRequested(void)),
+          this,
+          SLOT(onViewCloseRequested(void)));
+
+    this->views[stream] = tab;
+  } else {
+    ndx = this->ui->serverTabWidget->indexOf(tab);
+  }
 
-  this->ui->stackedWidget->setCurrentIndex(0);
   this->ui->serverTabWidget->setCurrentIndex(ndx);
 }
 
+RMSStream *
+RMSViewer::findStream(RMSViewTab *tab) const
+{
+  for (auto it = this->views.begin(); it != this->views.end(); ++it)
+    if (it.value() == tab)
+      return it.key();
+
+  return nullptr;
+}
+
+void
+RMSViewer::refreshSummaryRow(int row)
+{
+  RMSStreamInfo info = this->streams[static_cast<size_t>(row)]->getInfo();
+  QTableWidget *table = this->ui->summaryTable;
+
+  table->item(row, 0)->setText(info.peer);
+  table->item(row, 1)->setText(info.title);
+  table->item(row, 2)->setText(
+        info.rate > 0 ? QString::number(info.rate) + " sps" : "N/A");
+
+  if (info.count > 0) {
+    table->item(row, 3)->setText(
+          QString::number(SU_POWER_DB_RAW(info.last), 'f', 2));
+    table->item(row, 4)->setText(
+          QString::number(SU_POWER_DB_RAW(info.min), 'f', 2)
+          + " / "
+          + QString::number(SU_POWER_DB_RAW(info.max), 'f', 2));
+  } else {
+    table->item(row, 3)->setText("N/A");
+    table->item(row, 4)->setText("N/A");
+  }
+
+  table->item(row, 5)->setText(QString::number(info.count));
+  table->item(row, 6)->setText(info.online ? "Online" : "Offline");
+}
+
 bool
 RMSViewer::haveAddrData(void) const
 {
@@ -167,11 +287,51 @@ RMSViewer::connectAll(void)
         SIGNAL(tabCloseRequested(int)),
         this,
         SLOT(onTabCloseRequested(int)));
+
+  connect(
+        this->ui->summaryTable,
+        SIGNAL(cellDoubleClicked(int, int)),
+        this,
+        SLOT(onSummaryActivated(int, int)));
+
+  connect(
+        &this->summaryTimer,
+        SIGNAL(timeout(void)),
+        this,
+        SLOT(onRefreshSummary(void)));
+
+  connect(
+        this->ui->actionPurge,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onPurge(void)));
+
+  connect(
+        this->ui->actionOpenLog,
+        SIGNAL(triggered(bool)),
+        this,
+        SLOT(onOpenLog(void)));
 }
 
 RMSViewer::~RMSViewer()
 {
+  size_t i;
+
+  this->server.close();
+
+  // Workers go first, so that no one feeds the streams anymore
+  for (i = 0; i < this->ingestThreads.size(); ++i) {
+    this->ingestThreads[i]->quit();
+    this->ingestThreads[i]->wait();
+    delete this->ingestWorkers[i];
+    delete this->ingestThreads[i];
+  }
+
+  // Then the tabs, which still refer to their streams
   delete ui;
+
+  for (auto stream : this->streams)
+    delete stream;
 }
 
 /////////////////////////////////// Slots //////////////////////////////////////
@@ -193,7 +353,7 @@ RMSViewer::onNewConnection(void)
   QTcpSocket *socket;
 
   while ((socket = this->server.nextPendingConnection()) != nullptr)
-    this->openNewView(socket);
+    this->addStream(socket);
 }
 
 void
@@ -247,19 +407,107 @@ RMSViewer::onTitleChanged(QString title)
 void
 RMSViewer::onTabCloseRequested(int ndx)
 {
+  QWidget *widget = this->ui->serverTabWidget->widget(ndx);
   QString name = this->ui->serverTabWidget->tabText(ndx);
 
+  if (widget == this->ui->summaryTab)
+    return;
+
   if (QMessageBox::question(
         this,
         "Close tab",
         "You are about to close tab " + name + ". This will "
-        "close the connection and clear unsaved data. Are you sure?") ==
+        "clear unsaved data, but the connection will remain open and "
+        "the plot can be opened again from the stream list. "
+        "Are you sure?") ==
       QMessageBox::Yes) {
-    QWidget *widget = this->ui->serverTabWidget->widget(ndx);
+    this->views.remove(
+          this->findStream(static_cast<RMSViewTab *>(widget)));
     this->ui->serverTabWidget->removeTab(ndx);
     delete widget;
+  }
+}
+
+void
+RMSViewer::onViewCloseRequested(void)
+{
+  RMSViewTab *tab = static_cast<RMSViewTab *>(this->sender());
+  RMSStream *stream = this->findStream(tab);
+
+  if (stream != nullptr)
+    QMetaObject::invokeMethod(
+          this->owners[stream],
+          "onClose",
+          Qt::QueuedConnection,
+          Q_ARG(SigDigger::RMSStream *, stream));
+}
+
+void
+RMSViewer::onSummaryActivated(int row, int)
+{
+  if (row >= 0 && static_cast<size_t>(row) < this->streams.size())
+    this->openView(this->streams[static_cast<size_t>(row)]);
+}
 
-    if (this->ui->serverTabWidget->count() == 0)
-      this->ui->stackedWidget->setCurrentIndex(1);
+void
+RMSViewer::onRefreshSummary(void)
+{
+  int i;
+
+  // Do not bother while nobody looks at it
+  if (this->ui->serverTabWidget->currentWidget() != this->ui->summaryTab)
+    return;
+
+  for (i = 0; i < this->ui->summaryTable->rowCount(); ++i)
+    this->refreshSummaryRow(i);
+}
+
+void
+RMSViewer::onPurge(void)
+{
+  size_t i = 0;
+
+  // Offline streams are not touched by the workers anymore. Those that
+  // are still plotted stay until their tab is closed.
+  while (i < this->streams.size()) {
+    RMSStream *stream = this->streams[i];
+
+    if (!stream->getInfo().online && !this->views.contains(stream)) {
+      this->streams.erase(this->streams.begin() + static_cast<long>(i));
+      this->owners.remove(stream);
+      this->ui->summaryTable->removeRow(static_cast<int>(i));
+      delete stream;
+    } else {
+      ++i;
+    }
   }
 }
+
+void
+RMSViewer::onOpenLog(void)
+{
+  QString fileName =
+      QFileDialog::getOpenFileName(
+        this,
+        "Open power log",
+        QString(),
+        "SigDigger power logs (*." RMS_LOG_EXTENSION ");;All files (*)");
+  RMSViewTab *tab;
+  int ndx;
+
+  if (fileName.size() == 0)
+    return;
+
+  tab = new RMSViewTab(this, nullptr);
+  if (!tab->loadLog(fileName)) {
+    delete tab;
+    return;
+  }
+
+  ndx = this->ui->serverTabWidget->addTab(
+        tab,
+        "Log [" + QFileInfo(fileName).fileName() + "]");
+
+  this->ui->stackedWidget->setCurrentIndex(0);
+  this->ui->serverTabWidget->setCurrentIndex(ndx);
+}
@@ -1716,9 +1716,11 @@ TimeWindow::onCarrierSlidersChanged()
 }
 
 void
-TimeWindow::onHistogramSamples(const float *samples, unsigned int size)
+TimeWindow::onHistogramSamples(QVector<float> samples)
 {
-  m_histogramDialog->feed(samples, size);
+  m_histogramDialog->feed(
+        samples.constData(),
+        static_cast<unsigned int>(samples.size()));
 }
 
 void
@@ -1735,9 +1737,9 @@ TimeWindow::onTriggerHistogram()
 
   connect(
         hf,
-        SIGNAL(data(const float *, unsigned int)),
+        SIGNAL(data(QVector<float>)),
         this,
-        SLOT(onHistogramSamples(const float *, unsigned int)));
+        SLOT(onHistogramSamples(QVector<float>)));
 
   m_histogramDialog->reset();
   m_histogramDialog->setProperties(props);
@@ -325,6 +325,12 @@ AudioProcessor::connectAudioFileSaver()
         this,
         SIGNAL(recSaveRate(qreal)));
 
+  connect(
+        m_audioFileSaver,
+        SIGNAL(metricsUpdated()),
+        this,
+        SIGNAL(recMetrics()));
+
   connect(
         m_audioFileSaver,
         SIGNAL(commit()),
@@ -597,6 +603,14 @@ AudioProcessor::getSaveSize() const
   return m_audioFileSaver == nullptr ? 0 : m_audioFileSaver->getSize();
 }
 
+GenericDataSaverMetrics
+AudioProcessor::getSaveMetrics() const
+{
+  return m_audioFileSaver == nullptr
+      ? GenericDataSaverMetrics()
+      : m_audioFileSaver->getMetrics();
+}
+
 bool
 AudioProcessor::startRecording(QString path)
 {
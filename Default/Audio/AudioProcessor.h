@@ -123,6 +123,7 @@ namespace SigDigger {
     bool isRecording() const;
     bool isOpened() const;
     size_t getSaveSize() const;
+    GenericDataSaverMetrics getSaveMetrics() const;
 
   signals:
     void audioClosed();
@@ -132,6 +133,7 @@ namespace SigDigger {
     void recStopped();
     void recSwamped();
     void recSaveRate(qreal);
+    void recMetrics();
     void recCommit();
 
     void orbitReport(Suscan::InspectorMessage const &);
@@ -322,6 +322,12 @@ AudioWidget::connectAll()
         this,
         SLOT(onAudioSaveRate(qreal)));
 
+  connect(
+        m_processor,
+        SIGNAL(recMetrics()),
+        this,
+        SLOT(onAudioSaveMetrics()));
+
   connect(
         m_processor,
         SIGNAL(recCommit()),
@@ -1230,6 +1236,13 @@ AudioWidget::onAudioSaveRate(qreal)
   refreshDiskUsage();
 }
 
+void
+AudioWidget::onAudioSaveMetrics()
+{
+  m_ui->captureSizeLabel->setToolTip(
+        m_processor->getSaveMetrics().toString());
+}
+
 void
 AudioWidget::onAudioCommit()
 {
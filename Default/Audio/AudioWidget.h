@@ -187,6 +187,7 @@ namespace SigDigger {
     void onAudioSaveError();
     void onAudioSaveSwamped();
     void onAudioSaveRate(qreal rate);
+    void onAudioSaveMetrics();
     void onAudioCommit();
 
     // Analyzer slots
@@ -0,0 +1,274 @@
+//
+//    FACProcessorWorker.cpp: Fast autocorrelation off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "FACProcessorWorker.h"
+#include <FFTWPlanCache.h>
+#include <sigutils/log.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace SigDigger;
+
+FACProcessorWorker::FACProcessorWorker(QObject *parent) : QObject(parent)
+{
+  connect(
+        this,
+        SIGNAL(dataPending(void)),
+        this,
+        SLOT(process(void)),
+        Qt::QueuedConnection);
+}
+
+FACProcessorWorker::~FACProcessorWorker()
+{
+  if (this->buffer != nullptr)
+    SU_FFTW(_free)(this->buffer);
+}
+
+void
+FACProcessorWorker::configure(int size)
+{
+  FFTWPlanCache *cache = FFTWPlanCache::instance();
+
+  if (this->buffer != nullptr)
+    SU_FFTW(_free)(this->buffer);
+
+  this->buffer = static_cast<SUCOMPLEX *>(
+        SU_FFTW(_malloc)(static_cast<size_t>(size) * sizeof(SUCOMPLEX)));
+
+  if (this->buffer == nullptr) {
+    SU_ERROR("Cannot allocate FAC buffer of size %d\n", size);
+    this->size = 0;
+    return;
+  }
+
+  // Plan now, so that processBlock() only finds them in the cache
+  if (cache->get(size, FFTW_FORWARD, this->buffer, this->buffer) == nullptr
+      || cache->get(size, FFTW_BACKWARD, this->buffer, this->buffer) == nullptr) {
+    SU_ERROR("Cannot create FFT plans for FAC of size %d\n", size);
+    this->size = 0;
+    return;
+  }
+
+  this->size = size;
+  this->window.resize(static_cast<size_t>(size));
+  this->fac.assign(static_cast<size_t>(size / 2), 0);
+  this->filled = 0;
+  this->base   = 0;
+  this->max    = -INFINITY;
+  this->progress = 0;
+}
+
+void
+FACProcessorWorker::processBlock(
+    FACProcessorParams const &params,
+    FACProcessorResult &result)
+{
+  FFTWPlanCache *cache = FFTWPlanCache::instance();
+  SUCOMPLEX *bufData = this->buffer;
+  SUCOMPLEX *facData = this->fac.data();
+  size_t bufLen = this->window.size();
+  size_t i;
+
+  memcpy(bufData, this->window.data(), bufLen * sizeof(SUCOMPLEX));
+
+  SU_FFTW(_execute_dft)(
+        cache->get(this->size, FFTW_FORWARD, bufData, bufData),
+        reinterpret_cast<SU_FFTW(_complex) *>(bufData),
+        reinterpret_cast<SU_FFTW(_complex) *>(bufData));
+
+  for (i = 0; i < bufLen; ++i)
+    bufData[i] *= SU_C_CONJ(bufData[i]);
+
+  SU_FFTW(_execute_dft)(
+        cache->get(this->size, FFTW_BACKWARD, bufData, bufData),
+        reinterpret_cast<SU_FFTW(_complex) *>(bufData),
+        reinterpret_cast<SU_FFTW(_complex) *>(bufData));
+
+  result.localMax    = -INFINITY;
+  result.localMaxPos = 0;
+  result.power       = 0;
+  result.powerCount  = 0;
+
+  for (i = 0; i < bufLen / 2; ++i) {
+    bufData[i] = SU_C_ABS(bufData[i]);
+
+    if (params.peakStart <= SCAST(qint64, i)
+        && SCAST(qint64, i) < params.peakEnd) {
+      if (SU_C_REAL(bufData[i]) > result.localMax) {
+        result.localMax = SU_C_REAL(bufData[i]);
+        result.localMaxPos = i;
+      } else {
+        result.power += SU_C_REAL(bufData[i]) * SU_C_REAL(bufData[i]);
+        ++result.powerCount;
+      }
+
+      if (SU_C_REAL(bufData[i]) > this->max)
+        this->max = SU_C_REAL(bufData[i]);
+    }
+  }
+
+  for (i = 0; i < bufLen / 2; ++i)
+    SU_SPLPF_FEED(facData[i], SU_C_REAL(bufData[i]) / this->max, params.alpha);
+}
+
+void
+FACProcessorWorker::publish(FACProcessorResult &block)
+{
+  bool notify = false;
+
+  this->resultMutex.lock();
+
+  this->result.fac.assign(this->fac.begin(), this->fac.end());
+  this->result.localMax    = block.localMax;
+  this->result.localMaxPos = block.localMaxPos;
+  this->result.power       = block.power;
+  this->result.powerCount  = block.powerCount;
+
+  if (!this->announced) {
+    this->announced = true;
+    notify = true;
+  }
+
+  this->resultMutex.unlock();
+
+  if (notify)
+    emit resultReady();
+}
+
+void
+FACProcessorWorker::push(
+    const SUCOMPLEX *data,
+    unsigned int size,
+    FACProcessorParams const &params)
+{
+  bool notify = false;
+
+  this->inputMutex.lock();
+
+  if (this->pending.size() + size > FAC_PROCESSOR_WORKER_MAX_PENDING) {
+    if (this->inputDropped == 0)
+      SU_WARNING("FAC worker cannot keep up, dropping samples\n");
+    this->inputDropped += size;
+  } else {
+    this->pending.insert(this->pending.end(), data, data + size);
+  }
+
+  this->pendingParams = params;
+
+  if (!this->scheduled) {
+    this->scheduled = true;
+    notify = true;
+  }
+
+  this->inputMutex.unlock();
+
+  if (notify)
+    emit dataPending();
+}
+
+void
+FACProcessorWorker::reset(void)
+{
+  QMutexLocker locker(&this->inputMutex);
+
+  this->pending.clear();
+  this->resetPending = true;
+}
+
+bool
+FACProcessorWorker::takeResult(FACProcessorResult &dest)
+{
+  QMutexLocker locker(&this->resultMutex);
+  bool haveResult = this->announced;
+
+  if (haveResult)
+    std::swap(dest, this->result);
+
+  this->announced = false;
+
+  return haveResult;
+}
+
+///////////////////////////////// Slots ////////////////////////////////////////
+void
+FACProcessorWorker::process(void)
+{
+  FACProcessorParams params;
+  FACProcessorResult block;
+  const SUCOMPLEX *data;
+  size_t size, got, hop;
+  bool reset;
+  bool haveBlock = false;
+
+  this->inputMutex.lock();
+  this->work.clear();
+  std::swap(this->work, this->pending);
+  params = this->pendingParams;
+  reset  = this->resetPending;
+  this->resetPending = false;
+  this->scheduled = false;
+  this->inputMutex.unlock();
+
+  if (reset || params.size != this->size)
+    this->configure(params.size);
+
+  if (this->size == 0 || this->work.empty())
+    return;
+
+  hop = static_cast<size_t>(this->size);
+  if (params.overlap > 0 && params.overlap < this->size)
+    hop -= static_cast<size_t>(params.overlap);
+
+  data = this->work.data();
+  size = this->work.size();
+
+  while (size > 0) {
+    got = std::min(size, this->window.size() - this->filled);
+
+    memcpy(
+          this->window.data() + this->filled,
+          data,
+          got * sizeof(SUCOMPLEX));
+    this->filled += got;
+
+    if (this->filled == this->window.size()) {
+      this->processBlock(params, block);
+      haveBlock = true;
+
+      // Keep the tail of this block as the head of the next one
+      this->base = this->window.size() - hop;
+      if (this->base > 0)
+        memmove(
+              this->window.data(),
+              this->window.data() + hop,
+              this->base * sizeof(SUCOMPLEX));
+      this->filled = this->base;
+    }
+
+    size -= got;
+    data += got;
+  }
+
+  this->progress = static_cast<int>(
+        100 * (this->filled - this->base) / (this->window.size() - this->base));
+
+  if (haveBlock)
+    this->publish(block);
+}
@@ -0,0 +1,114 @@
+//
+//    FACProcessorWorker.h: Fast autocorrelation off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef FACPROCESSORWORKER_H
+#define FACPROCESSORWORKER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <vector>
+#include <sigutils/types.h>
+
+// Samples waiting for the worker. Beyond this, new samples are dropped.
+#define FAC_PROCESSOR_WORKER_MAX_PENDING (1 << 22)
+
+namespace SigDigger {
+  struct FACProcessorParams {
+    int     size    = 1 << 16; // Block size (FFT length)
+    int     overlap = 0;       // Samples shared by consecutive blocks
+    SUFLOAT alpha   = 1;       // Averaging coefficient
+    qint64  peakStart = 0;     // Peak search range (visible lags)
+    qint64  peakEnd   = 0;
+  };
+
+  struct FACProcessorResult {
+    std::vector<SUCOMPLEX> fac; // Averaged, normalized FAC (size / 2)
+    SUFLOAT localMax   = -INFINITY;
+    size_t  localMaxPos = 0;
+    SUFLOAT power      = 0;
+    unsigned int powerCount = 0;
+  };
+
+  //
+  // Runs FFT -> |X|^2 -> IFFT and the peak search for FACTab. Plans come
+  // from FFTWPlanCache, so going back and forth in the size combo does not
+  // replan. Consecutive blocks may overlap, which gives more averages per
+  // second of signal.
+  //
+  class FACProcessorWorker : public QObject
+  {
+    Q_OBJECT
+
+    // Input side, shared with the GUI thread
+    QMutex inputMutex;
+    std::vector<SUCOMPLEX> pending;
+    FACProcessorParams pendingParams;
+    bool scheduled = false;
+    bool resetPending = true;
+    quint64 inputDropped = 0;
+
+    // Result side, shared with the GUI thread
+    QMutex resultMutex;
+    FACProcessorResult result;
+    bool announced = false;
+    QAtomicInteger<int> progress;
+
+    // Worker-only state
+    SUCOMPLEX *buffer = nullptr;
+    std::vector<SUCOMPLEX> work;
+    std::vector<SUCOMPLEX> window;
+    std::vector<SUCOMPLEX> fac;
+    size_t filled = 0;
+    size_t base = 0;
+    int size = 0;
+    SUFLOAT max = -INFINITY;
+
+    void configure(int size);
+    void processBlock(FACProcessorParams const &, FACProcessorResult &);
+    void publish(FACProcessorResult &);
+
+  public:
+    explicit FACProcessorWorker(QObject *parent = nullptr);
+    ~FACProcessorWorker() override;
+
+    // Called from the GUI thread
+    void push(
+        const SUCOMPLEX *data,
+        unsigned int size,
+        FACProcessorParams const &params);
+    void reset(void);
+    bool takeResult(FACProcessorResult &);
+
+    inline int
+    getProgress(void) const
+    {
+      return this->progress.loadAcquire();
+    }
+
+  signals:
+    void dataPending(void);
+    void resultReady(void);
+
+  public slots:
+    void process(void);
+  };
+}
+
+#endif // FACPROCESSORWORKER_H
@@ -20,15 +20,13 @@
 #include "FACTab.h"
 #include "ui_FACTab.h"
 #include <SuWidgetsHelpers.h>
+#include <QThread>
 
 using namespace SigDigger;
 
 void
 FACTab::resizeFAC(int size)
 {
-  this->buffer.resize(static_cast<size_t>(size));
-  this->buffer.assign(this->buffer.size(), 0);
-
   this->fac.resize(static_cast<size_t>(size / 2));
   this->fac.assign(this->fac.size(), 0);
 
@@ -36,30 +34,11 @@ FACTab::resizeFAC(int size)
   this->ui->facWaveform->invalidate();
   this->adjustZoom = true;
 
-  this->min = INFINITY;
-  this->max = -INFINITY;
-
-  this->p = 0;
-
-  if (this->direct != nullptr)
-    SU_FFTW(_destroy_plan)(this->direct);
-
-  if (this->reverse != nullptr)
-    SU_FFTW(_destroy_plan)(this->reverse);
-
-  SU_ATTEMPT(this->direct = SU_FFTW(_plan_dft_1d)(
-        static_cast<int>(this->buffer.size()),
-        reinterpret_cast<SU_FFTW(_complex) *>(this->buffer.data()),
-        reinterpret_cast<SU_FFTW(_complex) *>(this->buffer.data()),
-        FFTW_FORWARD,
-        FFTW_ESTIMATE));
+  this->params.size = size;
+  this->onChangeOverlap();
+  this->facWorker->reset();
 
-  SU_ATTEMPT(this->reverse = SU_FFTW(_plan_dft_1d)(
-        static_cast<int>(this->buffer.size()),
-        reinterpret_cast<SU_FFTW(_complex) *>(this->buffer.data()),
-        reinterpret_cast<SU_FFTW(_complex) *>(this->buffer.data()),
-        FFTW_BACKWARD,
-        FFTW_ESTIMATE));
+  this->ui->progressBar->setValue(0);
 
   this->ui->facWaveform->zoomHorizontal(
         static_cast<qint64>(0),
@@ -74,6 +53,24 @@ FACTab::FACTab(QWidget *parent) :
 
   ui->setupUi(this);
 
+  this->facThread = new QThread();
+  this->facWorker = new FACProcessorWorker();
+  this->facWorker->moveToThread(this->facThread);
+
+  connect(
+        this->facThread,
+        &QThread::finished,
+        this->facWorker,
+        &QObject::deleteLater);
+
+  connect(
+        this->facThread,
+        &QThread::finished,
+        this->facThread,
+        &QObject::deleteLater);
+
+  this->facThread->start();
+
   this->connectAll();
 
   for (i = 9; i < 20; ++i)
@@ -83,6 +80,10 @@ FACTab::FACTab(QWidget *parent) :
 
   this->ui->facSizeCombo->setCurrentIndex(16 - 9);
 
+  this->ui->overlapCombo->addItem("No overlap", QVariant::fromValue<int>(0));
+  this->ui->overlapCombo->addItem("50% overlap", QVariant::fromValue<int>(2));
+  this->ui->overlapCombo->addItem("75% overlap", QVariant::fromValue<int>(4));
+
   this->ui->facWaveform->setRealComponent(true);
   this->ui->facWaveform->setEnableFeedback(false);
   this->ui->facWaveform->setAutoFitToEnvelope(false);
@@ -101,13 +102,10 @@ FACTab::FACTab(QWidget *parent) :
 
 FACTab::~FACTab()
 {
-  delete ui;
+  if (this->facThread != nullptr)
+    this->facThread->quit();
 
-  if (this->direct != nullptr)
-    SU_FFTW(_destroy_plan)(this->direct);
-
-  if (this->reverse != nullptr)
-    SU_FFTW(_destroy_plan)(this->reverse);
+  delete ui;
 }
 
 void
@@ -148,6 +146,18 @@ FACTab::connectAll(void)
         SIGNAL(valueChanged(int)),
         this,
         SLOT(onAdjustAveraging(void)));
+
+  connect(
+        this->ui->overlapCombo,
+        SIGNAL(activated(int)),
+        this,
+        SLOT(onChangeOverlap(void)));
+
+  connect(
+        this->facWorker,
+        SIGNAL(resultReady(void)),
+        this,
+        SLOT(onFACResult(void)));
 }
 
 void
@@ -163,8 +173,8 @@ FACTab::setSampleRate(qreal fs)
 
   this->onUnitsChanged();
 
-  this->buffer.assign(this->buffer.size(), 0);
   this->fac.assign(this->fac.size(), 0);
+  this->facWorker->reset();
 }
 
 void
@@ -180,108 +190,26 @@ FACTab::setColorConfig(ColorConfig const &cfg)
 void
 FACTab::feed(const SUCOMPLEX *data, unsigned int size)
 {
-  size_t got, i;
-  SUCOMPLEX *bufData = this->buffer.data();
-  SUCOMPLEX *facData = this->fac.data();
-  QList<WaveMarker> markers;
-  WaveMarker marker;
-  size_t bufLen = this->buffer.size();
-  bool redraw = false;
-  SUFLOAT localMax = -INFINITY;
-  SUFLOAT power = 0;
-  unsigned int powerCount = 0;
-  size_t localMaxPos = 0;
   struct timeval tv, diff;
-  qint64 currStart = this->ui->facWaveform->getSampleStart();
-  qint64 currEnd   = this->ui->facWaveform->getSampleEnd();
-
-  while (size > 0) {
-    got = size;
-    if (got > (bufLen - this->p))
-      got = bufLen - this->p;
-
-    memcpy(bufData + this->p, data, got * sizeof(SUCOMPLEX));
-    p    += got;
-
-    if (p == bufLen) {
-      p = 0;
-
-      gettimeofday(&this->lastRefresh, nullptr);
 
-      SU_FFTW(_execute(this->direct));
+  this->params.peakStart = this->ui->facWaveform->getSampleStart();
+  this->params.peakEnd   = this->ui->facWaveform->getSampleEnd();
 
-      for (i = 0; i < bufLen; ++i)
-        bufData[i] *= SU_C_CONJ(bufData[i]);
+  this->facWorker->push(data, size, this->params);
 
-      SU_FFTW(_execute(this->reverse));
+  gettimeofday(&tv, nullptr);
+  timersub(&tv, &this->lastRefresh, &diff);
 
-      for (i = 0; i < bufLen / 2; ++i) {
-        bufData[i] = SU_C_ABS(bufData[i]);
-
-        if (currStart <= SCAST(qint64, i) && SCAST(qint64, i) < currEnd) {
-          if (SU_C_REAL(bufData[i]) > localMax) {
-            localMax = SU_C_REAL(bufData[i]);
-            localMaxPos = i;
-          } else {
-            power += SU_C_REAL(bufData[i]) * SU_C_REAL(bufData[i]);
-            ++powerCount;
-          }
-
-          if (SU_C_REAL(bufData[i]) > this->max)
-            this->max = SU_C_REAL(bufData[i]);
-
-          if (SU_C_REAL(bufData[i]) < this->min)
-            this->min = SU_C_REAL(bufData[i]);
-        }
-      }
-
-      for (i = 0; i < bufLen / 2; ++i)
-        SU_SPLPF_FEED(facData[i], SU_C_REAL(bufData[i]) / this->max, this->alpha);
-
-      redraw = true;
-    }
-
-    size -= got;
-    data += got;
+  if (this->isVisible() && (diff.tv_sec > 0 || diff.tv_usec > 100000)) {
+    this->ui->progressBar->setValue(this->facWorker->getProgress());
+    this->lastRefresh = tv;
   }
+}
 
-  if (redraw) {
-    this->ui->progressBar->setValue(100);
-    this->ui->facWaveform->setData(&this->fac, true, true);
-
-    if (this->adjustZoom) {
-      this->ui->facWaveform->zoomVertical(
-            static_cast<qreal>(0),
-            static_cast<qreal>(1));
-
-      this->adjustZoom = false;
-    }
-
-    if (this->ui->detectPeaksCheck->isChecked()) {
-      if (!isinf(localMax) && powerCount > 0) {
-        SUFLOAT meanPower = SU_SQRT(power / powerCount);
-        SUFLOAT sigmas = localMax / meanPower;
-
-        if (sigmas > this->ui->sigmaSpin->value()) {
-          marker.below = false;
-          marker.x = localMaxPos;
-          marker.string =
-              "Max: " + QString::number(localMaxPos) +
-              " (" + QString::number(sigmas, 'g', 2) + "σ)";
-          markers.append(marker);
-        }
-      }
-    }
-    this->ui->facWaveform->setMarkerList(markers);
-  } else {
-    gettimeofday(&tv, nullptr);
-    timersub(&tv, &this->lastRefresh, &diff);
-
-    if (diff.tv_usec > 100000) {
-      this->ui->progressBar->setValue(100. * this->p / bufLen);
-      this->lastRefresh = tv;
-    }
-  }
+void
+FACTab::showEvent(QShowEvent *)
+{
+  this->onFACResult();
 }
 
 /////////////////////////////////////// Slots //////////////////////////////////
@@ -294,7 +222,7 @@ FACTab::onRecord(void)
 void
 FACTab::onAdjustAveraging(void)
 {
-  this->alpha =
+  this->params.alpha =
       1 - static_cast<SUFLOAT>(this->ui->averagingSlider->value() / 100.);
 }
 
@@ -323,3 +251,64 @@ FACTab::onChangePeakDetect()
 {
   this->ui->sigmaSpin->setEnabled(this->ui->detectPeaksCheck->isChecked());
 }
+
+void
+FACTab::onChangeOverlap(void)
+{
+  int divider = this->ui->overlapCombo->currentData().value<int>();
+
+  // Overlap is expressed as the fraction of the block that is kept
+  this->params.overlap =
+      divider > 0 ? this->params.size - this->params.size / divider : 0;
+}
+
+void
+FACTab::onFACResult(void)
+{
+  QList<WaveMarker> markers;
+  WaveMarker marker;
+
+  // Leave it in the worker. It keeps only the latest one, and we take it
+  // from showEvent().
+  if (!this->isVisible())
+    return;
+
+  if (!this->facWorker->takeResult(this->result))
+    return;
+
+  // Result of a previous FAC size, still in flight
+  if (this->result.fac.size() != this->fac.size())
+    return;
+
+  std::swap(this->fac, this->result.fac);
+
+  this->ui->progressBar->setValue(100);
+  this->ui->facWaveform->setData(&this->fac, true, true);
+
+  if (this->adjustZoom) {
+    this->ui->facWaveform->zoomVertical(
+          static_cast<qreal>(0),
+          static_cast<qreal>(1));
+
+    this->adjustZoom = false;
+  }
+
+  if (this->ui->detectPeaksCheck->isChecked()) {
+    if (!isinf(this->result.localMax) && this->result.powerCount > 0) {
+      SUFLOAT meanPower =
+          SU_SQRT(this->result.power / this->result.powerCount);
+      SUFLOAT sigmas = this->result.localMax / meanPower;
+
+      if (sigmas > this->ui->sigmaSpin->value()) {
+        marker.below = false;
+        marker.x = this->result.localMaxPos;
+        marker.string =
+            "Max: " + QString::number(this->result.localMaxPos) +
+            " (" + QString::number(sigmas, 'g', 2) + "σ)";
+        markers.append(marker);
+      }
+    }
+  }
+
+  this->ui->facWaveform->setMarkerList(markers);
+}
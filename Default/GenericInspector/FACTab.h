@@ -25,6 +25,9 @@
 class ThrottleControl;
 #include <sigutils/types.h>
 #include "ColorConfig.h"
+#include "FACProcessorWorker.h"
+
+class QThread;
 
 namespace Ui {
   class FACTab;
@@ -38,20 +41,17 @@ namespace SigDigger {
     qreal fs = 1;
 
     struct timeval lastRefresh = {0, 0};
-    SU_FFTW(_plan) direct = nullptr;
-    SU_FFTW(_plan) reverse = nullptr;
 
-    std::vector<SUCOMPLEX> buffer;
+    QThread *facThread = nullptr;
+    FACProcessorWorker *facWorker = nullptr;
+    FACProcessorParams params;
+    FACProcessorResult result;
+
     std::vector<SUCOMPLEX> fac;
-    SUFLOAT alpha;
-    SUFLOAT min = INFINITY;
-    SUFLOAT max = -INFINITY;
 
     bool recording = false;
     bool adjustZoom = false;
 
-    unsigned int p = 0;
-
     void refreshUi(void);
     void connectAll(void);
     void resizeFAC(int);
@@ -78,6 +78,11 @@ namespace SigDigger {
     void onChangeFACSize(void);
     void onUnitsChanged(void);
     void onChangePeakDetect(void);
+    void onChangeOverlap(void);
+    void onFACResult(void);
+
+  protected:
+    void showEvent(QShowEvent *event) override;
 
   private:
     Ui::FACTab *ui;
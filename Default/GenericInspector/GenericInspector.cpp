@@ -36,6 +36,12 @@ GenericInspectorConfig::deserialize(Suscan::Object const &conf)
   LOAD(waveFormPalette);
   LOAD(waveFormOffset);
   LOAD(waveFormContrast);
+  LOAD(waveFormMemoryLimit);
+  LOAD(waveFormKeepLatest);
+  LOAD(refreshRate);
+  LOAD(constellationDensity);
+  LOAD(deliveryLatency);
+  LOAD(deliveryMaxBatch);
   LOAD(peakHold);
   LOAD(peakDetect);
   LOAD(units);
@@ -55,6 +61,12 @@ GenericInspectorConfig::serialize(void)
   STORE(waveFormPalette);
   STORE(waveFormOffset);
   STORE(waveFormContrast);
+  STORE(waveFormMemoryLimit);
+  STORE(waveFormKeepLatest);
+  STORE(refreshRate);
+  STORE(constellationDensity);
+  STORE(deliveryLatency);
+  STORE(deliveryMaxBatch);
   STORE(peakHold);
   STORE(peakDetect);
   STORE(units);
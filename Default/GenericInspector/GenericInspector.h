@@ -36,6 +36,12 @@ namespace SigDigger {
     std::string  waveFormPalette   = "Inferno (Feely)";
     unsigned int waveFormOffset    = 0;
     int          waveFormContrast  = 1;
+    unsigned int waveFormMemoryLimit = 512; // MiB
+    bool         waveFormKeepLatest  = false;
+    unsigned int refreshRate       = 30; // Max display updates per second
+    bool         constellationDensity = false;
+    unsigned int deliveryLatency   = INSPECTOR_FEED_DEFAULT_LATENCY_MS;
+    unsigned int deliveryMaxBatch  = INSPECTOR_FEED_DEFAULT_MAX_BATCH;
     bool         peakHold          = false;
     bool         peakDetect        = false;
     std::string  units             = "dBFS";
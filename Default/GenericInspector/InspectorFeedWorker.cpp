@@ -0,0 +1,340 @@
+//
+//    InspectorFeedWorker.cpp: Off-GUI processing of inspector samples
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "InspectorFeedWorker.h"
+#include <GenericDataSaver.h>
+#include <sigutils/log.h>
+#include <algorithm>
+
+using namespace SigDigger;
+
+InspectorFeedWorker::InspectorFeedWorker(QObject *parent) : QObject(parent)
+{
+  connect(
+        this,
+        SIGNAL(dataPending(void)),
+        this,
+        SLOT(process(void)),
+        Qt::QueuedConnection);
+}
+
+template<typename T> void
+InspectorFeedWorker::appendCapped(
+    std::vector<T> &dest,
+    const T *data,
+    size_t size,
+    quint64 &dropped)
+{
+  size_t excess;
+
+  if (size > INSPECTOR_FEED_WORKER_MAX_SNAPSHOT) {
+    dropped += size - INSPECTOR_FEED_WORKER_MAX_SNAPSHOT;
+    data    += size - INSPECTOR_FEED_WORKER_MAX_SNAPSHOT;
+    size     = INSPECTOR_FEED_WORKER_MAX_SNAPSHOT;
+  }
+
+  if (dest.size() + size > INSPECTOR_FEED_WORKER_MAX_SNAPSHOT) {
+    excess = dest.size() + size - INSPECTOR_FEED_WORKER_MAX_SNAPSHOT;
+    dest.erase(dest.begin(), dest.begin() + static_cast<long>(excess));
+    dropped += excess;
+  }
+
+  dest.insert(dest.end(), data, data + size);
+}
+
+void
+InspectorFeedWorker::push(
+    const SUCOMPLEX *data,
+    unsigned int size,
+    InspectorFeedParams const &params)
+{
+  bool notify = false;
+
+  this->inputMutex.lock();
+
+  if (this->pending.size() + size > INSPECTOR_FEED_WORKER_MAX_PENDING) {
+    if (this->inputDropped == 0)
+      SU_WARNING("Inspector feed worker cannot keep up, dropping samples\n");
+    this->inputDropped += size;
+  } else {
+    this->pending.insert(this->pending.end(), data, data + size);
+  }
+
+  this->pendingParams = params;
+
+  if (!this->scheduled) {
+    this->scheduled = true;
+    notify = true;
+  }
+
+  this->inputMutex.unlock();
+
+  if (notify)
+    emit dataPending();
+}
+
+void
+InspectorFeedWorker::push(
+    std::vector<SUCOMPLEX> &batch,
+    InspectorFeedParams const &params)
+{
+  bool notify = false;
+  size_t size = batch.size();
+
+  this->inputMutex.lock();
+
+  if (this->pending.size() + size > INSPECTOR_FEED_WORKER_MAX_PENDING) {
+    if (this->inputDropped == 0)
+      SU_WARNING("Inspector feed worker cannot keep up, dropping samples\n");
+    this->inputDropped += size;
+  } else if (this->pending.empty()) {
+    std::swap(this->pending, batch);
+  } else {
+    this->pending.insert(this->pending.end(), batch.begin(), batch.end());
+  }
+
+  this->pendingParams = params;
+
+  if (!this->scheduled) {
+    this->scheduled = true;
+    notify = true;
+  }
+
+  this->inputMutex.unlock();
+
+  batch.clear();
+
+  if (notify)
+    emit dataPending();
+}
+
+void
+InspectorFeedWorker::setOutputs(
+    GenericDataSaver *saver,
+    GenericDataSaver *forwarder)
+{
+  // Blocks until any write in progress is finished
+  QMutexLocker locker(&this->outputMutex);
+
+  this->saver     = saver;
+  this->forwarder = forwarder;
+
+  // New outputs start at a byte (and symbol) boundary
+  this->packer.clear();
+}
+
+void
+InspectorFeedWorker::drain(void)
+{
+  // Runs after any process() call already queued, and takes whatever
+  // they left pending
+  QMetaObject::invokeMethod(this, "process", Qt::BlockingQueuedConnection);
+}
+
+void
+InspectorFeedWorker::setDensityPalette(const QColor *gradient)
+{
+  QMutexLocker locker(&this->inputMutex);
+
+  std::copy(gradient, gradient + 256, this->densityPalette);
+  this->densityPaletteChanged = true;
+}
+
+bool
+InspectorFeedWorker::takeSnapshot(InspectorFeedSnapshot &dest)
+{
+  QMutexLocker locker(&this->snapshotMutex);
+
+  dest.clear();
+  std::swap(dest, this->snapshot);
+  this->announced = false;
+
+  return !dest.samples.empty()
+      || !dest.symbols.empty()
+      || !dest.density.isNull();
+}
+
+void
+InspectorFeedWorker::writeOutputs(
+    InspectorFeedParams const &params,
+    const SUCOMPLEX *data,
+    size_t size,
+    bool haveDecision)
+{
+  QMutexLocker locker(&this->outputMutex);
+
+  if (this->saver == nullptr && this->forwarder == nullptr)
+    return;
+
+  switch (params.output) {
+    // Outputs derived from the samples (decision space, I, Q) are
+    // converted by the savers themselves, in their own threads. See
+    // InspectorUI::getDataFormat().
+    case INSPECTOR_FEED_OUTPUT_DECISION_SPACE:
+    case INSPECTOR_FEED_OUTPUT_SOFT_BITS:
+    case INSPECTOR_FEED_OUTPUT_SOFT_BITS_I:
+    case INSPECTOR_FEED_OUTPUT_SOFT_BITS_Q:
+      if (this->saver != nullptr)
+        this->saver->write(data, size);
+
+      if (this->forwarder != nullptr)
+        this->forwarder->write(data, size);
+      break;
+
+    case INSPECTOR_FEED_OUTPUT_SYMBOLS:
+      if (haveDecision) {
+        if (this->saver != nullptr)
+          this->saver->write(
+              this->decider.get().data(),
+              this->decider.get().size());
+
+        if (this->forwarder != nullptr)
+          this->forwarder->write(
+              this->decider.get().data(),
+              this->decider.get().size());
+      }
+      break;
+
+    case INSPECTOR_FEED_OUTPUT_PACKED_SYMBOLS:
+      if (haveDecision) {
+        this->packer.setBitsPerSymbol(
+              static_cast<unsigned int>(params.decider.getBps()));
+        this->packer.append(
+              this->decider.get().data(),
+              this->decider.get().size());
+        this->packer.take(this->packedBuffer);
+
+        if (!this->packedBuffer.empty()) {
+          if (this->saver != nullptr)
+            this->saver->write(
+                this->packedBuffer.data(),
+                this->packedBuffer.size());
+
+          if (this->forwarder != nullptr)
+            this->forwarder->write(
+                this->packedBuffer.data(),
+                this->packedBuffer.size());
+        }
+      }
+      break;
+  }
+}
+
+void
+InspectorFeedWorker::appendSnapshot(
+    InspectorFeedParams const &params,
+    const SUCOMPLEX *data,
+    size_t size,
+    bool haveDecision)
+{
+  bool notify = false;
+
+  this->snapshotMutex.lock();
+
+  appendCapped(
+        this->snapshot.samples,
+        data,
+        size,
+        this->snapshot.dropped);
+
+  if (haveDecision && params.keepSymbols)
+    appendCapped(
+          this->snapshot.symbols,
+          this->decider.get().data(),
+          this->decider.get().size(),
+          this->snapshot.dropped);
+
+  // Only the latest image matters. QImage is implicitly shared, so this
+  // is a reference until render() detaches our copy on the next run.
+  if (this->densityEnabled)
+    this->snapshot.density = this->densityImage;
+
+  if (!this->announced) {
+    this->announced = true;
+    notify = true;
+  }
+
+  this->snapshotMutex.unlock();
+
+  if (notify)
+    emit snapshotReady();
+}
+
+void
+InspectorFeedWorker::processBatch(
+    InspectorFeedParams const &params,
+    const SUCOMPLEX *data,
+    size_t size)
+{
+  bool haveDecision = false;
+
+  if (this->densityEnabled) {
+    this->density.feed(data, size);
+    this->density.render(this->densityImage);
+  }
+
+  // Decision happens here.
+  if (params.decide && params.decider.getBps() > 0) {
+    this->decider = params.decider;
+    this->decider.feed(data, size);
+    haveDecision = true;
+  }
+
+  this->writeOutputs(params, data, size, haveDecision);
+  this->appendSnapshot(params, data, size, haveDecision);
+}
+
+///////////////////////////////// Slots ////////////////////////////////////////
+void
+InspectorFeedWorker::process(void)
+{
+  InspectorFeedParams params;
+  size_t batch, p;
+
+  this->inputMutex.lock();
+  this->work.clear();
+  std::swap(this->work, this->pending);
+  params = this->pendingParams;
+  this->scheduled = false;
+  if (this->densityPaletteChanged) {
+    this->density.setPalette(this->densityPalette);
+    this->densityPaletteChanged = false;
+  }
+  this->inputMutex.unlock();
+
+  if (this->work.empty())
+    return;
+
+  // Start from scratch every time the density plot is turned on
+  if (params.density != this->densityEnabled) {
+    this->densityEnabled = params.density;
+    if (this->densityEnabled)
+      this->density.reset();
+  }
+
+  // Huge messages are split, so that the GUI gets something to show
+  // before the whole message is through
+  batch = params.maxBatch > 0 ? params.maxBatch : this->work.size();
+
+  for (p = 0; p < this->work.size(); p += batch)
+    this->processBatch(
+          params,
+          this->work.data() + p,
+          std::min(batch, this->work.size() - p));
+}
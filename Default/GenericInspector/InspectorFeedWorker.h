@@ -0,0 +1,177 @@
+//
+//    InspectorFeedWorker.h: Off-GUI processing of inspector samples
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef INSPECTORFEEDWORKER_H
+#define INSPECTORFEEDWORKER_H
+
+#include <QObject>
+#include <QMutex>
+#include <vector>
+#include <sigutils/types.h>
+#include <Decider.h>
+#include <PackedSymbolStream.h>
+#include <ConstellationDensity.h>
+
+// Samples waiting for the worker. Beyond this, new samples are dropped.
+#define INSPECTOR_FEED_WORKER_MAX_PENDING  (1 << 22)
+
+// Samples kept for the GUI between two snapshots. Oldest go first.
+#define INSPECTOR_FEED_WORKER_MAX_SNAPSHOT (1 << 20)
+
+// Default delivery policy. See InspectorUI::feed().
+#define INSPECTOR_FEED_DEFAULT_LATENCY_MS  20
+#define INSPECTOR_FEED_DEFAULT_MAX_BATCH   16384
+
+namespace SigDigger {
+  class GenericDataSaver;
+
+  enum InspectorFeedOutput {
+    INSPECTOR_FEED_OUTPUT_DECISION_SPACE,
+    INSPECTOR_FEED_OUTPUT_SOFT_BITS,
+    INSPECTOR_FEED_OUTPUT_SOFT_BITS_I,
+    INSPECTOR_FEED_OUTPUT_SOFT_BITS_Q,
+    INSPECTOR_FEED_OUTPUT_SYMBOLS,
+    INSPECTOR_FEED_OUTPUT_PACKED_SYMBOLS
+  };
+
+  //
+  // Per-push state, sampled by the GUI thread every time it pushes
+  // samples. The decider is copied as well because the histogram may
+  // change its range at any time.
+  //
+  struct InspectorFeedParams {
+    Decider decider;
+    InspectorFeedOutput output = INSPECTOR_FEED_OUTPUT_DECISION_SPACE;
+    bool decide      = false; // Run the decider
+    bool keepSymbols = false; // Decisions must reach the GUI too
+    bool density     = false; // Accumulate and render the density plot
+    unsigned int maxBatch = INSPECTOR_FEED_DEFAULT_MAX_BATCH; // 0: no limit
+  };
+
+  //
+  // What the GUI gets: every sample and symbol since the previous
+  // snapshot (up to INSPECTOR_FEED_WORKER_MAX_SNAPSHOT).
+  //
+  struct InspectorFeedSnapshot {
+    std::vector<SUCOMPLEX> samples;
+    std::vector<Symbol>    symbols;
+    QImage                 density; // Null unless requested
+    quint64                dropped = 0;
+
+    void
+    clear(void)
+    {
+      this->samples.clear();
+      this->symbols.clear();
+      this->density = QImage();
+      this->dropped = 0;
+    }
+  };
+
+  //
+  // Takes the sample-level work out of InspectorUI::feed: symbol
+  // decision and the conversions and writes of the data saver and the
+  // network forwarder. The GUI pushes raw samples and, at screen rate,
+  // takes a snapshot with everything its widgets need.
+  //
+  class InspectorFeedWorker : public QObject
+  {
+    Q_OBJECT
+
+    // Input side, shared with the GUI thread
+    QMutex inputMutex;
+    std::vector<SUCOMPLEX> pending;
+    InspectorFeedParams pendingParams;
+    bool scheduled = false;
+    quint64 inputDropped = 0;
+    QColor densityPalette[256];
+    bool densityPaletteChanged = false;
+
+    // Outputs. Held during writes, so that the GUI can safely replace
+    // them while we are running.
+    QMutex outputMutex;
+    GenericDataSaver *saver = nullptr;
+    GenericDataSaver *forwarder = nullptr;
+
+    // Display side, shared with the GUI thread
+    QMutex snapshotMutex;
+    InspectorFeedSnapshot snapshot;
+    bool announced = false;
+
+    // Worker-only state
+    Decider decider;
+    std::vector<SUCOMPLEX> work;
+    PackedSymbolStream packer;
+    std::vector<uint8_t> packedBuffer;
+    ConstellationDensity density;
+    QImage densityImage;
+    bool densityEnabled = false;
+
+    void processBatch(
+        InspectorFeedParams const &,
+        const SUCOMPLEX *data,
+        size_t size);
+    void writeOutputs(
+        InspectorFeedParams const &,
+        const SUCOMPLEX *data,
+        size_t size,
+        bool haveDecision);
+    void appendSnapshot(
+        InspectorFeedParams const &,
+        const SUCOMPLEX *data,
+        size_t size,
+        bool haveDecision);
+
+    template<typename T> static void appendCapped(
+        std::vector<T> &dest,
+        const T *data,
+        size_t size,
+        quint64 &dropped);
+
+  public:
+    explicit InspectorFeedWorker(QObject *parent = nullptr);
+
+    // Called from the GUI thread
+    void push(
+        const SUCOMPLEX *data,
+        unsigned int size,
+        InspectorFeedParams const &params);
+
+    // Same, but takes the contents of batch (which is left empty) and
+    // avoids the copy when nothing else is pending
+    void push(
+        std::vector<SUCOMPLEX> &batch,
+        InspectorFeedParams const &params);
+    void setOutputs(GenericDataSaver *saver, GenericDataSaver *forwarder);
+
+    // Blocks until everything pushed so far has reached the outputs
+    void drain(void);
+    void setDensityPalette(const QColor *gradient);
+    bool takeSnapshot(InspectorFeedSnapshot &);
+
+  signals:
+    void dataPending(void);
+    void snapshotReady(void);
+
+  public slots:
+    void process(void);
+  };
+}
+
+#endif // INSPECTORFEEDWORKER_H
@@ -39,6 +39,7 @@
 #include <SigDiggerHelpers.h>
 #include <FrequencyCorrectionDialog.h>
 #include <QInputDialog>
+#include <QPixmap>
 #include <QMessageBox>
 #include <suscan.h>
 #include <iomanip>
@@ -202,12 +203,18 @@ InspectorUI::InspectorUI(
 
   this->haveQth = suscan_get_qth(&this->qth);
 
+  // Shares its place with the constellation. See onToggleDensity()
+  this->ui->densityView->hide();
+
   this->facTab = new FACTab(this->ui->toolTab);
   this->ui->toolTab->addTab(this->facTab, "Symbol autocorrelation");
 
   this->symViewTab = new SymViewTab(this->ui->toolTab);
   this->ui->toolTab->addTab(this->symViewTab, "Symbol stream");
 
+  this->syncTab = new SyncWordTab(this->ui->toolTab);
+  this->ui->toolTab->addTab(this->syncTab, "Sync words");
+
   this->wfTab = new WaveformTab(this->ui->toolTab);
   this->ui->toolTab->addTab(this->wfTab, "Waveform");
 
@@ -230,6 +237,8 @@ InspectorUI::InspectorUI(
     this->tvTab->setDecisionMode(Decider::MODULUS);
     this->decider.setMinimum(0);
     this->decider.setMaximum(1);
+    this->estimator.setDecisionMode(true);
+    this->estimator.setRange(0, 1);
 
     this->ui->histogram->overrideDisplayRange(1);
     this->ui->histogram->overrideUnits("");
@@ -239,6 +248,8 @@ InspectorUI::InspectorUI(
     this->tvTab->setDecisionMode(Decider::ARGUMENT);
     this->decider.setMinimum(-PI);
     this->decider.setMaximum(PI);
+    this->estimator.setDecisionMode(false);
+    this->estimator.setRange(-PI, PI);
 
     this->ui->histogram->overrideDataRange(2 * M_PI);
     this->ui->histogram->overrideDisplayRange(360);
@@ -248,11 +259,41 @@ InspectorUI::InspectorUI(
     this->tvTab->setDecisionMode(Decider::ARGUMENT);
     this->decider.setMinimum(-PI);
     this->decider.setMaximum(PI);
+    this->estimator.setDecisionMode(false);
+    this->estimator.setRange(-PI, PI);
 
     this->ui->histogram->overrideDataRange(2 * M_PI);
     this->ui->histogram->overrideUnits("Hz");
   }
 
+  this->feedThread = new QThread();
+  this->feedWorker = new InspectorFeedWorker();
+  this->feedWorker->moveToThread(this->feedThread);
+
+  this->snapshotTimer = new QTimer(this);
+  this->snapshotTimer->setSingleShot(true);
+  this->setRefreshRate(30);
+
+  this->deliveryTimer = new QTimer(this);
+  this->deliveryTimer->setSingleShot(true);
+  this->setDeliveryPolicy(
+        INSPECTOR_FEED_DEFAULT_LATENCY_MS,
+        INSPECTOR_FEED_DEFAULT_MAX_BATCH);
+
+  connect(
+        this->feedThread,
+        &QThread::finished,
+        this->feedWorker,
+        &QObject::deleteLater);
+
+  connect(
+        this->feedThread,
+        &QThread::finished,
+        this->feedThread,
+        &QObject::deleteLater);
+
+  this->feedThread->start();
+
   this->initUi();
   this->connectAll();
 
@@ -265,6 +306,12 @@ InspectorUI::InspectorUI(
 
 InspectorUI::~InspectorUI()
 {
+  // Savers go away below. Write what they are owed, and make sure the
+  // worker is done with them.
+  this->drainFeed();
+  this->feedWorker->setOutputs(nullptr, nullptr);
+  this->feedThread->quit();
+
   delete this->ui;
 
   if (this->dataSaver != nullptr)
@@ -422,6 +469,8 @@ InspectorUI::setPalette(std::string const &str)
 
   WATERFALL_CALL(setPalette(
         SigDiggerHelpers::instance()->getPalette(index)->getGradient()));
+  this->feedWorker->setDensityPalette(
+        SigDiggerHelpers::instance()->getPalette(index)->getGradient());
   this->ui->paletteCombo->setCurrentIndex(index);
 
   m_tabConfig->spectrumPalette = str;
@@ -466,6 +515,29 @@ InspectorUI::addEstimator(Suscan::Estimator const &estimator)
 void
 InspectorUI::connectAll()
 {
+  connect(
+        this->feedWorker,
+        SIGNAL(snapshotReady(void)),
+        this,
+        SLOT(onFeedSnapshotReady(void)));
+
+  connect(
+        this->snapshotTimer,
+        SIGNAL(timeout(void)),
+        this,
+        SLOT(onFeedSnapshotTimeout(void)));
+
+  connect(
+        this->deliveryTimer,
+        SIGNAL(timeout(void)),
+        this,
+        SLOT(onDeliveryTimeout(void)));
+
+  connect(
+        this->wfTab,
+        SIGNAL(storageSettingsChanged(void)),
+        this,
+        SLOT(onWaveformStorageChanged(void)));
 
   connect(
         this->ui->fpsSpin,
@@ -522,6 +594,12 @@ InspectorUI::connectAll()
         this,
         SLOT(onResetSNR()));
 
+  connect(
+        this->ui->densityCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onToggleDensity()));
+
   connect(
         this->ui->loLcd,
         SIGNAL(valueChanged(void)),
@@ -610,6 +688,12 @@ InspectorUI::connectDataSaver()
         this,
         SLOT(onSaveRate(qreal)));
 
+  connect(
+        this->dataSaver,
+        SIGNAL(metricsUpdated(void)),
+        this,
+        SLOT(onSaveMetrics(void)));
+
   connect(
         this->dataSaver,
         SIGNAL(commit(void)),
@@ -638,6 +722,12 @@ InspectorUI::connectNetForwarder()
         this,
         SLOT(onNetRate(qreal)));
 
+  connect(
+        this->socketForwarder,
+        SIGNAL(metricsUpdated(void)),
+        this,
+        SLOT(onNetMetrics(void)));
+
   connect(
         this->socketForwarder,
         SIGNAL(commit(void)),
@@ -667,8 +757,15 @@ InspectorUI::captureFileName(void) const
        << "-baud-"
        << std::setw(4)
        << std::setfill('0')
-       << ++i
-       << ".raw";
+       << ++i;
+
+    if (this->isPackingSymbols())
+      os << "-" << this->getBps() << "bps-packed";
+    else
+      os << "-" << GenericDataFormat::typeName(
+              this->getDataFormat().outputType());
+
+    os << ".raw";
     path = this->saverUI->getRecordSavePath() + "/" + os.str();
   } while (access(path.c_str(), F_OK) != -1);
 
@@ -679,15 +776,48 @@ bool
 InspectorUI::installNetForwarder(void)
 {
   if (this->socketForwarder == nullptr) {
-    this->socketForwarder = new SocketForwarder(
-          this->netForwarderUI->getHost(),
-          this->netForwarderUI->getPort(),
-          this->netForwarderUI->getFrameLen(),
-          this->netForwarderUI->getTcp(),
-          this);
     this->recordingRate = this->getBaudRate();
+
+    if (this->netForwarderUI->getSharedMemory()) {
+      SharedMemoryForwarderParams params;
+
+      params.name       = this->netForwarderUI->getHost();
+      params.sampleSize = this->getDataSampleSize();
+      params.sampleRate = this->recordingRate;
+
+      if (this->isPackingSymbols()) {
+        params.format        = SIGDIGGER_SHM_RING_FORMAT_PACKED;
+        params.bitsPerSymbol = this->getBps();
+      } else if (params.sampleSize == sizeof(SUCOMPLEX))
+        params.format = SIGDIGGER_SHM_RING_FORMAT_CF32;
+      else if (params.sampleSize == sizeof(SUFLOAT))
+        params.format = SIGDIGGER_SHM_RING_FORMAT_F32;
+      else
+        params.format = SIGDIGGER_SHM_RING_FORMAT_U8;
+
+      this->socketForwarder = new SharedMemoryForwarder(params, this);
+    } else {
+      SocketForwarderParams params;
+
+      params.host       = this->netForwarderUI->getHost();
+      params.port       = this->netForwarderUI->getPort();
+      params.frameLen   = this->netForwarderUI->getFrameLen();
+      params.tcp        = this->netForwarderUI->getTcp();
+      params.listen     = this->netForwarderUI->getListen();
+      params.policy     = this->netForwarderUI->getSlowClientPolicy();
+      params.header     = this->netForwarderUI->getHeader();
+      params.sampleSize = this->getDataSampleSize();
+
+      if (this->isPackingSymbols())
+        params.bitsPerSymbol = this->getBps();
+
+      this->socketForwarder = new SocketForwarder(params, this);
+    }
+
+    this->socketForwarder->setFormat(this->getDataFormat());
     this->socketForwarder->setSampleRate(recordingRate);
     connectNetForwarder();
+    this->refreshFeedOutputs();
 
     return true;
   }
@@ -695,12 +825,79 @@ InspectorUI::installNetForwarder(void)
   return false;
 }
 
+unsigned int
+InspectorUI::getDataSampleSize(void) const
+{
+  switch (this->ui->dataVarCombo->currentIndex()) {
+    case SIGDIGGER_INSPECTOR_UI_SOFT_BITS:
+      return sizeof(SUCOMPLEX);
+
+    case SIGDIGGER_INSPECTOR_UI_SYMBOLS:
+    case SIGDIGGER_INSPECTOR_UI_PACKED_SYMBOLS:
+      return sizeof(uint8_t);
+  }
+
+  return sizeof(SUFLOAT);
+}
+
+GenericDataFormat
+InspectorUI::getDataFormat(void) const
+{
+  GenericDataFormat format;
+
+  format.input = GENERIC_DATA_TYPE_CF32;
+
+  switch (this->ui->dataVarCombo->currentIndex()) {
+    case SIGDIGGER_INSPECTOR_UI_DECISION_SPACE:
+      format.conversion =
+          this->decider.getDecisionMode() == Decider::MODULUS
+          ? GENERIC_DATA_CONVERSION_MODULUS
+          : GENERIC_DATA_CONVERSION_ARGUMENT;
+      break;
+
+    case SIGDIGGER_INSPECTOR_UI_SOFT_BITS_I:
+      format.conversion = GENERIC_DATA_CONVERSION_REAL;
+      break;
+
+    case SIGDIGGER_INSPECTOR_UI_SOFT_BITS_Q:
+      format.conversion = GENERIC_DATA_CONVERSION_IMAG;
+      break;
+
+    case SIGDIGGER_INSPECTOR_UI_SYMBOLS:
+    case SIGDIGGER_INSPECTOR_UI_PACKED_SYMBOLS:
+      format.input = GENERIC_DATA_TYPE_U8;
+      break;
+  }
+
+  return format;
+}
+
+bool
+InspectorUI::isForwardingSymbols(void) const
+{
+  int index = this->ui->dataVarCombo->currentIndex();
+
+  return index == SIGDIGGER_INSPECTOR_UI_SYMBOLS
+      || index == SIGDIGGER_INSPECTOR_UI_PACKED_SYMBOLS;
+}
+
+bool
+InspectorUI::isPackingSymbols(void) const
+{
+  return this->ui->dataVarCombo->currentIndex()
+      == SIGDIGGER_INSPECTOR_UI_PACKED_SYMBOLS;
+}
+
 void
 InspectorUI::uninstallNetForwarder(void)
 {
-  if (this->socketForwarder)
-    this->socketForwarder->deleteLater();
-  this->socketForwarder = nullptr;
+  if (this->socketForwarder != nullptr) {
+    GenericDataSaver *forwarder = this->socketForwarder;
+    this->drainFeed();
+    this->socketForwarder = nullptr;
+    this->refreshFeedOutputs();
+    forwarder->deleteLater();
+  }
 }
 
 void
@@ -719,6 +916,7 @@ void
 InspectorUI::setTimeStamp(struct timeval const &tv)
 {
   this->fcDialog->setTimestamp(tv);
+  this->syncTab->setTimeStamp(tv);
 }
 
 void
@@ -754,8 +952,10 @@ InspectorUI::installDataSaver(void)
 
     this->dataSaver = new FileDataSaver(this->fd, this);
     this->recordingRate = this->getBaudRate();
+    this->dataSaver->setFormat(this->getDataFormat());
     this->dataSaver->setSampleRate(recordingRate);
     connectDataSaver();
+    this->refreshFeedOutputs();
 
     return true;
   }
@@ -763,12 +963,26 @@ InspectorUI::installDataSaver(void)
   return false;
 }
 
+void
+InspectorUI::refreshFeedOutputs(void)
+{
+  this->feedWorker->setOutputs(this->dataSaver, this->socketForwarder);
+
+  // Savers have a fixed sample format
+  this->ui->dataVarCombo->setEnabled(
+        this->dataSaver == nullptr && this->socketForwarder == nullptr);
+}
+
 void
 InspectorUI::uninstallDataSaver(void)
 {
-  if (this->dataSaver != nullptr)
-    this->dataSaver->deleteLater();
-  this->dataSaver = nullptr;
+  if (this->dataSaver != nullptr) {
+    FileDataSaver *saver = this->dataSaver;
+    this->drainFeed();
+    this->dataSaver = nullptr;
+    this->refreshFeedOutputs();
+    saver->deleteLater();
+  }
 
   if (this->fd != -1) {
     close(this->fd);
@@ -782,8 +996,7 @@ InspectorUI::onToggleSNR(void)
   this->estimating = this->ui->snrButton->isChecked();
 
   if (this->estimating) {
-    this->estimator.setSigma(1.f);
-    this->estimator.setAlpha(1.f / (this->decider.getIntervals()));
+    this->estimator.reset();
     gettimeofday(&this->last_estimator_update, nullptr);
   } else {
     std::vector<float> empty;
@@ -796,32 +1009,81 @@ InspectorUI::onToggleSNR(void)
 void
 InspectorUI::onResetSNR(void)
 {
-  this->estimator.setSigma(1.f);
+  this->estimator.reset();
+}
+
+void
+InspectorUI::onToggleDensity(void)
+{
+  bool density = this->ui->densityCheck->isChecked();
+
+  this->ui->densityView->setVisible(density);
+  this->ui->constellation->setVisible(!density);
 
+  m_tabConfig->constellationDensity = density;
 }
 
 
+bool
+InspectorUI::isShowing(const QWidget *widget) const
+{
+  return widget->isVisible() && !widget->window()->isMinimized();
+}
+
 void
-InspectorUI::feed(const SUCOMPLEX *data, unsigned int size)
+InspectorUI::setRefreshRate(unsigned int rate)
 {
-  bool dataForwarding = this->recording || this->forwarding;
-  bool symbolForwarding =
-      this->ui->dataVarCombo->currentIndex() == SIGDIGGER_INSPECTOR_UI_SYMBOLS;
-  bool decisionNeeded =
-      (dataForwarding && symbolForwarding) || this->symViewTab->isRecording();
-  bool haveDecision = false;
-  this->ui->constellation->feed(data, size);
-  this->ui->histogram->feed(data, size);
+  if (rate < SIGDIGGER_INSPECTOR_UI_MIN_REFRESH_RATE)
+    rate = SIGDIGGER_INSPECTOR_UI_MIN_REFRESH_RATE;
+  else if (rate > SIGDIGGER_INSPECTOR_UI_MAX_REFRESH_RATE)
+    rate = SIGDIGGER_INSPECTOR_UI_MAX_REFRESH_RATE;
+
+  this->snapshotTimer->setInterval(SCAST(int, 1000 / rate));
+}
+
+void
+InspectorUI::setDeliveryPolicy(unsigned int latencyMs, unsigned int maxBatch)
+{
+  this->deliveryLatency  = latencyMs;
+  this->deliveryMaxBatch = maxBatch;
+
+  this->deliveryTimer->setInterval(SCAST(int, latencyMs));
+
+  if (!this->feedBatch.empty())
+    this->flushFeed();
+}
+
+void
+InspectorUI::feedDisplay(InspectorFeedSnapshot const &snapshot)
+{
+  const SUCOMPLEX *data = snapshot.samples.data();
+  unsigned int size = static_cast<unsigned int>(snapshot.samples.size());
+  bool showing = this->isShowing(this->ui->histogram);
+
+  // Views with no state worth keeping are only fed while someone can see
+  // them. Tabs that record (symbols, waveform, FAC, TV) always get their
+  // data, and decide by themselves what to draw.
+  if (size > 0 && showing) {
+    if (this->ui->constellation->isVisible())
+      this->ui->constellation->feed(data, size);
+    this->ui->histogram->feed(data, size);
+  }
+
+  if (!snapshot.density.isNull() && this->isShowing(this->ui->densityView))
+    this->ui->densityView->setPixmap(QPixmap::fromImage(snapshot.density));
 
   if (this->estimating) {
     struct timeval tv, res;
-    this->estimator.feed(this->ui->histogram->getHistory());
+    this->syncEstimator();
+    this->estimator.feed(data, size);
     gettimeofday(&tv, nullptr);
 
     timersub(&this->last_estimator_update, &tv, &res);
 
-    if (res.tv_sec > 0 || res.tv_usec > 100000) {
-      this->ui->histogram->setSNRModel(this->estimator.getModel());
+    if (showing && (res.tv_sec > 0 || res.tv_usec > 100000)) {
+      this->ui->histogram->setSNRModel(
+            this->estimator.getModel(
+              SCAST(unsigned, this->ui->histogram->getHistory().size())));
       this->ui->snrLabel->setText(
             QString::number(
               floor(20. * log10(SCAST(qreal, this->estimator.getSNR()))))
@@ -830,107 +1092,104 @@ InspectorUI::feed(const SUCOMPLEX *data, unsigned int size)
     }
   }
 
-  // Decision happens here.
-  if (decisionNeeded) {
-    if (this->decider.getBps() > 0) {
-      this->decider.feed(data, size);
-      haveDecision = true;
+  if (!snapshot.symbols.empty() && this->symViewTab->isRecording()) {
+    this->symViewTab->feed(snapshot.symbols);
+    if (showing)
+      this->ui->transition->feed(snapshot.symbols);
+  }
 
-      if (this->symViewTab->isRecording()) {
-        this->symViewTab->feed(this->decider.get());
-        this->ui->transition->feed(this->decider.get());
-      }
-    }
+  if (!snapshot.symbols.empty() && this->syncTab->isRecording())
+    this->syncTab->feed(snapshot.symbols);
+
+  if (size > 0) {
+    if (this->facTab->isRecording())
+      this->facTab->feed(data, size);
+
+    if (this->tvTab->isEnabled())
+      this->tvTab->feed(data, size);
+
+    if (this->wfTab->isRecording())
+      this->wfTab->feed(data, size);
   }
+}
 
-  if (this->facTab->isRecording())
-    this->facTab->feed(data, size);
-
-  if (this->tvTab->isEnabled())
-    this->tvTab->feed(data, size);
-
-  if (this->wfTab->isRecording())
-    this->wfTab->feed(data, size);
-
-  if (dataForwarding) {
-    switch (this->ui->dataVarCombo->currentIndex()) {
-      case SIGDIGGER_INSPECTOR_UI_DECISION_SPACE:
-        if (this->floatBuffer.size() < size)
-          this->floatBuffer.resize(size);
-
-        switch (this->decider.getDecisionMode()) {
-          case Decider::MODULUS:
-            for (unsigned i = 0; i < size; ++i)
-              this->floatBuffer[i] = SU_C_ABS(data[i]);
-            break;
-
-          case Decider::ARGUMENT:
-            for (unsigned i = 0; i < size; ++i)
-              this->floatBuffer[i] = SU_C_ARG(SU_I * data[i]) / PI;
-            break;
-        }
-
-        // Decision space: deliver floats
-        if (this->recording)
-          this->dataSaver->write(this->floatBuffer.data(), size);
-
-        if (this->forwarding)
-          this->socketForwarder->write(this->floatBuffer.data(), size);
-
-        break;
-
-      case SIGDIGGER_INSPECTOR_UI_SOFT_BITS:
-        // Pure softbits: deliver complex I/Q samples
-        if (this->recording)
-          this->dataSaver->write(data, size);
-
-        if (this->forwarding)
-          this->socketForwarder->write(data, size);
-        break;
-
-      case SIGDIGGER_INSPECTOR_UI_SOFT_BITS_I:
-        if (this->floatBuffer.size() < size)
-          this->floatBuffer.resize(size);
-        for (unsigned i = 0; i < size; ++i)
-          this->floatBuffer[i] = SU_C_REAL(data[i]);
-
-        if (this->recording)
-          this->dataSaver->write(this->floatBuffer.data(), size);
-
-        if (this->forwarding)
-          this->socketForwarder->write(this->floatBuffer.data(), size);
-        break;
-
-      case SIGDIGGER_INSPECTOR_UI_SOFT_BITS_Q:
-        if (this->floatBuffer.size() < size)
-          this->floatBuffer.resize(size);
-        for (unsigned i = 0; i < size; ++i)
-          this->floatBuffer[i] = SU_C_IMAG(data[i]);
-
-        if (this->recording)
-          this->dataSaver->write(this->floatBuffer.data(), size);
-
-        if (this->forwarding)
-          this->socketForwarder->write(this->floatBuffer.data(), size);
-        break;
-
-      case SIGDIGGER_INSPECTOR_UI_SYMBOLS:
-        if (haveDecision) {
-          if (this->recording)
-            this->dataSaver->write(
-                this->decider.get().data(),
-                this->decider.get().size());
-
-          if (this->forwarding)
-            this->socketForwarder->write(
-                this->decider.get().data(),
-                this->decider.get().size());
-        }
-        break;
-    }
+//
+// The histogram edits the decider interval in place. The estimator has to
+// follow, or it keeps measuring against the range set at construction.
+//
+void
+InspectorUI::syncEstimator(void)
+{
+  float min = this->decider.getMinimum();
+  float max = this->decider.getMaximum();
+
+  this->estimator.setDecisionMode(
+        this->decider.getDecisionMode() == Decider::MODULUS);
+
+  if (min != this->estimatorMin || max != this->estimatorMax) {
+    this->estimator.setRange(min, max);
+    this->estimatorMin = min;
+    this->estimatorMax = max;
   }
 }
 
+//
+// Samples received before an output is detached must still reach it:
+// push the current batch and wait until the worker has written it.
+//
+void
+InspectorUI::drainFeed(void)
+{
+  this->flushFeed();
+  this->feedWorker->drain();
+}
+
+void
+InspectorUI::flushFeed(void)
+{
+  InspectorFeedParams params;
+  bool dataForwarding = this->recording || this->forwarding;
+  bool symbolForwarding = this->isForwardingSymbols();
+
+  this->deliveryTimer->stop();
+
+  if (this->feedBatch.empty())
+    return;
+
+  // dataVarCombo entries are laid out in InspectorFeedOutput order
+  params.output = static_cast<InspectorFeedOutput>(
+        this->ui->dataVarCombo->currentIndex());
+  params.decider     = this->decider;
+  params.keepSymbols =
+      this->symViewTab->isRecording() || this->syncTab->isRecording();
+  params.decide      =
+      (dataForwarding && symbolForwarding) || params.keepSymbols;
+  params.density     = this->isShowing(this->ui->densityView);
+  params.maxBatch    = this->deliveryMaxBatch;
+
+  this->feedWorker->push(this->feedBatch, params);
+}
+
+//
+// Analyzer messages come in whatever size the symbol rate dictates: a
+// few samples each at low rates, huge blocks at high rates. Small ones
+// are merged here until deliveryLatency ms have passed since the first
+// of them, or deliveryMaxBatch samples are waiting. The worker splits
+// the big ones.
+//
+void
+InspectorUI::feed(const SUCOMPLEX *data, unsigned int size)
+{
+  this->feedBatch.insert(this->feedBatch.end(), data, data + size);
+
+  if (this->deliveryLatency == 0
+      || (this->deliveryMaxBatch > 0
+          && this->feedBatch.size() >= this->deliveryMaxBatch))
+    this->flushFeed();
+  else if (!this->deliveryTimer->isActive())
+    this->deliveryTimer->start();
+}
+
 void
 InspectorUI::feedSpectrum(const SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate)
 {
@@ -939,12 +1198,16 @@ InspectorUI::feedSpectrum(const SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate)
     this->lastRate = rate;
   }
 
-  this->fftData.resize(len);
-  this->fftData.assign(data, data + len);
+  // The waterfall is history nobody will scroll back to. Skip it while
+  // hidden, but keep tracking the spectrum limits below.
+  if (this->wf != nullptr && this->isShowing(this->wf)) {
+    this->fftData.resize(len);
+    this->fftData.assign(data, data + len);
 
-  WATERFALL_CALL(setNewFftData(
-        static_cast<float *>(this->fftData.data()),
-        SCAST(int, len)));
+    WATERFALL_CALL(setNewFftData(
+          static_cast<float *>(this->fftData.data()),
+          SCAST(int, len)));
+  }
 
   if (!this->haveSpectrumLimits) {
     SUFLOAT min = +INFINITY;
@@ -1166,6 +1429,7 @@ InspectorUI::setBps(unsigned int bps)
     this->decider.setBps(bps);
     this->estimator.setBps(bps);
     this->symViewTab->setBitsPerSymbol(bps);
+    this->syncTab->setBitsPerSymbol(bps);
     this->ui->constellation->setOrderHint(bps);
     this->ui->transition->setOrderHint(bps);
     this->ui->histogram->setDecider(&this->decider);
@@ -1237,6 +1501,7 @@ InspectorUI::onInspectorControlChanged(void)
     this->tvTab->setSampleRate(this->getBaudRateFloat());
     this->wfTab->setSampleRate(this->getBaudRateFloat());
     this->facTab->setSampleRate(this->getBaudRateFloat());
+    this->syncTab->setBaudRate(this->getBaudRateFloat());
 
     if (this->recording) {
       this->recording = false;
@@ -1333,6 +1598,16 @@ InspectorUI::setAppConfig(AppConfig const &cfg)
   this->wfTab->setPalette(m_tabConfig->waveFormPalette);
   this->wfTab->setPaletteOffset(m_tabConfig->waveFormOffset);
   this->wfTab->setPaletteContrast(m_tabConfig->waveFormContrast);
+  this->wfTab->setMemoryLimit(m_tabConfig->waveFormMemoryLimit);
+  this->wfTab->setKeepLatest(m_tabConfig->waveFormKeepLatest);
+
+  this->setRefreshRate(m_tabConfig->refreshRate);
+  this->setDeliveryPolicy(
+        m_tabConfig->deliveryLatency,
+        m_tabConfig->deliveryMaxBatch);
+
+  this->ui->densityCheck->setChecked(m_tabConfig->constellationDensity);
+  this->onToggleDensity();
 
   // Set FAC colors
   this->facTab->setColorConfig(colors);
@@ -1558,10 +1833,21 @@ InspectorUI::onSaveRate(qreal rate)
   this->saverUI->setIORate(rate);
 }
 
+void
+InspectorUI::onSaveMetrics(void)
+{
+  if (this->dataSaver != nullptr)
+    this->saverUI->setMetrics(this->dataSaver->getMetrics());
+}
+
 void
 InspectorUI::onCommit(void)
 {
-  this->saverUI->setCaptureSize(this->dataSaver->getSize());
+  // Commits are queued: the saver may have been uninstalled since
+  GenericDataSaver *saver = qobject_cast<GenericDataSaver *>(this->sender());
+
+  if (saver != nullptr && saver == this->dataSaver)
+    this->saverUI->setCaptureSize(saver->getSize());
 }
 
 
@@ -1630,10 +1916,51 @@ InspectorUI::onNetRate(qreal rate)
   this->netForwarderUI->setIORate(rate);
 }
 
+void
+InspectorUI::onNetMetrics(void)
+{
+  if (this->socketForwarder != nullptr)
+    this->netForwarderUI->setMetrics(this->socketForwarder->getMetrics());
+}
+
 void
 InspectorUI::onNetCommit(void)
 {
-  this->netForwarderUI->setCaptureSize(this->socketForwarder->getSize());
+  GenericDataSaver *saver = qobject_cast<GenericDataSaver *>(this->sender());
+
+  if (saver != nullptr && saver == this->socketForwarder)
+    this->netForwarderUI->setCaptureSize(saver->getSize());
+}
+
+// Feed worker
+void
+InspectorUI::onFeedSnapshotReady(void)
+{
+  // Coalesce everything the worker produces within one display period
+  if (!this->snapshotTimer->isActive())
+    this->snapshotTimer->start();
+}
+
+void
+InspectorUI::onFeedSnapshotTimeout(void)
+{
+  if (this->feedWorker->takeSnapshot(this->feedSnapshot))
+    this->feedDisplay(this->feedSnapshot);
+}
+
+void
+InspectorUI::onDeliveryTimeout(void)
+{
+  this->flushFeed();
+}
+
+void
+InspectorUI::onWaveformStorageChanged(void)
+{
+  if (m_tabConfig != nullptr) {
+    m_tabConfig->waveFormMemoryLimit = this->wfTab->getMemoryLimit();
+    m_tabConfig->waveFormKeepLatest  = this->wfTab->getKeepLatest();
+  }
 }
 
 void
@@ -24,6 +24,7 @@
 #include <QVector>
 #include <QThread>
 #include <QMenu>
+#include <QTimer>
 #include <memory>
 #include <map>
 #include "InspectorCtl/InspectorCtl.h"
@@ -34,6 +35,7 @@
 #include <SNREstimator.h>
 #include <sys/time.h>
 #include <SocketForwarder.h>
+#include <SharedMemoryForwarder.h>
 #include <AbstractWaterfall.h>
 
 #include "ThrottleableWidget.h"
@@ -48,6 +50,8 @@
 #include "TVProcessorTab.h"
 #include "WaveformTab.h"
 #include "FACTab.h"
+#include "SyncWordTab.h"
+#include "InspectorFeedWorker.h"
 
 namespace Ui {
   class Inspector;
@@ -58,6 +62,11 @@ namespace Ui {
 #define SIGDIGGER_INSPECTOR_UI_SOFT_BITS_I    2
 #define SIGDIGGER_INSPECTOR_UI_SOFT_BITS_Q    3
 #define SIGDIGGER_INSPECTOR_UI_SYMBOLS        4
+#define SIGDIGGER_INSPECTOR_UI_PACKED_SYMBOLS 5
+
+// Bounds of the display update rate fed from the sample worker (Hz)
+#define SIGDIGGER_INSPECTOR_UI_MIN_REFRESH_RATE 1
+#define SIGDIGGER_INSPECTOR_UI_MAX_REFRESH_RATE 120
 
 namespace SigDigger {
   class FrequencyCorrectionDialog;
@@ -105,10 +114,11 @@ namespace SigDigger {
     unsigned int bps = 0;
     Decider decider;
     SNREstimator estimator;
+    float estimatorMin = 0;
+    float estimatorMax = 0;
 
     bool estimating = false;
     struct timeval last_estimator_update;
-    std::vector<SUFLOAT>  floatBuffer;
     std::vector<SUFLOAT>  fftData;
 
     // UI objects
@@ -131,11 +141,25 @@ namespace SigDigger {
     DataSaverUI *saverUI = nullptr;
     NetForwarderUI *netForwarderUI = nullptr;
     FileDataSaver *dataSaver = nullptr;
-    SocketForwarder *socketForwarder = nullptr;
+    GenericDataSaver *socketForwarder = nullptr;
     TVProcessorTab *tvTab = nullptr;
     FACTab *facTab = nullptr;
     WaveformTab *wfTab = nullptr;
     SymViewTab *symViewTab = nullptr;
+    SyncWordTab *syncTab = nullptr;
+
+    // Sample processing, off the GUI thread
+    QThread *feedThread = nullptr;
+    InspectorFeedWorker *feedWorker = nullptr;
+    QTimer *snapshotTimer = nullptr;
+    InspectorFeedSnapshot feedSnapshot;
+
+    // Delivery policy: small messages are merged for up to
+    // deliveryLatency ms, and batches are cut at deliveryMaxBatch samples
+    QTimer *deliveryTimer = nullptr;
+    std::vector<SUCOMPLEX> feedBatch;
+    unsigned int deliveryLatency = INSPECTOR_FEED_DEFAULT_LATENCY_MS;
+    unsigned int deliveryMaxBatch = INSPECTOR_FEED_DEFAULT_MAX_BATCH;
 
     FrequencyCorrectionDialog *fcDialog = nullptr;
 
@@ -147,6 +171,12 @@ namespace SigDigger {
     void pushControl(InspectorCtl *ctl);
     void setBps(unsigned int bps);
     void connectAll(void);
+    void refreshFeedOutputs(void);
+    void feedDisplay(InspectorFeedSnapshot const &);
+    void syncEstimator(void);
+    bool isShowing(const QWidget *) const;
+    void flushFeed(void);
+    void drainFeed(void);
 
     void initUi(void);
     unsigned int getBps(void) const;
@@ -162,6 +192,10 @@ namespace SigDigger {
     void connectNetForwarder(void);
     void refreshSizes(void);
     std::string captureFileName(void) const;
+    unsigned int getDataSampleSize(void) const;
+    GenericDataFormat getDataFormat(void) const;
+    bool isForwardingSymbols(void) const;
+    bool isPackingSymbols(void) const;
     unsigned int getVScrollPageSize(void) const;
     unsigned int getHScrollOffset(void) const;
     void refreshVScrollBar(void) const;
@@ -199,6 +233,8 @@ namespace SigDigger {
       }
 
       void feed(const SUCOMPLEX *data, unsigned int size);
+      void setRefreshRate(unsigned int rate);
+      void setDeliveryPolicy(unsigned int latencyMs, unsigned int maxBatch);
       void feedSpectrum(const SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate);
       void updateEstimator(Suscan::EstimatorId id, float val);
       void setQth(xyz_t const &);
@@ -246,6 +282,7 @@ namespace SigDigger {
       void onSpectrumSourceChanged(void);
       void onToggleSNR(void);
       void onResetSNR(void);
+      void onToggleDensity(void);
       void onToggleRecord(void);
       void onToggleNetForward(void);
       void onChangeLo(void);
@@ -271,6 +308,7 @@ namespace SigDigger {
       void onSaveError(void);
       void onSaveSwamped(void);
       void onSaveRate(qreal rate);
+      void onSaveMetrics(void);
       void onCommit(void);
 
       // Net Forwarder slots
@@ -278,8 +316,15 @@ namespace SigDigger {
       void onNetError(void);
       void onNetSwamped(void);
       void onNetRate(qreal rate);
+      void onNetMetrics(void);
       void onNetCommit(void);
 
+      // Feed worker slots
+      void onFeedSnapshotReady(void);
+      void onFeedSnapshotTimeout(void);
+      void onDeliveryTimeout(void);
+      void onWaveformStorageChanged(void);
+
     signals:
       void configChanged(void);
       void setSpectrumSource(unsigned int index);
@@ -0,0 +1,336 @@
+//
+//    SyncWordTab.cpp: Live sync word search
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SyncWordTab.h"
+#include "ui_SyncWordTab.h"
+#include <QThread>
+#include <QDateTime>
+
+using namespace SigDigger;
+
+SyncWordTab::SyncWordTab(QWidget *parent) :
+  QWidget(parent),
+  ui(new Ui::SyncWordTab)
+{
+  ui->setupUi(this);
+
+  this->syncThread = new QThread();
+  this->syncWorker = new SyncWordWorker();
+  this->syncWorker->moveToThread(this->syncThread);
+
+  connect(
+        this->syncThread,
+        &QThread::finished,
+        this->syncWorker,
+        &QObject::deleteLater);
+
+  connect(
+        this->syncThread,
+        &QThread::finished,
+        this->syncThread,
+        &QObject::deleteLater);
+
+  this->syncThread->start();
+
+  this->connectAll();
+  this->onConfigChanged();
+}
+
+SyncWordTab::~SyncWordTab()
+{
+  if (this->syncThread != nullptr)
+    this->syncThread->quit();
+
+  delete ui;
+}
+
+void
+SyncWordTab::connectAll(void)
+{
+  connect(
+        this->ui->recordButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onRecord(void)));
+
+  connect(
+        this->ui->syncWordsEdit,
+        SIGNAL(editingFinished(void)),
+        this,
+        SLOT(onConfigChanged(void)));
+
+  connect(
+        this->ui->errorsSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onConfigChanged(void)));
+
+  connect(
+        this->ui->frameLenSpin,
+        SIGNAL(valueChanged(int)),
+        this,
+        SLOT(onConfigChanged(void)));
+
+  connect(
+        this->ui->invertedCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onConfigChanged(void)));
+
+  connect(
+        this->ui->clearButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onClear(void)));
+
+  connect(
+        this->syncWorker,
+        SIGNAL(resultReady(void)),
+        this,
+        SLOT(onSyncResult(void)));
+}
+
+//
+// Words are separated by commas or spaces. A word is either hexadecimal
+// with a 0x prefix (4 bits per digit) or a string of binary digits.
+//
+bool
+SyncWordTab::parseWords(QString const &text, QString &error)
+{
+  QString clean = QString(text).replace(',', ' ').simplified();
+  QStringList tokens;
+  std::vector<uint64_t> words;
+  std::vector<unsigned> lengths;
+
+  // Nothing must match while the configuration is invalid
+  this->wordNames.clear();
+  this->params.words.clear();
+  this->params.lengths.clear();
+
+  if (!clean.isEmpty())
+    tokens = clean.split(' ');
+
+  if (tokens.isEmpty()) {
+    error = "No sync words";
+    return false;
+  }
+
+  if (tokens.size() > SYNC_WORD_MAX_PATTERNS) {
+    error = "Too many sync words (up to "
+        + QString::number(SYNC_WORD_MAX_PATTERNS) + ")";
+    return false;
+  }
+
+  for (auto &token : tokens) {
+    uint64_t word = 0;
+    unsigned int length;
+    bool ok = true;
+
+    if (token.startsWith("0x", Qt::CaseInsensitive)) {
+      QString digits = token.mid(2);
+      length = static_cast<unsigned>(digits.size()) * 4;
+      if (length > 0 && length <= SYNC_WORD_MAX_LENGTH)
+        word = digits.toULongLong(&ok, 16);
+    } else {
+      length = static_cast<unsigned>(token.size());
+      if (length > 0 && length <= SYNC_WORD_MAX_LENGTH)
+        word = token.toULongLong(&ok, 2);
+    }
+
+    if (length == 0 || length > SYNC_WORD_MAX_LENGTH) {
+      error = "Sync word " + token + " must be 1 to "
+          + QString::number(SYNC_WORD_MAX_LENGTH) + " bits long";
+      return false;
+    }
+
+    if (!ok) {
+      error = "Invalid sync word " + token;
+      return false;
+    }
+
+    words.push_back(word);
+    lengths.push_back(length);
+    this->wordNames.append(token);
+  }
+
+  this->params.words   = std::move(words);
+  this->params.lengths = std::move(lengths);
+
+  return true;
+}
+
+void
+SyncWordTab::refreshStatus(void)
+{
+  QString status;
+  int i;
+
+  if (!this->configValid)
+    return;
+
+  for (i = 0; i < this->wordNames.size(); ++i) {
+    quint64 count = static_cast<size_t>(i) < this->result.counts.size()
+        ? this->result.counts[static_cast<size_t>(i)]
+        : 0;
+
+    if (i > 0)
+      status += ", ";
+    status += this->wordNames[i] + ": " + QString::number(count);
+  }
+
+  if (this->dropped > 0)
+    status += " (" + QString::number(this->dropped) + " hits not shown)";
+
+  this->ui->statusLabel->setText(status);
+}
+
+void
+SyncWordTab::appendHit(SyncWordHit const &hit)
+{
+  QTableWidget *table = this->ui->hitsTable;
+  QDateTime date;
+  QString frame;
+  int row;
+
+  if (table->rowCount() >= SYNC_WORD_TAB_MAX_ROWS)
+    table->removeRow(0);
+
+  row = table->rowCount();
+  table->insertRow(row);
+
+  date.setMSecsSinceEpoch(static_cast<qint64>(hit.time * 1000));
+
+  frame.reserve(static_cast<int>(hit.frame.size() * 2));
+  for (auto byte : hit.frame)
+    frame += QString::asprintf("%02x", byte);
+
+  table->setItem(
+        row,
+        0,
+        new QTableWidgetItem(date.toUTC().toString("hh:mm:ss.zzz")));
+  table->setItem(row, 1, new QTableWidgetItem(QString::number(hit.symbol)));
+  table->setItem(
+        row,
+        2,
+        new QTableWidgetItem(
+          (hit.inverted ? "~" : "")
+          + this->wordNames.value(static_cast<int>(hit.pattern))));
+  table->setItem(row, 3, new QTableWidgetItem(QString::number(hit.errors)));
+  table->setItem(row, 4, new QTableWidgetItem(frame));
+}
+
+void
+SyncWordTab::setBitsPerSymbol(unsigned int bps)
+{
+  if (bps != this->bps) {
+    this->bps = bps;
+    this->onConfigChanged();
+  }
+}
+
+void
+SyncWordTab::setTimeStamp(struct timeval const &tv)
+{
+  this->timeStamp = tv;
+}
+
+void
+SyncWordTab::setBaudRate(qreal baud)
+{
+  this->baud = baud;
+}
+
+// The last time stamp is taken as that of the last symbol
+void
+SyncWordTab::feed(const Symbol *data, unsigned int length)
+{
+  this->syncWorker->push(
+        data,
+        length,
+        this->params,
+        this->timeStamp,
+        this->baud);
+}
+
+void
+SyncWordTab::showEvent(QShowEvent *)
+{
+  this->onSyncResult();
+}
+
+/////////////////////////////////////// Slots //////////////////////////////////
+void
+SyncWordTab::onRecord(void)
+{
+  this->recording = this->ui->recordButton->isChecked();
+}
+
+void
+SyncWordTab::onConfigChanged(void)
+{
+  QString error;
+
+  this->params.tolerance = static_cast<unsigned>(this->ui->errorsSpin->value());
+  this->params.frameBits =
+      static_cast<unsigned>(this->ui->frameLenSpin->value());
+  this->params.inverted  = this->ui->invertedCheck->isChecked();
+  this->params.bps       = this->bps;
+
+  this->configValid = this->parseWords(this->ui->syncWordsEdit->text(), error);
+
+  // Counts and symbol positions start over with the new configuration
+  this->syncWorker->reset();
+  this->result.counts.clear();
+  this->dropped = 0;
+
+  if (this->configValid)
+    this->refreshStatus();
+  else
+    this->ui->statusLabel->setText(error);
+}
+
+void
+SyncWordTab::onClear(void)
+{
+  this->ui->hitsTable->setRowCount(0);
+  this->onConfigChanged();
+}
+
+void
+SyncWordTab::onSyncResult(void)
+{
+  // Hits stay in the worker (up to a limit) until someone looks at them
+  if (!this->isVisible())
+    return;
+
+  if (!this->syncWorker->takeResult(this->result))
+    return;
+
+  this->dropped += this->result.dropped;
+
+  for (auto &hit : this->result.hits)
+    this->appendHit(hit);
+
+  if (!this->result.hits.empty()) {
+    this->ui->hitsTable->resizeColumnsToContents();
+    this->ui->hitsTable->scrollToBottom();
+  }
+
+  this->refreshStatus();
+}
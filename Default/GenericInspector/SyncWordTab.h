@@ -0,0 +1,93 @@
+//
+//    SyncWordTab.h: Live sync word search
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SYNCWORDTAB_H
+#define SYNCWORDTAB_H
+
+#include <QWidget>
+#include <sys/time.h>
+#include "SyncWordWorker.h"
+
+// Rows kept in the hit table. Oldest go first.
+#define SYNC_WORD_TAB_MAX_ROWS 1000
+
+class QThread;
+
+namespace Ui {
+  class SyncWordTab;
+}
+
+namespace SigDigger {
+  class SyncWordTab : public QWidget
+  {
+    Q_OBJECT
+
+    QThread *syncThread = nullptr;
+    SyncWordWorker *syncWorker = nullptr;
+    SyncWordParams params;
+    SyncWordResult result;
+    QStringList wordNames;
+
+    struct timeval timeStamp = {0, 0};
+    qreal baud = 0;
+    quint64 dropped = 0;
+    unsigned int bps = 1;
+    bool recording = false;
+    bool configValid = false;
+
+    void connectAll(void);
+    void refreshStatus(void);
+    void appendHit(SyncWordHit const &);
+    bool parseWords(QString const &, QString &error);
+
+  public:
+    explicit SyncWordTab(QWidget *parent = nullptr);
+    ~SyncWordTab();
+
+    void setBitsPerSymbol(unsigned int);
+    void setTimeStamp(struct timeval const &);
+    void setBaudRate(qreal);
+    void feed(const Symbol *data, unsigned int length);
+
+    inline void
+    feed(std::vector<Symbol> const &symVec)
+    {
+      this->feed(symVec.data(), static_cast<unsigned>(symVec.size()));
+    }
+
+    inline bool
+    isRecording(void) const
+    {
+      return this->recording && this->configValid;
+    }
+
+  public slots:
+    void onRecord(void);
+    void onConfigChanged(void);
+    void onClear(void);
+    void onSyncResult(void);
+
+  protected:
+    void showEvent(QShowEvent *event) override;
+
+  private:
+    Ui::SyncWordTab *ui;
+  };
+}
+
+#endif // SYNCWORDTAB_H
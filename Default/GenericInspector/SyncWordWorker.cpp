@@ -0,0 +1,303 @@
+//
+//    SyncWordWorker.cpp: Sync word search off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SyncWordWorker.h"
+#include <sigutils/log.h>
+#include <algorithm>
+#include <bitset>
+
+using namespace SigDigger;
+
+static inline unsigned int
+popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+  return static_cast<unsigned int>(__builtin_popcountll(x));
+#else
+  return static_cast<unsigned int>(std::bitset<64>(x).count());
+#endif
+}
+
+SyncWordWorker::SyncWordWorker(QObject *parent) : QObject(parent)
+{
+  connect(
+        this,
+        SIGNAL(dataPending(void)),
+        this,
+        SLOT(process(void)),
+        Qt::QueuedConnection);
+}
+
+void
+SyncWordWorker::configure(SyncWordParams const &params)
+{
+  unsigned int i, len;
+
+  this->params = params;
+  this->count  = 0;
+
+  if (this->params.bps < 1)
+    this->params.bps = 1;
+
+  for (i = 0; i < params.words.size() && i < SYNC_WORD_MAX_PATTERNS; ++i) {
+    len = std::min(params.lengths[i], SYNC_WORD_MAX_LENGTH + 0u);
+    if (len == 0)
+      continue;
+
+    this->masks[this->count] =
+        len == 64 ? ~UINT64_C(0) : (UINT64_C(1) << len) - 1;
+    this->words[this->count]   = params.words[i] & this->masks[this->count];
+    this->lengths[this->count] = len;
+    ++this->count;
+  }
+
+  this->reg     = 0;
+  this->bits    = 0;
+  this->counts.assign(this->count, 0);
+  this->open.clear();
+  this->hits.clear();
+}
+
+void
+SyncWordWorker::feedBit(unsigned int bit)
+{
+  unsigned int dist[SYNC_WORD_MAX_PATTERNS];
+  unsigned int tol = this->params.tolerance;
+  unsigned int errors, i;
+  bool any = false;
+
+  this->reg = (this->reg << 1) | bit;
+  ++this->bits;
+
+  // Frames in progress. They all have the same length, so they complete
+  // in the same order they were opened.
+  for (auto it = this->open.begin(); it != this->open.end(); ) {
+    if (bit ^ static_cast<unsigned>(it->hit.inverted))
+      it->hit.frame[it->bits >> 3] |= static_cast<uint8_t>(0x80 >> (it->bits & 7));
+
+    if (++it->bits == this->params.frameBits) {
+      this->hits.push_back(std::move(it->hit));
+      it = this->open.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (i = 0; i < this->count; ++i)
+    dist[i] = popcount64((this->reg ^ this->words[i]) & this->masks[i]);
+
+  for (i = 0; i < this->count; ++i)
+    any |= dist[i] <= tol || (this->params.inverted
+                              && this->lengths[i] - dist[i] <= tol);
+
+  if (!any)
+    return;
+
+  for (i = 0; i < this->count; ++i) {
+    SyncWordHit hit;
+
+    // Not enough bits yet to fill the word
+    if (this->bits < this->lengths[i])
+      continue;
+
+    if (dist[i] <= tol) {
+      errors = dist[i];
+    } else if (this->params.inverted && this->lengths[i] - dist[i] <= tol) {
+      errors = this->lengths[i] - dist[i];
+      hit.inverted = true;
+    } else {
+      continue;
+    }
+
+    hit.symbol  = this->bits / this->params.bps;
+    hit.time    = this->batchTime;
+    if (this->batchBaud > 0)
+      hit.time -= static_cast<qreal>(this->batchEnd - hit.symbol)
+          / this->batchBaud;
+    hit.pattern = i;
+    hit.errors  = errors;
+    ++this->counts[i];
+
+    // Report it without a frame if too many are open already
+    if (this->params.frameBits == 0
+        || this->open.size() >= SYNC_WORD_WORKER_MAX_OPEN_FRAMES) {
+      this->hits.push_back(std::move(hit));
+    } else {
+      OpenFrame frame;
+
+      hit.frame.assign((this->params.frameBits + 7) / 8, 0);
+      frame.hit = std::move(hit);
+      this->open.push_back(std::move(frame));
+    }
+  }
+}
+
+void
+SyncWordWorker::publish(void)
+{
+  bool notify = false;
+  size_t excess;
+
+  this->resultMutex.lock();
+
+  this->result.hits.insert(
+        this->result.hits.end(),
+        std::make_move_iterator(this->hits.begin()),
+        std::make_move_iterator(this->hits.end()));
+  this->hits.clear();
+
+  if (this->result.hits.size() > SYNC_WORD_WORKER_MAX_HITS) {
+    excess = this->result.hits.size() - SYNC_WORD_WORKER_MAX_HITS;
+    this->result.hits.erase(
+          this->result.hits.begin(),
+          this->result.hits.begin() + static_cast<long>(excess));
+    this->result.dropped += excess;
+  }
+
+  this->result.counts = this->counts;
+
+  if (!this->announced) {
+    this->announced = true;
+    notify = true;
+  }
+
+  this->resultMutex.unlock();
+
+  if (notify)
+    emit resultReady();
+}
+
+void
+SyncWordWorker::push(
+    const Symbol *data,
+    unsigned int size,
+    SyncWordParams const &params,
+    struct timeval const &timeStamp,
+    qreal baud)
+{
+  bool notify = false;
+
+  this->inputMutex.lock();
+
+  if (this->pending.size() + size > SYNC_WORD_WORKER_MAX_PENDING) {
+    if (this->inputDropped == 0)
+      SU_WARNING("Sync word worker cannot keep up, dropping symbols\n");
+    this->inputDropped += size;
+  } else {
+    this->pending.insert(this->pending.end(), data, data + size);
+    this->pendingBatches.push_back({
+          this->pending.size(),
+          static_cast<qreal>(timeStamp.tv_sec)
+          + 1e-6 * static_cast<qreal>(timeStamp.tv_usec),
+          baud});
+  }
+
+  this->pendingParams = params;
+
+  if (!this->scheduled) {
+    this->scheduled = true;
+    notify = true;
+  }
+
+  this->inputMutex.unlock();
+
+  if (notify)
+    emit dataPending();
+}
+
+void
+SyncWordWorker::reset(void)
+{
+  this->inputMutex.lock();
+  this->pending.clear();
+  this->pendingBatches.clear();
+  this->resetPending = true;
+  this->inputMutex.unlock();
+
+  // Hits of the old configuration are meaningless now
+  this->resultMutex.lock();
+  this->result.hits.clear();
+  this->result.counts.clear();
+  this->result.dropped = 0;
+  this->resultMutex.unlock();
+}
+
+bool
+SyncWordWorker::takeResult(SyncWordResult &dest)
+{
+  QMutexLocker locker(&this->resultMutex);
+  bool haveResult = this->announced;
+
+  if (haveResult) {
+    dest.hits.clear();
+    std::swap(dest.hits, this->result.hits);
+    dest.counts  = this->result.counts;
+    dest.dropped = this->result.dropped;
+    this->result.dropped = 0;
+  }
+
+  this->announced = false;
+
+  return haveResult;
+}
+
+///////////////////////////////// Slots ////////////////////////////////////////
+void
+SyncWordWorker::process(void)
+{
+  SyncWordParams params;
+  unsigned int bps, b;
+  size_t from = 0, i;
+  bool reset;
+
+  this->inputMutex.lock();
+  this->work.clear();
+  this->workBatches.clear();
+  std::swap(this->work, this->pending);
+  std::swap(this->workBatches, this->pendingBatches);
+  params = this->pendingParams;
+  reset  = this->resetPending;
+  this->resetPending = false;
+  this->scheduled = false;
+  this->inputMutex.unlock();
+
+  if (reset)
+    this->configure(params);
+
+  if (this->count == 0 || this->work.empty())
+    return;
+
+  bps = this->params.bps;
+
+  // Hit times are counted back from the end of the batch they are in
+  for (auto const &batch : this->workBatches) {
+    this->batchEnd  = this->bits / bps + (batch.end - from);
+    this->batchTime = batch.time;
+    this->batchBaud = batch.baud;
+
+    for (i = from; i < batch.end; ++i)
+      for (b = bps; b-- > 0; )
+        this->feedBit((static_cast<unsigned>(this->work[i]) >> b) & 1);
+
+    from = batch.end;
+  }
+
+  if (!this->hits.empty())
+    this->publish();
+}
@@ -0,0 +1,146 @@
+//
+//    SyncWordWorker.h: Sync word search off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SYNCWORDWORKER_H
+#define SYNCWORDWORKER_H
+
+#include <QObject>
+#include <QMutex>
+#include <vector>
+#include <cstdint>
+#include <sys/time.h>
+#include <Decider.h>
+
+// Symbols waiting for the worker. Beyond this, new symbols are dropped.
+#define SYNC_WORD_WORKER_MAX_PENDING     (1 << 22)
+
+// Hits waiting for the GUI. Oldest go first.
+#define SYNC_WORD_WORKER_MAX_HITS        1024
+
+// Frames being extracted at the same time (overlapping hits)
+#define SYNC_WORD_WORKER_MAX_OPEN_FRAMES 32
+
+#define SYNC_WORD_MAX_LENGTH             64
+#define SYNC_WORD_MAX_PATTERNS           16
+
+namespace SigDigger {
+  struct SyncWordParams {
+    std::vector<uint64_t> words;   // Right-aligned, first bit is the MSB
+    std::vector<unsigned> lengths; // In bits, up to SYNC_WORD_MAX_LENGTH
+    unsigned int tolerance = 0;    // Bit errors allowed
+    unsigned int frameBits = 0;    // Bits to extract after each hit
+    unsigned int bps       = 1;    // Bits per symbol
+    bool         inverted  = false; // Match the complemented words too
+  };
+
+  struct SyncWordHit {
+    quint64 symbol   = 0;  // Symbol right after the sync word
+    qreal   time     = 0;  // Of that symbol, in seconds since the epoch
+    unsigned pattern = 0;  // Index in SyncWordParams::words
+    unsigned errors  = 0;
+    bool inverted    = false;
+    std::vector<uint8_t> frame; // frameBits bits, MSB first, de-inverted
+  };
+
+  struct SyncWordResult {
+    std::vector<SyncWordHit> hits;
+    std::vector<quint64>     counts; // Per pattern, since the last reset
+    quint64                  dropped = 0;
+  };
+
+  //
+  // Slides every sync word over the bit stream made of the incoming
+  // symbols (MSB first). The last 64 bits live in a shift register, so
+  // each new bit costs one XOR, AND and popcount per word, with the
+  // words laid out in flat arrays and no branches until a hit.
+  //
+  class SyncWordWorker : public QObject
+  {
+    Q_OBJECT
+
+    struct OpenFrame {
+      SyncWordHit hit;
+      unsigned int bits = 0;
+    };
+
+    // Symbols pushed together, stamped with the time of the last one
+    struct Batch {
+      size_t end;  // One past its last symbol in the pending buffer
+      qreal  time;
+      qreal  baud;
+    };
+
+    // Input side, shared with the GUI thread
+    QMutex inputMutex;
+    std::vector<Symbol> pending;
+    std::vector<Batch> pendingBatches;
+    SyncWordParams pendingParams;
+    bool scheduled = false;
+    bool resetPending = true;
+    quint64 inputDropped = 0;
+
+    // Result side, shared with the GUI thread
+    QMutex resultMutex;
+    SyncWordResult result;
+    bool announced = false;
+
+    // Worker-only state
+    SyncWordParams params;
+    std::vector<Symbol> work;
+    std::vector<Batch> workBatches;
+    quint64 batchEnd = 0; // Symbol count at the end of the current batch
+    qreal batchTime = 0;
+    qreal batchBaud = 0;
+    uint64_t words[SYNC_WORD_MAX_PATTERNS];
+    uint64_t masks[SYNC_WORD_MAX_PATTERNS];
+    unsigned int lengths[SYNC_WORD_MAX_PATTERNS];
+    unsigned int count = 0;
+    uint64_t reg = 0;
+    quint64 bits = 0; // Bits shifted in since the last reset
+    std::vector<quint64> counts;
+    std::vector<OpenFrame> open;
+    std::vector<SyncWordHit> hits;
+
+    void configure(SyncWordParams const &);
+    void feedBit(unsigned int bit);
+    void publish(void);
+
+  public:
+    explicit SyncWordWorker(QObject *parent = nullptr);
+
+    // Called from the GUI thread
+    void push(
+        const Symbol *data,
+        unsigned int size,
+        SyncWordParams const &params,
+        struct timeval const &timeStamp,
+        qreal baud);
+    void reset(void);
+    bool takeResult(SyncWordResult &);
+
+  signals:
+    void dataPending(void);
+    void resultReady(void);
+
+  public slots:
+    void process(void);
+  };
+}
+
+#endif // SYNCWORDWORKER_H
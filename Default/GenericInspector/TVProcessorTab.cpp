@@ -594,20 +594,26 @@ TVProcessorTab::feed(const SUCOMPLEX *data, unsigned int size)
 {
   SUFLOAT k = this->ui->invertSyncCheck->isChecked() ? -1 : 1;
   SUFLOAT dc = static_cast<SUFLOAT>(this->ui->dcSpin->value()) / 100;
+  std::vector<SUFLOAT> *buffer = this->tvWorker->acquireBuffer();
 
-  this->floatBuffer.resize(size);
+  // Worker is behind and all buffers are queued. Drop these samples.
+  if (buffer == nullptr) {
+    this->tvWorker->dropSamples(size);
+    return;
+  }
+
+  buffer->resize(size);
 
   if (this->decisionMode == Decider::MODULUS) {
     for (unsigned i = 0; i < size; ++i)
-      this->floatBuffer[i] = k * SU_C_ABS(data[i]) + dc;
+      (*buffer)[i] = k * SU_C_ABS(data[i]) + dc;
   } else {
     for (unsigned i = 0; i < size; ++i)
-      this->floatBuffer[i] = k * SU_C_ARG(data[i]) / PI + dc;
+      (*buffer)[i] = k * SU_C_ARG(data[i]) / PI + dc;
   }
 
-  this->tvWorker->pushData(this->floatBuffer);
-
-  emit tvProcessorData();
+  if (this->tvWorker->pushBuffer(buffer))
+    emit tvProcessorData();
 }
 
 
@@ -649,8 +655,14 @@ void
 TVProcessorTab::onTVProcessorFrame(struct sigutils_tv_frame_buffer *frame)
 {
   this->tvWorker->acknowledgeFrame();
-  this->ui->tvDisplay->putFrame(frame);
-  this->ui->tvDisplay->invalidate();
+
+  // The processor keeps running (and in sync) while hidden. Only the
+  // drawing is skipped.
+  if (this->isVisible()) {
+    this->ui->tvDisplay->putFrame(frame);
+    this->ui->tvDisplay->invalidate();
+  }
+
   emit tvProcessorDisposeFrame(frame);
 }
 
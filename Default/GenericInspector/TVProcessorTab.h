@@ -41,7 +41,6 @@ namespace SigDigger {
 
     TVProcessorWorker *tvWorker = nullptr;
     QThread *tvThread = nullptr;
-    std::vector<SUFLOAT> floatBuffer;
 
     void connectAll(void);
     void emitParameters(void);
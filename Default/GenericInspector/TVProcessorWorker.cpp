@@ -18,6 +18,7 @@
 //
 
 #include "TVProcessorWorker.h"
+#include <sigutils/log.h>
 #include <algorithm>
 
 using namespace SigDigger;
@@ -32,129 +33,107 @@ TVProcessorWorker::TVProcessorWorker(QObject *parent) : QObject(parent)
     qRegisterMetaType<sigutils_tv_processor_params>();
     typesRegistered = true;
   }
+
+  for (auto &buffer : this->pool)
+    this->freeRing.push(&buffer);
+
+  this->scheduled.storeRelease(0);
 }
 
 TVProcessorWorker::~TVProcessorWorker()
 {
-  std::vector<SUFLOAT> *entry = nullptr;
-
   this->stop();
-
-  while ((entry = popFromList(this->pendingList)) != nullptr)
-    delete entry;
-
-  while ((entry = popFromList(this->freeList)) != nullptr)
-    delete entry;
 }
 
-
 std::vector<SUFLOAT> *
-TVProcessorWorker::popFromList(std::list<std::vector<SUFLOAT> *> &list)
+TVProcessorWorker::acquireBuffer(void)
 {
   std::vector<SUFLOAT> *entry;
 
-  if (list.empty())
+  if (!this->freeRing.pop(entry))
     return nullptr;
 
-  entry = list.front();
-
-  list.pop_front();
-
   return entry;
 }
 
-std::vector<SUFLOAT> *
-TVProcessorWorker::allocBuffer(std::vector<SUFLOAT> &buffer)
+bool
+TVProcessorWorker::pushBuffer(std::vector<SUFLOAT> *buffer)
 {
-  std::vector<SUFLOAT> *entry;
-
-  this->pendingDataMutex.lock();
-  entry = popFromList(this->freeList);
-  this->pendingDataMutex.unlock();
-
-  if (entry == nullptr)
-    entry = new std::vector<SUFLOAT>;
+  // Cannot fail: there are as many slots as buffers in the pool
+  this->pendingRing.push(buffer);
 
-  *entry = std::move(buffer);
-
-  return entry;
+  return this->scheduled.testAndSetOrdered(0, 1);
 }
 
 void
-TVProcessorWorker::putPendingBuffer(std::vector<SUFLOAT> *buffer)
+TVProcessorWorker::dropSamples(SUSCOUNT size)
 {
-  this->pendingDataMutex.lock();
-  this->pendingList.push_back(buffer);
-  this->pendingDataMutex.unlock();
+  if (this->inputDropped == 0)
+    SU_WARNING("TV worker cannot keep up, dropping samples\n");
+  this->inputDropped += size;
 }
 
-std::vector<SUFLOAT> *
-TVProcessorWorker::takePendingBuffer(void)
+void
+TVProcessorWorker::drainPending(void)
 {
   std::vector<SUFLOAT> *entry;
 
-  this->pendingDataMutex.lock();
-  entry = popFromList(this->pendingList);
-  this->pendingDataMutex.unlock();
-
-  return entry;
+  while (this->pendingRing.pop(entry))
+    this->freeRing.push(entry);
 }
 
-void
-TVProcessorWorker::disposeBuffer(std::vector<SUFLOAT> *buffer)
+bool
+TVProcessorWorker::trySendFrame(void)
 {
-  this->pendingDataMutex.lock();
-  this->freeList.push_back(buffer);
-  this->pendingDataMutex.unlock();
-}
+  SUSCOUNT currAck, diff;
 
-void
-TVProcessorWorker::pushData(std::vector<SUFLOAT> &data)
-{
-  std::vector<SUFLOAT> *entry = this->allocBuffer(data);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+  currAck = this->frameAck.loadRelaxed();
+#else
+  currAck = this->frameAck.load();
+#endif // QT_VERSION
+
+  if (currAck > this->frameCount)
+    this->frameCount = currAck;
+
+  diff = this->frameCount - currAck;
+
+  if (this->blocked)
+    this->blocked = diff > TV_PROCESSOR_WORKER_MIN_NACK_RESTART;
+  else
+    this->blocked = diff > TV_PROCESSOR_WORKER_MAX_NACK_FRAMES;
 
-  this->putPendingBuffer(entry);
+  if (this->blocked)
+    return false;
+
+  ++this->frameCount;
+  emit frame(su_tv_processor_take_frame(this->processor));
+
+  return true;
 }
 
 void
 TVProcessorWorker::work(const SUFLOAT *samples, SUSCOUNT size)
 {
-  SUSCOUNT currAck, diff;
+  su_tv_processor_t *processor = this->processor;
+  SUSCOUNT i = 0;
   bool frameSent = false;
 
-  if (this->processor != nullptr) {
-    if (size > this->maxProcessingBlock) {
-      size = this->maxProcessingBlock;
-    }
-
-    while (size-- > 0) {
-      if (su_tv_processor_feed(this->processor, *samples++)) {
-        if (!frameSent) {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-          currAck = this->frameAck.loadRelaxed();
-#else
-          currAck = this->frameAck.load();
-#endif // QT_VERSION
-
-          if (currAck > this->frameCount)
-            this->frameCount = currAck;
+  if (processor == nullptr)
+    return;
 
-          diff = this->frameCount - currAck;
+  if (size > this->maxProcessingBlock)
+    size = this->maxProcessingBlock;
 
-          if (this->blocked)
-            this->blocked = diff > TV_PROCESSOR_WORKER_MIN_NACK_RESTART;
-          else
-            this->blocked = diff > TV_PROCESSOR_WORKER_MAX_NACK_FRAMES;
+  // At most one frame per block. Until it is sent, every completed frame
+  // is a candidate.
+  while (i < size && !frameSent)
+    if (su_tv_processor_feed(processor, samples[i++]))
+      frameSent = this->trySendFrame();
 
-          if (!this->blocked) {
-            ++this->frameCount;
-            emit frame(su_tv_processor_take_frame(this->processor));
-            frameSent = true;
-          }
-        }
-      }
-    }
-  }
+  // The rest of the block only advances the processor state
+  while (i < size)
+    su_tv_processor_feed(processor, samples[i++]);
 }
 
 void
@@ -168,8 +147,6 @@ TVProcessorWorker::acknowledgeFrame(void)
 void
 TVProcessorWorker::stop(void)
 {
-  std::vector<SUFLOAT> *entry;
-
   if (this->processor != nullptr) {
     su_tv_processor_destroy(this->processor);
     this->processor = nullptr;
@@ -178,8 +155,7 @@ TVProcessorWorker::stop(void)
     this->blocked = false;
   }
 
-  while ((entry = this->takePendingBuffer()))
-    this->disposeBuffer(entry);
+  this->drainPending();
 }
 
 void
@@ -195,13 +171,19 @@ TVProcessorWorker::start(void)
 void
 TVProcessorWorker::process()
 {
-  if (this->processor != nullptr) {
-    std::vector<SUFLOAT> *entry;
+  std::vector<SUFLOAT> *entry;
+
+  // Clear first: buffers pushed from now on need a new process() call
+  this->scheduled.storeRelease(0);
+
+  if (this->processor == nullptr) {
+    this->drainPending();
+    return;
+  }
 
-    while ((entry = this->takePendingBuffer()) != nullptr) {
-      this->work(entry->data(), entry->size());
-      this->disposeBuffer(entry);
-    }
+  while (this->pendingRing.pop(entry)) {
+    this->work(entry->data(), entry->size());
+    this->freeRing.push(entry);
   }
 }
 
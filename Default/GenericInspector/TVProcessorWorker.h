@@ -25,13 +25,16 @@
 #include <sigutils/types.h>
 #include <sigutils/tvproc.h>
 #include <QAtomicInteger>
-#include <QMutex>
-#include <list>
+#include <SPSCRing.h>
 
 #define TV_PROCESSOR_WORKER_MAX_NACK_FRAMES   100
 #define TV_PROCESSOR_WORKER_MIN_NACK_RESTART   50
 #define TV_PROCESSOR_MAX_PENDING_FRAMES       120
 
+// Sample buffers in flight between the GUI and the worker. When all of
+// them are queued, the GUI drops samples instead of allocating more.
+#define TV_PROCESSOR_WORKER_POOL_SIZE          32
+
 namespace SigDigger {
   class TVProcessorWorker : public QObject
   {
@@ -40,9 +43,16 @@ namespace SigDigger {
     struct sigutils_tv_processor_params defaultParams;
     su_tv_processor_t *processor = nullptr;
 
-    QMutex pendingDataMutex;
-    std::list<std::vector<SUFLOAT> *> freeList;
-    std::list<std::vector<SUFLOAT> *> pendingList;
+    // Buffers cycle GUI -> pendingRing -> worker -> freeRing -> GUI. Their
+    // storage is kept across cycles, so steady state does not allocate.
+    typedef SPSCRing<std::vector<SUFLOAT> *, TV_PROCESSOR_WORKER_POOL_SIZE>
+      BufferRing;
+
+    std::vector<SUFLOAT> pool[TV_PROCESSOR_WORKER_POOL_SIZE];
+    BufferRing freeRing;
+    BufferRing pendingRing;
+    QAtomicInteger<int> scheduled;
+    quint64 inputDropped = 0; // GUI side only
 
     bool blocked = false;
     SUSCOUNT frameCount = 0;
@@ -50,22 +60,24 @@ namespace SigDigger {
 
     QAtomicInteger<SUSCOUNT> frameAck = 0;
 
-    std::vector<SUFLOAT> *allocBuffer(std::vector<SUFLOAT> &);
-    void putPendingBuffer(std::vector<SUFLOAT> *);
-    std::vector<SUFLOAT> *takePendingBuffer(void);
-    void disposeBuffer(std::vector<SUFLOAT> *);
-
     void work(const SUFLOAT *samples, SUSCOUNT size);
-
-    static std::vector<SUFLOAT> *popFromList(
-        std::list<std::vector<SUFLOAT> *> &list);
+    bool trySendFrame(void);
+    void drainPending(void);
 
   public:
     explicit TVProcessorWorker(QObject *parent = nullptr);
     ~TVProcessorWorker();
 
     void acknowledgeFrame(void);
-    void pushData(std::vector<SUFLOAT> &data);
+
+    // GUI side. Fill the buffer returned by acquireBuffer() (nullptr if
+    // the worker is behind) and hand it back with pushBuffer(). If the
+    // latter returns true, the process() slot must be triggered.
+    std::vector<SUFLOAT> *acquireBuffer(void);
+    bool pushBuffer(std::vector<SUFLOAT> *buffer);
+
+    // Samples that could not be queued because the pool ran out
+    void dropSamples(SUSCOUNT size);
 
     //
     // FIXME: assume that signals may be lost.
@@ -4,10 +4,12 @@
 #include "SuWidgetsHelpers.h"
 #include <sigutils/types.h>
 #include <string>
+#include <algorithm>
 
 using namespace SigDigger;
 
 #define WAVEFORM_TAB_MAX_SELECTION     4096
+#define WAVEFORM_TAB_CHUNK_SIZE        (1 << 20)
 
 #ifdef __APPLE__
 static void
@@ -55,6 +57,7 @@ WaveformTab::WaveformTab(QWidget *parent) :
   this->ui->realWaveform->setData(&this->buffer, true);
   this->ui->imagWaveform->setData(&this->buffer, true);
 
+  this->onStorageSettingsChanged();
   this->refreshUi();
   this->refreshMeasures();
   SigDiggerHelpers::instance()->populatePaletteCombo(this->ui->paletteCombo);
@@ -91,20 +94,65 @@ WaveformTab::setSampleRate(qreal rate)
 }
 
 void
-WaveformTab::feed(const SUCOMPLEX *data, unsigned int size)
+WaveformTab::reserveFor(size_t size)
 {
-  size_t prevSize = this->buffer.size();
-  qreal prevDuration = prevSize / this->fs;
-  qreal currDuration;
+  size_t capacity = this->buffer.capacity();
+
+  if (size <= capacity)
+    return;
+
+  // Grow geometrically, in whole chunks, and never past the limit
+  capacity = std::max(2 * capacity, size);
+  capacity = WAVEFORM_TAB_CHUNK_SIZE
+      * ((capacity + WAVEFORM_TAB_CHUNK_SIZE - 1) / WAVEFORM_TAB_CHUNK_SIZE);
+
+  if (capacity > this->maxSamples)
+    capacity = std::max(this->maxSamples, size);
+
+  this->buffer.reserve(capacity);
+}
+
+size_t
+WaveformTab::discardOldest(size_t needed)
+{
+  // Discard an eighth of the limit at least, so that the cost of moving
+  // the remaining samples is paid once every many feeds.
+  size_t drop = std::max(needed, this->maxSamples / 8);
 
-  this->buffer.resize(prevSize + size);
-  memcpy(this->buffer.data() + prevSize, data, size * sizeof (SUCOMPLEX));
+  drop = std::min(drop, this->buffer.size());
 
-  currDuration = this->buffer.size() / this->fs;
+  this->buffer.erase(
+        this->buffer.begin(),
+        this->buffer.begin() + static_cast<long>(drop));
+
+  return drop;
+}
+
+void
+WaveformTab::presentData(size_t prevSize, size_t dropped)
+{
+  qreal prevDuration = prevSize / this->fs;
+  qreal currDuration = this->buffer.size() / this->fs;
 
   this->ui->realWaveform->setData(&this->buffer, true);
   this->ui->imagWaveform->setData(&this->buffer, true);
 
+  // Keep looking at the same samples after the oldest ones went away
+  if (dropped > 0) {
+    qint64 start =
+        this->ui->realWaveform->getSampleStart() - static_cast<qint64>(dropped);
+    qint64 end =
+        this->ui->realWaveform->getSampleEnd() - static_cast<qint64>(dropped);
+
+    if (start < 0) {
+      end  -= start;
+      start = 0;
+    }
+
+    this->ui->realWaveform->zoomHorizontal(start, end);
+    this->ui->imagWaveform->zoomHorizontal(start, end);
+  }
+
   if (prevSize == 0) {
     this->onFit();
     this->ui->realWaveform->zoomHorizontal(
@@ -131,6 +179,86 @@ WaveformTab::feed(const SUCOMPLEX *data, unsigned int size)
   }
 }
 
+void
+WaveformTab::feed(const SUCOMPLEX *data, unsigned int size)
+{
+  size_t prevSize, dropped = 0;
+  bool full = false;
+
+  if (size > this->maxSamples) {
+    data += size - this->maxSamples;
+    size  = static_cast<unsigned int>(this->maxSamples);
+  }
+
+  if (this->buffer.size() + size > this->maxSamples) {
+    if (this->keepLatest) {
+      dropped = this->discardOldest(
+            this->buffer.size() + size - this->maxSamples);
+    } else {
+      size = static_cast<unsigned int>(
+            this->maxSamples - this->buffer.size());
+      full = true;
+    }
+  }
+
+  prevSize = this->buffer.size();
+
+  this->reserveFor(prevSize + size);
+  this->buffer.insert(this->buffer.end(), data, data + size);
+
+  // Nobody is looking. Keep the samples, and update the waveforms (which
+  // rebuilds their envelope trees) once we are shown again.
+  if (!this->isVisible()) {
+    if (!this->presentPending) {
+      this->presentPending = true;
+      this->pendingPrevSize = prevSize;
+      this->pendingDropped  = dropped;
+    } else {
+      this->pendingPrevSize -= std::min(this->pendingPrevSize, dropped);
+      this->pendingDropped  += dropped;
+    }
+  } else {
+    if (this->presentPending) {
+      this->presentPending = false;
+      prevSize = this->pendingPrevSize - std::min(this->pendingPrevSize, dropped);
+      dropped += this->pendingDropped;
+    }
+
+    this->presentData(prevSize, dropped);
+  }
+
+  if (full) {
+    this->ui->recordButton->setChecked(false);
+    this->onRecord();
+  }
+}
+
+void
+WaveformTab::setMemoryLimit(unsigned int mib)
+{
+  this->ui->memoryLimitSpin->setValue(static_cast<int>(mib));
+  this->onStorageSettingsChanged();
+}
+
+void
+WaveformTab::setKeepLatest(bool keep)
+{
+  this->ui->keepLatestCheck->setChecked(keep);
+  this->onStorageSettingsChanged();
+}
+
+unsigned int
+WaveformTab::getMemoryLimit(void) const
+{
+  return static_cast<unsigned int>(this->ui->memoryLimitSpin->value());
+}
+
+bool
+WaveformTab::getKeepLatest(void) const
+{
+  return this->ui->keepLatestCheck->isChecked();
+}
+
 void
 WaveformTab::setPalette(std::string const &name)
 {
@@ -380,6 +508,18 @@ WaveformTab::connectAll(void)
         this,
         SLOT(onChangePaletteContrast(int)));
 
+  connect(
+        this->ui->memoryLimitSpin,
+        SIGNAL(editingFinished(void)),
+        this,
+        SLOT(onStorageSettingsChanged(void)));
+
+  connect(
+        this->ui->keepLatestCheck,
+        SIGNAL(toggled(bool)),
+        this,
+        SLOT(onStorageSettingsChanged(void)));
+
   connectFineTuneSelWidgets();
 }
 
@@ -511,7 +651,9 @@ WaveformTab::clear(void)
   this->ui->realWaveform->setSampleRate(this->fs);
   this->ui->imagWaveform->setSampleRate(this->fs);
 
-  this->buffer.clear();
+  // Give the memory back, not just the samples
+  std::vector<SUCOMPLEX>().swap(this->buffer);
+  this->presentPending = false;
 
   this->ui->realWaveform->setData(nullptr);
   this->ui->imagWaveform->setData(nullptr);
@@ -522,6 +664,15 @@ WaveformTab::~WaveformTab()
   delete ui;
 }
 
+void
+WaveformTab::showEvent(QShowEvent *)
+{
+  if (this->presentPending) {
+    this->presentPending = false;
+    this->presentData(this->pendingPrevSize, this->pendingDropped);
+  }
+}
+
 //////////////////////////////////// Slots ////////////////////////////////////
 void
 WaveformTab::onHZoom(qint64 min, qint64 max)
@@ -954,3 +1105,26 @@ WaveformTab::onClear(void)
 {
   this->clear();
 }
+
+void
+WaveformTab::onStorageSettingsChanged(void)
+{
+  this->maxSamples =
+      (static_cast<size_t>(this->ui->memoryLimitSpin->value()) << 20)
+      / sizeof(SUCOMPLEX);
+  this->keepLatest = this->ui->keepLatestCheck->isChecked();
+
+  // The limit went below what we have. Keep the most recent samples.
+  if (this->buffer.size() > this->maxSamples) {
+    this->buffer.erase(
+          this->buffer.begin(),
+          this->buffer.end() - static_cast<long>(this->maxSamples));
+    this->buffer.shrink_to_fit();
+
+    this->ui->realWaveform->setData(&this->buffer, true);
+    this->ui->imagWaveform->setData(&this->buffer, true);
+    this->refreshMeasures();
+  }
+
+  emit storageSettingsChanged();
+}
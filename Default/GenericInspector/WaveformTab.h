@@ -19,8 +19,15 @@ namespace SigDigger {
 
     qreal fs = 1;
     std::vector<SUCOMPLEX> buffer;
+    size_t maxSamples = 0;
+    bool keepLatest = false;
     bool recording = false;
 
+    // Display updates held back while the tab is hidden
+    bool presentPending = false;
+    size_t pendingPrevSize = 0;
+    size_t pendingDropped = 0;
+
     bool hadSelectionBefore = true; // Yep. This must be true.
     bool adjusting = false;
     bool firstShow = true;
@@ -45,6 +52,10 @@ namespace SigDigger {
     void connectAll(void);
     void clear(void);
 
+    void reserveFor(size_t);
+    size_t discardOldest(size_t);
+    void presentData(size_t prevSize, size_t dropped);
+
   public:
     explicit WaveformTab(QWidget *parent = 0);
     ~WaveformTab();
@@ -56,6 +67,12 @@ namespace SigDigger {
     void setPaletteOffset(unsigned int offset);
     void setPaletteContrast(int contrast);
 
+    void setMemoryLimit(unsigned int);
+    void setKeepLatest(bool);
+
+    unsigned int getMemoryLimit(void) const;
+    bool getKeepLatest(void) const;
+
     std::string getPalette(void) const;
     unsigned int getPaletteOffset(void) const;
     int getPaletteContrast(void) const;
@@ -68,6 +85,9 @@ namespace SigDigger {
 
     void feed(const SUCOMPLEX *, unsigned int);
 
+  signals:
+    void storageSettingsChanged(void);
+
   public slots:
     void onHZoom(qint64 min, qint64 max);
     void onVZoom(qreal min, qreal max);
@@ -101,6 +121,11 @@ namespace SigDigger {
 
     void onFineTuneSelectionClicked(void);
 
+    void onStorageSettingsChanged(void);
+
+  protected:
+    void showEvent(QShowEvent *event) override;
+
   private:
     Ui::WaveformTab *ui;
   };
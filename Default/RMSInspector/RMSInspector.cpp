@@ -18,13 +18,15 @@
 //
 #include "RMSInspector.h"
 #include "RMSViewTab.h"
+#include "RMSLogWriter.h"
+#include "RMSLog.h"
 #include "ui_RMSInspector.h"
 #include "SuWidgetsHelpers.h"
 #include "UIMediator.h"
 #include "Default/FFT/FFTWidget.h"
 #include "SigDiggerHelpers.h"
-#include <sys/stat.h>
 #include <QFileDialog>
+#include <QThread>
 
 // I will never accept this
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
@@ -53,6 +55,7 @@ RMSInspectorConfig::deserialize(Suscan::Object const &conf)
   LOAD(logFormat);
   LOAD(host);
   LOAD(port);
+  LOAD(bands);
 }
 
 Suscan::Object &&
@@ -75,6 +78,7 @@ RMSInspectorConfig::serialize(void)
   STORE(logFormat);
   STORE(host);
   STORE(port);
+  STORE(bands);
 
   return this->persist(obj);
 }
@@ -159,6 +163,24 @@ RMSInspector::connectAll()
         SIGNAL(viewTypeChanged()),
         this,
         SLOT(onRMSTabViewChanged()));
+
+  connect(
+        ui->addBandButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onAddBand()));
+
+  connect(
+        ui->removeBandButton,
+        SIGNAL(clicked(bool)),
+        this,
+        SLOT(onRemoveBand()));
+
+  connect(
+        ui->bandTable,
+        SIGNAL(itemChanged(QTableWidgetItem *)),
+        this,
+        SLOT(onBandEdited()));
 }
 
 RMSInspector::RMSInspector(
@@ -209,6 +231,9 @@ RMSInspector::RMSInspector(
   registerDataSaver(
         "TCP socket forwarding",
         suscli_datasaver_params_init_tcp);
+  registerDataSaver(
+        "SigDigger binary power log",
+        sigdigger_rms_log_params_init);
   connectAll();
 
   updateMaxSamples();
@@ -227,8 +252,7 @@ RMSInspector::closeRequested()
 
 RMSInspector::~RMSInspector()
 {
-  if (m_datasaver != nullptr)
-    suscli_datasaver_destroy(m_datasaver);
+  this->stopLogWriter(true);
 
   if (m_datasaverParams != nullptr)
     hashlist_destroy(m_datasaverParams);
@@ -281,46 +305,244 @@ RMSInspector::pushPowerSample(qreal mean)
 
     ++m_updates;
 
-    if (m_datasaver != nullptr) {
+    if (m_logWriter != nullptr) {
+      m_logWriter->push(tv, SU_ASFLOAT(mean));
+
       gettimeofday(&currTv, nullptr);
       timersub(&currTv, &m_lastUpdate, &diff);
 
       if (diff.tv_sec >= 1) {
-        struct stat sbuf;
         m_lastUpdate = currTv;
+        this->refreshLogSize();
+      }
+    }
+  }
+}
 
-        if (stat(m_fullPathStd.c_str(), &sbuf) != -1) {
-          ui->sizeLabel->setText(
-                SuWidgetsHelpers::formatBinaryQuantity(sbuf.st_size));
-        } else {
-          ui->sizeLabel->setText(QString::number(m_updates) + " points");
-        }
+void
+RMSInspector::refreshLogSize()
+{
+  RMSLogStats stats = m_logWriter->getStats();
+  QString text;
 
-      }
+  // Sampled by the writer thread, no syscalls here
+  if (stats.size >= 0)
+    text = SuWidgetsHelpers::formatBinaryQuantity(stats.size);
+  else
+    text = QString::number(stats.written) + " points";
+
+  if (stats.dropped > 0)
+    text += " (" + QString::number(stats.dropped) + " dropped)";
+
+  ui->sizeLabel->setText(text);
+}
+
+void
+RMSInspector::startLogWriter(
+    suscli_datasaver *datasaver,
+    std::string const &path)
+{
+  m_logThread = new QThread();
+  m_logWriter = new RMSLogWriter(datasaver, path);
+  m_logWriter->moveToThread(m_logThread);
+
+  connect(
+        m_logThread,
+        &QThread::finished,
+        m_logWriter,
+        &QObject::deleteLater);
+
+  connect(
+        m_logThread,
+        &QThread::finished,
+        m_logThread,
+        &QObject::deleteLater);
 
-      if (!suscli_datasaver_write_timestamp(
-            m_datasaver,
-            &tv,
-            SU_ASFLOAT(mean))) {
-        // Delete datalogger
-        suscli_datasaver_destroy(m_datasaver);
-        m_datasaver = nullptr;
+  connect(
+        m_logWriter,
+        SIGNAL(failed()),
+        this,
+        SLOT(onLogWriterFailed()),
+        Qt::QueuedConnection);
 
-        ui->currentFileLabel->setText("N/A");
-        ui->sizeLabel->setText("0 bytes");
+  m_logThread->start();
+}
 
-        ui->logCheck->setChecked(false);
-        m_uiConfig->logData = false;
+void
+RMSInspector::stopLogWriter(bool wait)
+{
+  // The writer flushes what is left and closes the datasaver on its way out
+  if (m_logThread != nullptr) {
+    QThread *thread = m_logThread;
+
+    m_logWriter->disconnect(this);
+    thread->quit();
+    m_logThread = nullptr;
+    m_logWriter = nullptr;
+
+    // The process may be about to exit. Do not let it go before the log
+    // is complete (at most one full queue to write).
+    if (wait) {
+      thread->wait();
+      delete thread;
+    }
+  }
+}
+
+// Every row gets an id, so that its plot follows it around the table
+void
+RMSInspector::setBandRow(int row, SpectrumBand const &band)
+{
+  QTableWidgetItem *name = new QTableWidgetItem(band.name);
+  QTableWidgetItem *power = new QTableWidgetItem("N/A");
+
+  name->setData(Qt::UserRole, m_nextBandId++);
+  power->setFlags(power->flags() & ~Qt::ItemIsEditable);
+
+  ui->bandTable->setItem(row, 0, name);
+  ui->bandTable->setItem(
+        row,
+        1,
+        new QTableWidgetItem(QString::number(band.offset)));
+  ui->bandTable->setItem(
+        row,
+        2,
+        new QTableWidgetItem(QString::number(band.bandwidth)));
+  ui->bandTable->setItem(row, 3, power);
+}
+
+void
+RMSInspector::populateBandTable(std::vector<SpectrumBand> const &bands)
+{
+  bool blocked = ui->bandTable->blockSignals(true);
+  int row;
+
+  ui->bandTable->setRowCount(SCAST(int, bands.size()));
+
+  for (row = 0; row < SCAST(int, bands.size()); ++row)
+    setBandRow(row, bands[SCAST(size_t, row)]);
+
+  ui->bandTable->blockSignals(blocked);
+}
+
+void
+RMSInspector::applyBands()
+{
+  std::vector<SpectrumBand> bands;
+  std::map<int, RMSViewTab *> tabs;
+  int row;
+
+  m_bandRows.clear();
+  m_bandTabs.clear();
+
+  // Rows that do not parse keep their plot, but are not measured until
+  // fixed. Plots of removed rows go away.
+  for (row = 0; row < ui->bandTable->rowCount(); ++row) {
+    SpectrumBand band;
+    RMSViewTab *tab;
+    bool okOffset = false, okBw = false;
+    int id;
+
+    if (ui->bandTable->item(row, 0) == nullptr
+        || ui->bandTable->item(row, 1) == nullptr
+        || ui->bandTable->item(row, 2) == nullptr)
+      continue;
+
+    id             = ui->bandTable->item(row, 0)->data(Qt::UserRole).toInt();
+    band.name      = ui->bandTable->item(row, 0)->text();
+    band.offset    = ui->bandTable->item(row, 1)->text().toDouble(&okOffset);
+    band.bandwidth = ui->bandTable->item(row, 2)->text().toDouble(&okBw);
+
+    auto it = m_bandTabsById.find(id);
+    if (it != m_bandTabsById.end()) {
+      tab = it->second;
+      m_bandTabsById.erase(it);
+    } else {
+      tab = new RMSViewTab(nullptr, nullptr);
+
+      tab->setColorConfig(m_colors);
+      tab->setSampleRate(m_bandTabRate);
+      tab->setLogScale(true);
+      tab->setAutoFit(true);
+
+      ui->tabWidget->addTab(tab, "Band: " + band.name);
+    }
 
-        refreshUi();
+    tabs[id] = tab;
 
-        QMessageBox::warning(
-              this,
-              "Datasaver closed",
-              "The current data logger closed unexpectedly. Open the log window for details");
+    if (okOffset && okBw && band.bandwidth > 0) {
+      bands.push_back(band);
+      m_bandRows.push_back(row);
+      m_bandTabs.push_back(tab);
+      ui->tabWidget->setTabText(
+            ui->tabWidget->indexOf(tab),
+            "Band: " + band.name);
+    }
+  }
+
+  // Whatever is left belongs to rows that no longer exist
+  for (auto &p : m_bandTabsById)
+    delete p.second;
+
+  m_bandTabsById.swap(tabs);
+  m_bandMeter.setBands(bands);
+
+  // Band plots share one budget, so that adding bands does not add memory
+  for (auto &p : m_bandTabsById)
+    p.second->setHistoryMemory(
+          RMS_INSPECTOR_BAND_HISTORY_MEMORY / m_bandTabsById.size());
+
+  if (m_uiConfig != nullptr)
+    m_uiConfig->bands = SpectrumBandMeter::serialize(bands);
+
+  onTabChanged();
+}
+
+void
+RMSInspector::feedBands()
+{
+  std::vector<SUFLOAT> const &powers = m_bandMeter.powers();
+  struct timeval tv, diff;
+  qreal t, dt;
+
+  if (m_analyzer == nullptr || powers.empty())
+    return;
+
+  tv = m_analyzer->getSourceTimeStamp();
+  t  = SCAST(qreal, tv.tv_sec) + 1e-6 * SCAST(qreal, tv.tv_usec);
+
+  // Spectrum updates are the sample rate of the band plots
+  if (m_haveLastSpectrum) {
+    timersub(&tv, &m_lastSpectrum, &diff);
+    dt = SCAST(qreal, diff.tv_sec) + 1e-6 * SCAST(qreal, diff.tv_usec);
+
+    if (dt > 0 && dt < 10) {
+      m_spectrumRate = .9 * m_spectrumRate + .1 / dt;
+
+      if (fabs(m_spectrumRate - m_bandTabRate) > .05 * m_bandTabRate) {
+        m_bandTabRate = m_spectrumRate;
+        for (auto &p : m_bandTabsById)
+          p.second->setSampleRate(m_bandTabRate);
       }
     }
   }
+
+  m_lastSpectrum = tv;
+  m_haveLastSpectrum = true;
+
+  for (size_t i = 0; i < powers.size() && i < m_bandTabs.size(); ++i)
+    if (m_bandTabs[i]->running())
+      m_bandTabs[i]->feed(t, SCAST(qreal, powers[i]));
+
+  if (ui->tabWidget->currentWidget() == ui->bandsTab) {
+    bool blocked = ui->bandTable->blockSignals(true);
+
+    for (size_t i = 0; i < powers.size(); ++i)
+      ui->bandTable->item(m_bandRows[i], 3)->setText(
+            QString::number(SU_POWER_DB_RAW(powers[i]), 'f', 2));
+
+    ui->bandTable->blockSignals(blocked);
+  }
 }
 
 void
@@ -350,7 +572,7 @@ RMSInspector::feedSpectrum(
     m_lastRate = rate;
   }
 
-  m_fftData.resize(len);
+  // The waterfall keeps pointing to this buffer, so it must be ours
   m_fftData.assign(data, data + len);
 
   WATERFALL_CALL(setNewFftData(
@@ -477,7 +699,10 @@ RMSInspector::setColorConfig(ColorConfig const &cfg)
       font-family: Monospace; \
       font-weight: bold;";
 
+  m_colors = cfg;
   m_rmsTab->setColorConfig(cfg);
+  for (auto &p : m_bandTabsById)
+    p.second->setColorConfig(cfg);
 
   ui->freqLcd->setBackgroundColor(cfg.lcdBackground);
   ui->freqLcd->setForegroundColor(cfg.lcdForeground);
@@ -511,8 +736,13 @@ RMSInspector::inspectorMessage(Suscan::InspectorMessage const &msg)
       len = msg.getSpectrumLength();
       p = len / 2;
 
-      for (auto i = 0u; i < len; ++i)
-        data[i] = SU_POWER_DB(data[i]);
+      // Bands are measured while converting to dB, on the raw spectrum
+      m_bandMeter.measureAndConvert(data, len, msg.getSpectrumRate());
+      feedBands();
+
+      // The spectrum may be on only because of the bands
+      if (ui->tabWidget->currentWidget() != ui->tabChannel)
+        break;
 
       for (auto i = 0u; i < len / 2; ++i) {
         x = data[i];
@@ -579,7 +809,7 @@ RMSInspector::refreshUi()
 
   ui->stackedWidget->setCurrentIndex(page);
 
-  haveDataLogger = m_datasaver != nullptr;
+  haveDataLogger = m_logWriter != nullptr;
 
   ui->tabWidget->setTabText(
         ui->tabWidget->indexOf(ui->loggingTab),
@@ -634,10 +864,15 @@ RMSInspector::applyConfig()
     ui->formatCombo->setCurrentIndex(2);
   else if (m_uiConfig->logFormat == "tcp")
     ui->formatCombo->setCurrentIndex(3);
+  else if (m_uiConfig->logFormat == "rmslog")
+    ui->formatCombo->setCurrentIndex(4);
 
   ui->hostEdit->setText(m_uiConfig->host.c_str());
   ui->portSpin->setValue(m_uiConfig->port);
 
+  populateBandTable(SpectrumBandMeter::deserialize(m_uiConfig->bands));
+  applyBands();
+
   ui->hostEdit->blockSignals(false);
   ui->portSpin->blockSignals(false);
   ui->formatCombo->blockSignals(false);
@@ -704,6 +939,10 @@ RMSInspector::onConfigChanged()
     case 3:
       m_uiConfig->logFormat = "tcp";
       break;
+
+    case 4:
+      m_uiConfig->logFormat = "rmslog";
+      break;
   }
 
   m_uiConfig->host = ui->hostEdit->text().toStdString();
@@ -716,8 +955,13 @@ RMSInspector::onConfigChanged()
 void
 RMSInspector::onTabChanged()
 {
+  // Bands need the spectrum all the time
+  bool wantSpectrum =
+      ui->tabWidget->currentWidget() == ui->tabChannel
+      || !m_bandMeter.bands().empty();
+
   if (m_analyzer != nullptr) {
-    if (ui->tabWidget->currentIndex() == 1) {
+    if (wantSpectrum) {
       m_analyzer->setSpectrumSource(
               this->request().handle,
               1,
@@ -798,7 +1042,7 @@ void
 RMSInspector::onToggleDataLogger()
 {
   bool enabled = ui->logCheck->isChecked();
-  bool haveDataLogger = m_datasaver != nullptr;
+  bool haveDataLogger = m_logWriter != nullptr;
   bool hintFailed = false;
   bool haveHint = false;
 
@@ -846,14 +1090,19 @@ RMSInspector::onToggleDataLogger()
 
           hashlist_set(m_datasaverParams, "_t0", &m_t0);
 
-          m_updates   = 0;
-          m_datasaver = suscli_datasaver_new(params);
+          m_updates = 0;
+          suscli_datasaver *datasaver = suscli_datasaver_new(params);
 
-          if (m_datasaver == nullptr) {
+          if (datasaver == nullptr) {
             QMessageBox::critical(
                   this,
                   "Internal error",
                   "Failed to create datasaver object. See log messages for details.");
+          } else {
+            // Network datasavers have no file to look at
+            this->startLogWriter(
+                  datasaver,
+                  params->fname != nullptr ? m_fullPathStd : std::string());
           }
 
 
@@ -863,15 +1112,14 @@ RMSInspector::onToggleDataLogger()
 
     } else {
       // Delete datalogger
-      suscli_datasaver_destroy(m_datasaver);
-      m_datasaver = nullptr;
+      this->stopLogWriter();
 
       ui->currentFileLabel->setText("N/A");
       ui->sizeLabel->setText("0 bytes");
     }
   }
 
-  haveDataLogger = m_datasaver != nullptr;
+  haveDataLogger = m_logWriter != nullptr;
 
   if (m_analyzer != nullptr)
     ui->logCheck->setChecked(haveDataLogger);
@@ -882,6 +1130,62 @@ RMSInspector::onToggleDataLogger()
   refreshUi();
 }
 
+void
+RMSInspector::onLogWriterFailed()
+{
+  this->stopLogWriter();
+
+  ui->currentFileLabel->setText("N/A");
+  ui->sizeLabel->setText("0 bytes");
+
+  ui->logCheck->setChecked(false);
+  m_uiConfig->logData = false;
+
+  refreshUi();
+
+  QMessageBox::warning(
+        this,
+        "Datasaver closed",
+        "The current data logger closed unexpectedly. Open the log window for details");
+}
+
+void
+RMSInspector::onAddBand()
+{
+  int row = ui->bandTable->rowCount();
+  bool blocked = ui->bandTable->blockSignals(true);
+  SpectrumBand band;
+
+  band.name      = "Band " + QString::number(row + 1);
+  band.bandwidth = SCAST(qreal, ui->bandwidthLcd->getValue()) / 10;
+
+  if (band.bandwidth <= 0)
+    band.bandwidth = 1;
+
+  ui->bandTable->insertRow(row);
+  setBandRow(row, band);
+  ui->bandTable->blockSignals(blocked);
+
+  applyBands();
+}
+
+void
+RMSInspector::onRemoveBand()
+{
+  int row = ui->bandTable->currentRow();
+
+  if (row >= 0) {
+    ui->bandTable->removeRow(row);
+    applyBands();
+  }
+}
+
+void
+RMSInspector::onBandEdited()
+{
+  applyBands();
+}
+
 void
 RMSInspector::onBrowseDirectory()
 {
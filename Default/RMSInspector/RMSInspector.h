@@ -26,9 +26,19 @@
 #include <Suscan/Config.h>
 #include <cli/datasaver.h>
 #include <InspectionWidgetFactory.h>
+#include <sys/time.h>
+#include <ColorConfig.h>
+#include <map>
+#include "SpectrumBandMeter.h"
 
 #define RMS_INSPECTOR_DEFAULT_INTEGRATION_TIME_MS 20
 
+// Inspector spectrum updates per second, until measured
+#define RMS_INSPECTOR_DEFAULT_SPECTRUM_RATE       10
+
+// History memory shared by all band plots, split evenly among them
+#define RMS_INSPECTOR_BAND_HISTORY_MEMORY         (64 << 20)
+
 namespace Ui {
   class RMSInspector;
 }
@@ -36,6 +46,7 @@ namespace Ui {
 namespace SigDigger {
   class AppConfig;
   class RMSViewTab;
+  class RMSLogWriter;
 
   extern "C" {
     typedef void (*datasaver_param_init_cb) (
@@ -57,6 +68,7 @@ namespace SigDigger {
     unsigned port = 9999;
     std::string logDir = "";
     std::string logFormat = "csv";
+    std::string bands = "";
     void deserialize(Suscan::Object const &conf) override;
     Suscan::Object &&serialize() override;
   };
@@ -78,7 +90,8 @@ namespace SigDigger {
     QString               m_dataFile;
     std::string           m_fullPathStd;
     hashlist_t           *m_datasaverParams = nullptr;
-    suscli_datasaver     *m_datasaver = nullptr;
+    RMSLogWriter         *m_logWriter = nullptr; // Lives in m_logThread
+    QThread              *m_logThread = nullptr;
     struct timeval        m_t0;
     struct timeval        m_lastUpdate;
     std::vector<SUFLOAT>  m_fftData;
@@ -95,6 +108,18 @@ namespace SigDigger {
     // RMSViewTab
     RMSViewTab *m_rmsTab = nullptr;
 
+    // Sub-band measurements, one plot per band
+    SpectrumBandMeter         m_bandMeter;
+    std::map<int, RMSViewTab *> m_bandTabsById; // Band id -> plot
+    std::vector<RMSViewTab *> m_bandTabs; // Plot of each measured band
+    std::vector<int>          m_bandRows; // Table row of each band
+    int                       m_nextBandId = 0;
+    qreal                     m_spectrumRate = RMS_INSPECTOR_DEFAULT_SPECTRUM_RATE;
+    qreal                     m_bandTabRate = RMS_INSPECTOR_DEFAULT_SPECTRUM_RATE;
+    struct timeval            m_lastSpectrum;
+    bool                      m_haveLastSpectrum = false;
+    ColorConfig               m_colors;
+
     qint64 m_tunerFreq = 0;
 
     QString getInspectorTabTitle() const;
@@ -114,6 +139,15 @@ namespace SigDigger {
         datasaver_param_init_cb);
 
     void refreshUi();
+    void refreshLogSize();
+
+    void populateBandTable(std::vector<SpectrumBand> const &);
+    void setBandRow(int row, SpectrumBand const &);
+    void applyBands();
+    void feedBands();
+
+    void startLogWriter(suscli_datasaver *, std::string const &path);
+    void stopLogWriter(bool wait = false);
 
     const suscli_datasaver_params *currentDataSaverParams();
 
@@ -158,6 +192,10 @@ namespace SigDigger {
       void onChangeBandwidth();
       void onBrowseDirectory();
       void onSourceInfoMessage(Suscan::SourceInfoMessage const &);
+      void onLogWriterFailed();
+      void onAddBand();
+      void onRemoveBand();
+      void onBandEdited();
 
   private:
     Ui::RMSInspector *ui;
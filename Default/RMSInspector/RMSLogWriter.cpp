@@ -0,0 +1,154 @@
+//
+//    RMSLogWriter.cpp: Write RMS logs in the background
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "RMSLogWriter.h"
+#include <sigutils/log.h>
+#include <sys/stat.h>
+
+using namespace SigDigger;
+
+RMSLogWriter::RMSLogWriter(suscli_datasaver *datasaver, std::string const &path) :
+  m_datasaver(datasaver),
+  m_path(path)
+{
+  m_lastStat.tv_sec  = 0;
+  m_lastStat.tv_usec = 0;
+
+  connect(
+        this,
+        SIGNAL(dataPending()),
+        this,
+        SLOT(process()),
+        Qt::QueuedConnection);
+}
+
+RMSLogWriter::~RMSLogWriter()
+{
+  this->writeQueued();
+
+  if (m_datasaver != nullptr)
+    suscli_datasaver_destroy(m_datasaver);
+}
+
+void
+RMSLogWriter::push(struct timeval const &tv, SUFLOAT value)
+{
+  bool notify = false;
+
+  m_mutex.lock();
+
+  if (m_queue.size() >= RMS_LOG_WRITER_MAX_QUEUE) {
+    if (m_stats.dropped++ == 0)
+      SU_WARNING("RMS log writer cannot keep up, dropping measures\n");
+  } else {
+    m_queue.push_back({tv, value});
+  }
+
+  if (!m_scheduled) {
+    m_scheduled = true;
+    notify = true;
+  }
+
+  m_mutex.unlock();
+
+  if (notify)
+    emit dataPending();
+}
+
+RMSLogStats
+RMSLogWriter::getStats()
+{
+  QMutexLocker locker(&m_mutex);
+
+  return m_stats;
+}
+
+void
+RMSLogWriter::refreshSize()
+{
+  struct timeval now, diff;
+  struct stat sbuf;
+  qint64 size = -1;
+
+  if (m_path.empty())
+    return;
+
+  gettimeofday(&now, nullptr);
+  timersub(&now, &m_lastStat, &diff);
+
+  if (diff.tv_sec * 1000 + diff.tv_usec / 1000 < RMS_LOG_WRITER_STAT_INTERVAL_MS)
+    return;
+
+  m_lastStat = now;
+
+  if (stat(m_path.c_str(), &sbuf) != -1)
+    size = sbuf.st_size;
+
+  m_mutex.lock();
+  m_stats.size = size;
+  m_mutex.unlock();
+}
+
+void
+RMSLogWriter::writeQueued()
+{
+  size_t i;
+  bool ok = true;
+
+  m_mutex.lock();
+  m_writing.swap(m_queue);
+  m_scheduled = false;
+  ok = !m_stats.failed;
+  m_mutex.unlock();
+
+  if (!ok || m_datasaver == nullptr) {
+    m_writing.clear();
+    return;
+  }
+
+  for (i = 0; i < m_writing.size(); ++i) {
+    if (!suscli_datasaver_write_timestamp(
+          m_datasaver,
+          &m_writing[i].tv,
+          m_writing[i].value)) {
+      ok = false;
+      break;
+    }
+  }
+
+  m_mutex.lock();
+  m_stats.written += i;
+  m_stats.failed   = !ok;
+  m_mutex.unlock();
+
+  m_writing.clear();
+
+  if (!ok) {
+    suscli_datasaver_destroy(m_datasaver);
+    m_datasaver = nullptr;
+    emit failed();
+  }
+}
+
+void
+RMSLogWriter::process()
+{
+  this->writeQueued();
+  this->refreshSize();
+}
@@ -0,0 +1,88 @@
+//
+//    RMSLogWriter.h: Write RMS logs in the background
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef RMSLOGWRITER_H
+#define RMSLOGWRITER_H
+
+#include <QObject>
+#include <QMutex>
+#include <vector>
+#include <string>
+#include <sys/time.h>
+#include <sigutils/types.h>
+#include <cli/datasaver.h>
+
+// Measures waiting to be written. Beyond this, new ones are dropped.
+#define RMS_LOG_WRITER_MAX_QUEUE   (1 << 16)
+
+// How often the worker looks at the size of the log file
+#define RMS_LOG_WRITER_STAT_INTERVAL_MS 1000
+
+namespace SigDigger {
+  struct RMSLogEntry {
+    struct timeval tv;
+    SUFLOAT value;
+  };
+
+  struct RMSLogStats {
+    quint64 written = 0;
+    quint64 dropped = 0;
+    qint64  size    = -1; // Bytes on disk, -1 if not a file
+    bool    failed  = false;
+  };
+
+  //
+  // Owns a datasaver and feeds it from its own thread. The GUI thread
+  // only queues measures and reads the stats, so a slow disk (or NFS)
+  // never stalls it. Queued measures are flushed on destruction.
+  //
+  class RMSLogWriter : public QObject
+  {
+    Q_OBJECT
+
+    suscli_datasaver *m_datasaver = nullptr;
+    std::string       m_path;
+    struct timeval    m_lastStat;
+
+    QMutex                   m_mutex;
+    std::vector<RMSLogEntry> m_queue;
+    std::vector<RMSLogEntry> m_writing; // Worker thread only
+    RMSLogStats              m_stats;
+    bool                     m_scheduled = false;
+
+    void writeQueued();
+    void refreshSize();
+
+  public:
+    // Takes ownership of the datasaver. `path' may be empty.
+    RMSLogWriter(suscli_datasaver *, std::string const &path);
+    ~RMSLogWriter() override;
+
+    void push(struct timeval const &, SUFLOAT);
+    RMSLogStats getStats();
+
+  signals:
+    void dataPending();
+    void failed();
+
+  public slots:
+    void process();
+  };
+}
+
+#endif // RMSLOGWRITER_H
@@ -0,0 +1,161 @@
+//
+//    SpectrumBandMeter.cpp: Power of many sub-bands from one spectrum
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "SpectrumBandMeter.h"
+#include <QStringList>
+#include <cmath>
+
+using namespace SigDigger;
+
+void
+SpectrumBandMeter::setBands(std::vector<SpectrumBand> const &bands)
+{
+  m_bands = bands;
+  m_powers.assign(bands.size(), 0);
+}
+
+std::vector<SpectrumBand> const &
+SpectrumBandMeter::bands() const
+{
+  return m_bands;
+}
+
+std::vector<SUFLOAT> const &
+SpectrumBandMeter::powers() const
+{
+  return m_powers;
+}
+
+// Sum of centered bins [from, to). Bin k of the centered spectrum is
+// bin (k + len / 2) % len of the one we got.
+double
+SpectrumBandMeter::sumShifted(SUSCOUNT from, SUSCOUNT to, SUSCOUNT len) const
+{
+  SUSCOUNT half = len / 2;
+  SUSCOUNT a = from + half;
+  SUSCOUNT b = to + half;
+
+  if (from >= to)
+    return 0;
+
+  if (a >= len)
+    return m_prefix[b - len] - m_prefix[a - len];
+
+  if (b <= len)
+    return m_prefix[b] - m_prefix[a];
+
+  return (m_prefix[len] - m_prefix[a]) + m_prefix[b - len];
+}
+
+void
+SpectrumBandMeter::measureAndConvert(
+    SUFLOAT *data,
+    SUSCOUNT len,
+    SUSCOUNT rate)
+{
+  double acc = 0;
+  qreal binsPerHz, lo, hi;
+  SUSCOUNT i, from, to;
+
+  if (m_bands.empty()) {
+    for (i = 0; i < len; ++i)
+      data[i] = SU_POWER_DB(data[i]);
+    return;
+  }
+
+  m_prefix.resize(len + 1);
+  m_prefix[0] = 0;
+
+  for (i = 0; i < len; ++i) {
+    acc += SCAST(double, data[i]);
+    m_prefix[i + 1] = acc;
+    data[i] = SU_POWER_DB(data[i]);
+  }
+
+  binsPerHz = SCAST(qreal, len) / SCAST(qreal, rate);
+
+  for (i = 0; i < m_bands.size(); ++i) {
+    SpectrumBand const &band = m_bands[i];
+
+    lo = std::ceil(
+          (band.offset - .5 * band.bandwidth) * binsPerHz
+          + SCAST(qreal, len / 2));
+    hi = std::floor(
+          (band.offset + .5 * band.bandwidth) * binsPerHz
+          + SCAST(qreal, len / 2)) + 1;
+
+    lo = std::max(lo, 0.);
+    hi = std::min(hi, SCAST(qreal, len));
+
+    if (hi <= lo) {
+      m_powers[i] = 0;
+      continue;
+    }
+
+    from = SCAST(SUSCOUNT, lo);
+    to   = SCAST(SUSCOUNT, hi);
+
+    m_powers[i] = SCAST(SUFLOAT, this->sumShifted(from, to, len));
+  }
+}
+
+// name,offset,bandwidth;name,offset,bandwidth;...
+std::string
+SpectrumBandMeter::serialize(std::vector<SpectrumBand> const &bands)
+{
+  QStringList entries;
+
+  for (auto const &band : bands) {
+    QString name = band.name;
+    name.replace(',', ' ').replace(';', ' ');
+    entries.append(
+          name
+          + ","
+          + QString::number(band.offset, 'f', 3)
+          + ","
+          + QString::number(band.bandwidth, 'f', 3));
+  }
+
+  return entries.join(";").toStdString();
+}
+
+std::vector<SpectrumBand>
+SpectrumBandMeter::deserialize(std::string const &string)
+{
+  std::vector<SpectrumBand> bands;
+  QStringList entries = QString::fromStdString(string).split(";");
+
+  for (auto const &entry : entries) {
+    QStringList fields = entry.split(",");
+    SpectrumBand band;
+    bool okOffset, okBw;
+
+    if (fields.size() != 3)
+      continue;
+
+    band.name      = fields[0];
+    band.offset    = fields[1].toDouble(&okOffset);
+    band.bandwidth = fields[2].toDouble(&okBw);
+
+    if (okOffset && okBw && band.bandwidth > 0)
+      bands.push_back(band);
+  }
+
+  return bands;
+}
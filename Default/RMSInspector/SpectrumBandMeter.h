@@ -0,0 +1,64 @@
+//
+//    SpectrumBandMeter.h: Power of many sub-bands from one spectrum
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef SPECTRUMBANDMETER_H
+#define SPECTRUMBANDMETER_H
+
+#include <QString>
+#include <vector>
+#include <string>
+#include <sigutils/types.h>
+
+namespace SigDigger {
+  struct SpectrumBand {
+    QString name;
+    qreal   offset = 0;    // Center, relative to the channel (Hz)
+    qreal   bandwidth = 0; // Hz
+  };
+
+  //
+  // Measures the power of any number of sub-bands of the inspector
+  // spectrum. The spectrum is walked once to build a running sum of its
+  // bins, and then every band costs two lookups, so adding bands is
+  // nearly free.
+  //
+  class SpectrumBandMeter {
+    std::vector<SpectrumBand> m_bands;
+    std::vector<double>       m_prefix;  // m_prefix[i]: sum of bins [0, i)
+    std::vector<SUFLOAT>      m_powers;  // Linear, one per band
+
+    double sumShifted(SUSCOUNT from, SUSCOUNT to, SUSCOUNT len) const;
+
+  public:
+    void setBands(std::vector<SpectrumBand> const &);
+    std::vector<SpectrumBand> const &bands() const;
+    std::vector<SUFLOAT> const &powers() const;
+
+    //
+    // Takes the spectrum as delivered by the inspector (linear, DC
+    // first) and converts it to dB in place, measuring the bands in the
+    // same pass. Bands are given in centered (fftshifted) terms.
+    //
+    void measureAndConvert(SUFLOAT *data, SUSCOUNT len, SUSCOUNT rate);
+
+    static std::string serialize(std::vector<SpectrumBand> const &);
+    static std::vector<SpectrumBand> deserialize(std::string const &);
+  };
+}
+
+#endif // SPECTRUMBANDMETER_H
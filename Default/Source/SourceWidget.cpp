@@ -23,6 +23,7 @@
 #include "ui_SourceWidget.h"
 #include <QMessageBox>
 #include <FileDataSaver.h>
+#include <CompressedFileDataSaver.h>
 #include <fcntl.h>
 #include <UIMediator.h>
 #include <SigDiggerHelpers.h>
@@ -151,6 +152,7 @@ SourceWidget::SourceWidget(
   m_ui->setupUi(this);
 
   m_saverUI = new DataSaverUI(this);
+  m_saverUI->setCompressionAvailable(true);
   m_ui->dataSaverGrid->addWidget(m_saverUI);
   m_ui->throttleSpin->setUnits("sps");
   m_ui->throttleSpin->setMinimum(0);
@@ -1092,13 +1094,22 @@ SourceWidget::openCaptureFile(void)
   gmtime_r(&unixtime, &tm);
   strftime(datetime, sizeof(datetime), "%Y%m%d_%H%M%SZ", &tm);
 
-  snprintf(
-        baseName,
-        sizeof(baseName),
-        "sigdigger_%s_%d_%.0lf_float32_iq.raw",
-        datetime,
-        m_profile->getDecimatedSampleRate(),
-        m_mediator->getCurrentCenterFreq());
+  if (m_saverUI->getCompress())
+    snprintf(
+          baseName,
+          sizeof(baseName),
+          "sigdigger_%s_%d_%.0lf_cs16_iq." SIGDIGGER_IQCODEC_FILE_EXTENSION,
+          datetime,
+          m_profile->getDecimatedSampleRate(),
+          m_mediator->getCurrentCenterFreq());
+  else
+    snprintf(
+          baseName,
+          sizeof(baseName),
+          "sigdigger_%s_%d_%.0lf_float32_iq.raw",
+          datetime,
+          m_profile->getDecimatedSampleRate(),
+          m_mediator->getCurrentCenterFreq());
 
   std::string fullPath =
       m_saverUI->getRecordSavePath() + "/" + baseName;
@@ -1145,6 +1156,12 @@ SourceWidget::connectDataSaver()
         this,
         SLOT(onSaveRate(qreal)));
 
+  connect(
+        m_dataSaver,
+        SIGNAL(metricsUpdated()),
+        this,
+        SLOT(onSaveMetrics()));
+
   connect(
         m_dataSaver,
         SIGNAL(commit()),
@@ -1162,7 +1179,7 @@ SigDigger::onBaseBandData(
     SUSCOUNT)
 {
   SourceWidget *widget = static_cast<SourceWidget *>(privdata);
-  FileDataSaver *saver;
+  GenericDataSaver *saver;
 
   if ((saver = widget->m_dataSaver) != nullptr)
     saver->write(samples, length);
@@ -1175,7 +1192,14 @@ SourceWidget::installDataSaver(int fd)
 {
   if (m_dataSaver == nullptr) {
     if (m_profile != nullptr && m_analyzer != nullptr) {
-      m_dataSaver = new FileDataSaver(fd, this);
+      if (m_saverUI->getCompress())
+        m_dataSaver = new CompressedFileDataSaver(
+              fd,
+              m_profile->getDecimatedSampleRate(),
+              this);
+      else
+        m_dataSaver = new FileDataSaver(fd, this);
+
       m_dataSaver->setSampleRate(m_profile->getDecimatedSampleRate());
 
       if (!m_filterInstalled) {
@@ -1479,6 +1503,13 @@ SourceWidget::onSaveRate(qreal rate)
     setIORate(rate);
 }
 
+void
+SourceWidget::onSaveMetrics(void)
+{
+  if (m_dataSaver != nullptr)
+    m_saverUI->setMetrics(m_dataSaver->getMetrics());
+}
+
 void
 SourceWidget::onCommit(void)
 {
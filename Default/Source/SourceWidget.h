@@ -30,7 +30,7 @@ namespace Ui {
 
 namespace SigDigger {
   class SourceWidgetFactory;
-  class FileDataSaver;
+  class GenericDataSaver;
 
   SUBOOL onBaseBandData(
       void *privdata,
@@ -101,7 +101,7 @@ namespace SigDigger {
 
     // Data saving state
     bool                      m_filterInstalled = false;
-    FileDataSaver            *m_dataSaver = nullptr;
+    GenericDataSaver         *m_dataSaver = nullptr;
 
     // Private methods
     DeviceGain *lookupGain(std::string const &name);
@@ -196,6 +196,7 @@ namespace SigDigger {
     void onSaveError(void);
     void onSaveSwamped(void);
     void onSaveRate(qreal rate);
+    void onSaveMetrics(void);
     void onCommit(void);
   };
 }
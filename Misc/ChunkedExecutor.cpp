@@ -0,0 +1,164 @@
+//
+//    ChunkedExecutor.cpp: Run stateless sample transforms in parallel
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <ChunkedExecutor.h>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  class ChunkedExecutorRunner : public QRunnable {
+    ChunkedExecutor::Kernel const &kernel;
+    std::atomic<size_t> &next;
+    size_t chunks;
+    size_t chunkSize;
+    size_t from;
+    size_t to;
+
+  public:
+    ChunkedExecutorRunner(
+        ChunkedExecutor::Kernel const &kernel,
+        std::atomic<size_t> &next,
+        size_t chunks,
+        size_t chunkSize,
+        size_t from,
+        size_t to) :
+      kernel(kernel),
+      next(next),
+      chunks(chunks),
+      chunkSize(chunkSize),
+      from(from),
+      to(to)
+    {
+    }
+
+    void
+    run(void) override
+    {
+      size_t chunk, start;
+
+      while ((chunk = this->next.fetch_add(1)) < this->chunks) {
+        start = this->from + chunk * this->chunkSize;
+        this->kernel(
+              chunk,
+              start,
+              std::min(start + this->chunkSize, this->to));
+      }
+    }
+  };
+}
+
+ChunkedExecutor::ChunkedExecutor(size_t chunkSize) :
+  m_chunkSize(std::max<size_t>(chunkSize, 1))
+{
+  m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+size_t
+ChunkedExecutor::span(void) const
+{
+  return m_chunkSize * static_cast<size_t>(m_pool.maxThreadCount());
+}
+
+size_t
+ChunkedExecutor::chunks(size_t from, size_t to) const
+{
+  if (to <= from)
+    return 0;
+
+  return (to - from + m_chunkSize - 1) / m_chunkSize;
+}
+
+void
+ChunkedExecutor::run(size_t from, size_t to, Kernel const &kernel)
+{
+  std::vector<std::unique_ptr<ChunkedExecutorRunner>> runners;
+  std::atomic<size_t> next(0);
+  size_t chunks = this->chunks(from, to);
+  size_t threads = std::min(
+        chunks,
+        static_cast<size_t>(m_pool.maxThreadCount()));
+
+  // Not worth a context switch
+  if (threads <= 1) {
+    for (size_t i = 0; i < chunks; ++i)
+      kernel(
+          i,
+          from + i * m_chunkSize,
+          std::min(from + (i + 1) * m_chunkSize, to));
+    return;
+  }
+
+  for (size_t i = 0; i < threads; ++i) {
+    runners.emplace_back(
+          new ChunkedExecutorRunner(
+            kernel,
+            next,
+            chunks,
+            m_chunkSize,
+            from,
+            to));
+    runners.back()->setAutoDelete(false);
+    m_pool.start(runners.back().get());
+  }
+
+  m_pool.waitForDone();
+}
+
+//////////////////////////////// OverlapWindow /////////////////////////////////
+OverlapWindow::OverlapWindow(
+    const SUCOMPLEX *input,
+    const SUCOMPLEX *output,
+    size_t length,
+    size_t overlap) :
+  m_input(input)
+{
+  // Only in-place transforms overwrite what the next chunk has to read
+  m_copy = input < output + length && output < input + length;
+
+  if (m_copy)
+    m_history.resize(std::max<size_t>(overlap, 1));
+}
+
+void
+OverlapWindow::advance(size_t from, size_t to)
+{
+  size_t overlap = m_history.size();
+  size_t tail;
+
+  if (!m_copy)
+    return;
+
+  // Keep the end of the previous range for the chunks of this one
+  tail = std::min(overlap, m_to - m_from);
+  for (size_t k = m_to - tail; k < m_to; ++k)
+    m_history[k % overlap] = m_span[k - m_from];
+
+  m_from = from;
+  m_to   = to;
+
+  m_span.resize(to - from);
+  memcpy(m_span.data(), m_input + from, (to - from) * sizeof(SUCOMPLEX));
+}
@@ -0,0 +1,275 @@
+//
+//    CompressedFileDataSaver.cpp: save baseband data as compressed cs16
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "CompressedFileDataSaver.h"
+#include <sigutils/log.h>
+#include <QThreadPool>
+#include <QRunnable>
+#include <cstring>
+#include <unistd.h>
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  class IQBlockEncodeTask : public QRunnable {
+    const SUCOMPLEX *samples;
+    size_t count;
+    uint64_t firstSample;
+    std::vector<uint8_t> *output;
+    size_t *clipped;
+
+  public:
+    IQBlockEncodeTask(
+        const SUCOMPLEX *samples,
+        size_t count,
+        uint64_t firstSample,
+        std::vector<uint8_t> *output,
+        size_t *clipped) :
+      samples(samples),
+      count(count),
+      firstSample(firstSample),
+      output(output),
+      clipped(clipped)
+    {
+    }
+
+    void
+    run(void) override
+    {
+      this->output->clear();
+      *this->clipped = IQCodec::encodeBlock(
+            this->samples,
+            this->count,
+            this->firstSample,
+            *this->output);
+    }
+  };
+
+  class CompressedFileDataWriter : public GenericDataWriter {
+    int fd = -1;
+    unsigned int sampleRate;
+    bool prepared = false;
+    std::string lastError;
+
+    QThreadPool pool;
+    std::vector<std::vector<uint8_t>> encoded;
+    std::vector<size_t> clipped; // Per block, last write
+    uint64_t totalClipped = 0;
+    std::vector<uint8_t> pending; // Incomplete sample from last write
+    std::vector<IQIndexEntry> index;
+    uint64_t offset = 0;
+    uint64_t samples = 0;
+
+    bool writeAll(const void *data, size_t len);
+
+  public:
+    CompressedFileDataWriter(int fd, unsigned int sampleRate);
+
+    bool prepare(void) override;
+    bool canWrite(void) const override;
+    std::string getError(void) const override;
+    ssize_t write(const void *data, size_t len) override;
+    bool close(void) override;
+    ~CompressedFileDataWriter() override;
+  };
+}
+
+CompressedFileDataWriter::CompressedFileDataWriter(
+    int fd,
+    unsigned int sampleRate) :
+  fd(fd),
+  sampleRate(sampleRate)
+{
+  this->pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+std::string
+CompressedFileDataWriter::getError(void) const
+{
+  return this->lastError;
+}
+
+bool
+CompressedFileDataWriter::writeAll(const void *data, size_t len)
+{
+  const uint8_t *as_bytes = static_cast<const uint8_t *>(data);
+  ssize_t result;
+
+  while (len > 0) {
+    result = ::write(this->fd, as_bytes, len);
+
+    if (result < 1) {
+      this->lastError = "write() failed: " + std::string(strerror(errno));
+      return false;
+    }
+
+    as_bytes += result;
+    len      -= static_cast<size_t>(result);
+  }
+
+  return true;
+}
+
+bool
+CompressedFileDataWriter::prepare(void)
+{
+  IQFileHeader header;
+
+  if (this->prepared)
+    return true;
+
+  if (this->fd == -1) {
+    this->lastError = "Capture file is not open";
+    return false;
+  }
+
+  header.sampleRate = this->sampleRate;
+
+  if (!this->writeAll(&header, sizeof(IQFileHeader)))
+    return false;
+
+  this->offset   = sizeof(IQFileHeader);
+  this->prepared = true;
+
+  return true;
+}
+
+bool
+CompressedFileDataWriter::canWrite(void) const
+{
+  return this->fd != -1;
+}
+
+ssize_t
+CompressedFileDataWriter::write(const void *data, size_t len)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  std::vector<uint8_t> merged;
+  size_t total = len;
+  size_t count, blocks;
+  const SUCOMPLEX *samples;
+
+  if (this->fd == -1)
+    return 0;
+
+  // Rare: previous write ended in the middle of a sample.
+  if (!this->pending.empty()) {
+    merged = std::move(this->pending);
+    merged.insert(merged.end(), bytes, bytes + len);
+    bytes = merged.data();
+    len   = merged.size();
+  }
+
+  count   = len / sizeof(SUCOMPLEX);
+  blocks  = (count + SIGDIGGER_IQCODEC_BLOCK_LENGTH - 1)
+      / SIGDIGGER_IQCODEC_BLOCK_LENGTH;
+  samples = reinterpret_cast<const SUCOMPLEX *>(bytes);
+
+  if (this->encoded.size() < blocks) {
+    this->encoded.resize(blocks);
+    this->clipped.resize(blocks);
+  }
+
+  // Blocks are independent, encode them in parallel...
+  for (size_t i = 0; i < blocks; ++i) {
+    size_t first = i * SIGDIGGER_IQCODEC_BLOCK_LENGTH;
+    size_t size  = std::min<size_t>(
+          SIGDIGGER_IQCODEC_BLOCK_LENGTH,
+          count - first);
+
+    this->pool.start(
+          new IQBlockEncodeTask(
+            samples + first,
+            size,
+            this->samples + first,
+            &this->encoded[i],
+            &this->clipped[i]));
+  }
+
+  this->pool.waitForDone();
+
+  // ... and write them in order
+  for (size_t i = 0; i < blocks; ++i) {
+    IQIndexEntry entry;
+
+    entry.offset      = this->offset;
+    entry.firstSample = this->samples + i * SIGDIGGER_IQCODEC_BLOCK_LENGTH;
+
+    if (!this->writeAll(this->encoded[i].data(), this->encoded[i].size()))
+      return -1;
+
+    if (this->clipped[i] > 0 && this->totalClipped == 0)
+      SU_WARNING("Compressed capture: non-finite samples, clipping them\n");
+    this->totalClipped += this->clipped[i];
+
+    this->index.push_back(entry);
+    this->offset += this->encoded[i].size();
+  }
+
+  this->samples += count;
+  this->pending.assign(bytes + count * sizeof(SUCOMPLEX), bytes + len);
+
+  return static_cast<ssize_t>(total);
+}
+
+bool
+CompressedFileDataWriter::close(void)
+{
+  bool ok = true;
+
+  if (this->fd != -1) {
+    // Index is what makes the capture seekable without a full scan
+    if (this->prepared && !this->index.empty()) {
+      IQIndexTrailer trailer;
+
+      trailer.count = this->index.size();
+
+      ok = this->writeAll(
+            this->index.data(),
+            this->index.size() * sizeof(IQIndexEntry))
+          && this->writeAll(&trailer, sizeof(IQIndexTrailer));
+    }
+
+    if (this->totalClipped > 0)
+      SU_WARNING(
+            "Compressed capture: %llu samples clipped\n",
+            static_cast<unsigned long long>(this->totalClipped));
+
+    ok = ::close(this->fd) == 0 && ok;
+    this->fd = -1;
+  }
+
+  return ok;
+}
+
+CompressedFileDataWriter::~CompressedFileDataWriter()
+{
+  this->close();
+}
+
+///////////////////////// CompressedFileDataSaver //////////////////////////////
+CompressedFileDataSaver::CompressedFileDataSaver(
+    int fd,
+    unsigned int sampleRate,
+    QObject *parent) :
+  GenericDataSaver(
+    new CompressedFileDataWriter(fd, sampleRate),
+    parent)
+{
+}
@@ -0,0 +1,162 @@
+//
+//    ConstellationDensity.cpp: Decaying 2D histogram of the constellation
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <ConstellationDensity.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace SigDigger;
+
+// Rescale the grid before the sample weight gets anywhere near FLT_MAX
+#define CONSTELLATION_DENSITY_MAX_WEIGHT 1e18f
+
+// How hard low densities are lifted when rendering
+#define CONSTELLATION_DENSITY_LOG_GAIN   1000.f
+
+ConstellationDensity::ConstellationDensity()
+{
+  unsigned int i;
+
+  // Grayscale until someone sets a palette
+  for (i = 0; i < 256; ++i)
+    this->palette[i] = qRgb(
+          static_cast<int>(i),
+          static_cast<int>(i),
+          static_cast<int>(i));
+
+  this->setWindow(CONSTELLATION_DENSITY_DEFAULT_WINDOW);
+  this->reset();
+}
+
+void
+ConstellationDensity::setSize(unsigned int size)
+{
+  if (size < 2)
+    size = 2;
+
+  if (size != this->size) {
+    this->size = size;
+    this->reset();
+  }
+}
+
+void
+ConstellationDensity::setExtent(float extent)
+{
+  if (extent > 0 && extent != this->extent) {
+    this->extent = extent;
+    this->reset();
+  }
+}
+
+void
+ConstellationDensity::setWindow(unsigned int samples)
+{
+  if (samples < 1)
+    samples = 1;
+
+  this->growth = std::exp(1.f / static_cast<float>(samples));
+}
+
+void
+ConstellationDensity::setPalette(const QColor *gradient)
+{
+  unsigned int i;
+
+  for (i = 0; i < 256; ++i)
+    this->palette[i] = gradient[i].rgb();
+}
+
+void
+ConstellationDensity::reset(void)
+{
+  this->grid.assign(this->size * this->size, 0);
+  this->weight = 1.f;
+}
+
+void
+ConstellationDensity::renormalize(void)
+{
+  float k = 1.f / this->weight;
+
+  // Cells nobody hit in a while go straight to zero, not to denormals
+  for (auto &cell : this->grid)
+    cell = cell > this->weight * 1e-20f ? cell * k : 0;
+
+  this->weight = 1.f;
+}
+
+void
+ConstellationDensity::feed(const SUCOMPLEX *data, size_t size)
+{
+  float scale = static_cast<float>(this->size) / (2 * this->extent);
+  float limit = static_cast<float>(this->size);
+  float *grid = this->grid.data();
+  float weight = this->weight;
+  float x, y;
+  size_t i;
+
+  for (i = 0; i < size; ++i) {
+    x = (SU_C_REAL(data[i]) + this->extent) * scale;
+    y = (this->extent - SU_C_IMAG(data[i])) * scale;
+
+    weight *= this->growth;
+
+    if (weight > CONSTELLATION_DENSITY_MAX_WEIGHT) {
+      this->weight = weight;
+      this->renormalize();
+      weight = this->weight;
+    }
+
+    // Also rejects NaNs
+    if (!(x >= 0 && x < limit && y >= 0 && y < limit))
+      continue;
+
+    grid[static_cast<unsigned>(y) * this->size + static_cast<unsigned>(x)]
+        += weight;
+  }
+
+  this->weight = weight;
+}
+
+void
+ConstellationDensity::render(QImage &dest) const
+{
+  float peak = *std::max_element(this->grid.begin(), this->grid.end());
+  float k = peak > 0 ? CONSTELLATION_DENSITY_LOG_GAIN / peak : 0;
+  float norm = 255.f / std::log1p(CONSTELLATION_DENSITY_LOG_GAIN);
+  const float *cell = this->grid.data();
+  unsigned int i, j;
+  QRgb *line;
+
+  if (dest.width() != static_cast<int>(this->size)
+      || dest.height() != static_cast<int>(this->size)
+      || dest.format() != QImage::Format_RGB32)
+    dest = QImage(
+          static_cast<int>(this->size),
+          static_cast<int>(this->size),
+          QImage::Format_RGB32);
+
+  for (j = 0; j < this->size; ++j) {
+    line = reinterpret_cast<QRgb *>(dest.scanLine(static_cast<int>(j)));
+    for (i = 0; i < this->size; ++i)
+      line[i] = this->palette[
+          static_cast<unsigned>(norm * std::log1p(k * *cell++))];
+  }
+}
@@ -0,0 +1,277 @@
+//
+//    FFTWPlanCache.cpp: Application-wide cache of FFTW plans
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#define SU_LOG_DOMAIN "fftw-plan-cache"
+
+#include <FFTWPlanCache.h>
+#include <QThread>
+#include <QFile>
+#include <suscan/util/confdb.h>
+#include <sigutils/log.h>
+#include <cstdlib>
+
+using namespace SigDigger;
+
+////////////////////////////// FFTWPlanMeasurer ////////////////////////////////
+FFTWPlanMeasurer::FFTWPlanMeasurer(FFTWPlanCache *cache) : m_cache(cache)
+{
+}
+
+void
+FFTWPlanMeasurer::measure(void)
+{
+  // Wisdom is not saved here: exporting it is not covered by the planner
+  // lock, and the analyzer may be planning right now. finish() does it.
+  while (!m_cache->m_stopping.loadAcquire() && m_cache->measureNext());
+}
+
+/////////////////////////////// FFTWPlanCache //////////////////////////////////
+FFTWPlanCache::FFTWPlanCache() : QObject(nullptr)
+{
+  m_wisdomPath = QString(suscan_confdb_get_local_path()) + "/fftw-wisdom";
+  m_rigor      = getenv("SIGDIGGER_FFTW_PATIENT") != nullptr
+      ? FFTW_PATIENT
+      : FFTW_MEASURE;
+
+  // Background measurements run next to the planner calls of sigutils
+  // and suscan, which do not know about our mutex. This is process-wide
+  // and must happen before any other thread plans, hence main().
+  SU_FFTW(_make_planner_thread_safe)();
+
+  loadWisdom();
+
+  m_thread   = new QThread();
+  m_measurer = new FFTWPlanMeasurer(this);
+  m_measurer->moveToThread(m_thread);
+
+  connect(
+        this,
+        SIGNAL(measureRequested(void)),
+        m_measurer,
+        SLOT(measure(void)));
+
+  connect(
+        m_thread,
+        &QThread::finished,
+        m_measurer,
+        &QObject::deleteLater);
+
+  m_thread->start(QThread::LowestPriority);
+}
+
+FFTWPlanCache *
+FFTWPlanCache::instance()
+{
+  // Initialization of function-local statics is thread-safe. main() calls
+  // this early so the cache (a QObject) lives in the GUI thread.
+  static FFTWPlanCache *instance = new FFTWPlanCache();
+
+  return instance;
+}
+
+void
+FFTWPlanCache::loadWisdom(void)
+{
+  QMutexLocker locker(&m_plannerMutex);
+
+  if (!QFile::exists(m_wisdomPath))
+    return;
+
+  if (!SU_FFTW(_import_wisdom_from_filename)(
+        m_wisdomPath.toLocal8Bit().constData()))
+    SU_WARNING(
+          "Cannot import FFTW wisdom from %s, plans will be measured again\n",
+          m_wisdomPath.toLocal8Bit().constData());
+}
+
+void
+FFTWPlanCache::saveWisdom(void)
+{
+  {
+    QMutexLocker locker(&m_mapMutex);
+
+    if (!m_wisdomChanged)
+      return;
+
+    m_wisdomChanged = false;
+  }
+
+  QMutexLocker locker(&m_plannerMutex);
+
+  if (!SU_FFTW(_export_wisdom_to_filename)(
+        m_wisdomPath.toLocal8Bit().constData()))
+    SU_WARNING(
+          "Cannot save FFTW wisdom to %s\n",
+          m_wisdomPath.toLocal8Bit().constData());
+}
+
+bool
+FFTWPlanCache::measureNext(void)
+{
+  FFTWPlanKey key;
+  SU_FFTW(_plan) plan;
+  SU_FFTW(_complex) *in, *out;
+  char *inAlloc, *outAlloc = nullptr;
+  size_t bytes;
+
+  {
+    QMutexLocker locker(&m_mapMutex);
+
+    if (m_measureQueue.empty()) {
+      m_measureScheduled = false;
+      return false;
+    }
+
+    key = m_measureQueue.front();
+    m_measureQueue.pop_front();
+  }
+
+  // Measuring overwrites the arrays, so we plan on scratch buffers with
+  // the same placement and alignment as the caller's.
+  bytes   = static_cast<size_t>(key.size) * sizeof(SUCOMPLEX);
+  inAlloc = static_cast<char *>(SU_FFTW(_malloc)(bytes + 16));
+  if (inAlloc == nullptr)
+    return true;
+
+  in  = reinterpret_cast<SU_FFTW(_complex) *>(inAlloc + key.inAlignment);
+  out = in;
+
+  if (!key.inPlace) {
+    outAlloc = static_cast<char *>(SU_FFTW(_malloc)(bytes + 16));
+    if (outAlloc == nullptr) {
+      SU_FFTW(_free)(inAlloc);
+      return true;
+    }
+
+    out = reinterpret_cast<SU_FFTW(_complex) *>(outAlloc + key.outAlignment);
+  }
+
+  m_plannerMutex.lock();
+  SU_FFTW(_set_timelimit)(SIGDIGGER_FFTW_CACHE_MEASURE_TIMELIMIT);
+  plan = SU_FFTW(_plan_dft_1d)(key.size, in, out, key.direction, m_rigor);
+  SU_FFTW(_set_timelimit)(FFTW_NO_TIMELIMIT);
+  m_plannerMutex.unlock();
+
+  SU_FFTW(_free)(inAlloc);
+  if (outAlloc != nullptr)
+    SU_FFTW(_free)(outAlloc);
+
+  if (plan != nullptr) {
+    QMutexLocker locker(&m_mapMutex);
+    Entry &entry = m_plans[key];
+
+    // Somebody may still be executing the old one
+    if (entry.plan != nullptr)
+      m_retired.push_back(entry.plan);
+
+    entry.plan     = plan;
+    entry.measured = true;
+    m_wisdomChanged = true;
+  }
+
+  return true;
+}
+
+SU_FFTW(_plan)
+FFTWPlanCache::get(
+    int size,
+    int direction,
+    SU_FFTW(_complex) *in,
+    SU_FFTW(_complex) *out)
+{
+  FFTWPlanKey key;
+  SU_FFTW(_plan) plan;
+  bool measured = false;
+  bool notify = false;
+
+  key.size         = size;
+  key.direction    = direction;
+  key.inPlace      = in == out;
+  key.inAlignment  = SU_FFTW(_alignment_of)(reinterpret_cast<SUFLOAT *>(in));
+  key.outAlignment = SU_FFTW(_alignment_of)(reinterpret_cast<SUFLOAT *>(out));
+
+  {
+    QMutexLocker locker(&m_mapMutex);
+    auto it = m_plans.find(key);
+
+    if (it != m_plans.end())
+      return it->second.plan;
+  }
+
+  // Not cached yet. Try wisdom first, and fall back to an estimate that
+  // will be measured later. None of these touch the arrays.
+  m_plannerMutex.lock();
+  plan = SU_FFTW(_plan_dft_1d)(
+        size,
+        in,
+        out,
+        direction,
+        m_rigor | FFTW_WISDOM_ONLY);
+
+  if (plan != nullptr)
+    measured = true;
+  else
+    plan = SU_FFTW(_plan_dft_1d)(size, in, out, direction, FFTW_ESTIMATE);
+  m_plannerMutex.unlock();
+
+  if (plan == nullptr)
+    return nullptr;
+
+  {
+    QMutexLocker locker(&m_mapMutex);
+    Entry &entry = m_plans[key];
+
+    // Lost a race against another thread planning the same thing
+    if (entry.plan != nullptr) {
+      m_retired.push_back(plan);
+      return entry.plan;
+    }
+
+    entry.plan     = plan;
+    entry.measured = measured;
+
+    if (!measured && size <= SIGDIGGER_FFTW_CACHE_MAX_MEASURE_SIZE) {
+      m_measureQueue.push_back(key);
+      if (!m_measureScheduled) {
+        m_measureScheduled = true;
+        notify = true;
+      }
+    }
+  }
+
+  if (notify)
+    emit measureRequested();
+
+  return plan;
+}
+
+void
+FFTWPlanCache::finish(void)
+{
+  m_stopping.storeRelease(1);
+
+  if (m_thread != nullptr) {
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+  }
+
+  saveWisdom();
+}
@@ -98,13 +98,7 @@ FileDataWriter::~FileDataWriter(void)
 
 //////////////////////////// FileDataSaver /////////////////////////////////////
 FileDataSaver::FileDataSaver(int fd, QObject *parent) :
-  GenericDataSaver(this->writer = new FileDataWriter(fd), parent)
+  GenericDataSaver(new FileDataWriter(fd), parent)
 {
 }
 
-FileDataSaver::~FileDataSaver(void)
-{
-  if (this->writer != nullptr)
-    delete this->writer;
-}
-
@@ -18,14 +18,12 @@
 //
 
 #include "GenericDataSaver.h"
+#include <sigutils/log.h>
 #include <unistd.h>
+#include <cstdlib>
 
 using namespace SigDigger;
 
-//
-// TODO: Current GenericDataSaver is unaware of the datatype in its buffers
-// This must be changed in some way
-//
 #define TEMPLATE_INSTANCE_FOR_WRITE_NO_MATTER_WHAT(typename_T) \
 ssize_t                                                        \
 GenericDataWriter::write(const typename_T *data, size_t len)   \
@@ -44,6 +42,251 @@ GenericDataWriter::~GenericDataWriter()
   // ?
 }
 
+/////////////////////////////// GenericDataFormat //////////////////////////////
+size_t
+GenericDataFormat::typeSize(GenericDataType type)
+{
+  switch (type) {
+    case GENERIC_DATA_TYPE_RAW:
+    case GENERIC_DATA_TYPE_U8:
+      return sizeof(uint8_t);
+
+    case GENERIC_DATA_TYPE_S16:
+      return sizeof(int16_t);
+
+    case GENERIC_DATA_TYPE_F32:
+      return sizeof(SUFLOAT);
+
+    case GENERIC_DATA_TYPE_CF32:
+      return sizeof(SUCOMPLEX);
+  }
+
+  return 1;
+}
+
+const char *
+GenericDataFormat::typeName(GenericDataType type)
+{
+  switch (type) {
+    case GENERIC_DATA_TYPE_RAW:
+      return "raw";
+
+    case GENERIC_DATA_TYPE_U8:
+      return "u8";
+
+    case GENERIC_DATA_TYPE_S16:
+      return "s16";
+
+    case GENERIC_DATA_TYPE_F32:
+      return "f32";
+
+    case GENERIC_DATA_TYPE_CF32:
+      return "cf32";
+  }
+
+  return "raw";
+}
+
+GenericDataType
+GenericDataFormat::outputType(void) const
+{
+  switch (this->conversion) {
+    case GENERIC_DATA_CONVERSION_NONE:
+      return this->input;
+
+    case GENERIC_DATA_CONVERSION_MODULUS:
+    case GENERIC_DATA_CONVERSION_ARGUMENT:
+    case GENERIC_DATA_CONVERSION_REAL:
+    case GENERIC_DATA_CONVERSION_IMAG:
+      return GENERIC_DATA_TYPE_F32;
+
+    case GENERIC_DATA_CONVERSION_TO_S16:
+      return GENERIC_DATA_TYPE_S16;
+  }
+
+  return this->input;
+}
+
+bool
+GenericDataFormat::isValid(void) const
+{
+  if (this->decimation < 1)
+    return false;
+
+  switch (this->conversion) {
+    case GENERIC_DATA_CONVERSION_NONE:
+      return this->decimation == 1
+          || this->input == GENERIC_DATA_TYPE_F32
+          || this->input == GENERIC_DATA_TYPE_CF32;
+
+    case GENERIC_DATA_CONVERSION_MODULUS:
+    case GENERIC_DATA_CONVERSION_ARGUMENT:
+    case GENERIC_DATA_CONVERSION_REAL:
+    case GENERIC_DATA_CONVERSION_IMAG:
+      return this->input == GENERIC_DATA_TYPE_CF32;
+
+    case GENERIC_DATA_CONVERSION_TO_S16:
+      return this->input == GENERIC_DATA_TYPE_F32;
+  }
+
+  return false;
+}
+
+///////////////////////////// GenericDataConverter /////////////////////////////
+void
+GenericDataConverter::setFormat(GenericDataFormat const &format)
+{
+  if (format.input != this->format.input
+      || format.conversion != this->format.conversion
+      || format.decimation != this->format.decimation) {
+    this->format = format;
+    this->acc    = 0;
+    this->count  = 0;
+  }
+}
+
+// In place. Incomplete averages are kept for the next call.
+template<typename T> size_t
+GenericDataConverter::decimate(T *data, size_t len)
+{
+  unsigned int n = this->format.decimation;
+  SUFLOAT k = 1.f / static_cast<SUFLOAT>(n);
+  size_t i, p = 0;
+
+  for (i = 0; i < len; ++i) {
+    this->acc += data[i];
+
+    if (++this->count == n) {
+      data[p++] = static_cast<T>(k * this->acc);
+      this->acc   = 0;
+      this->count = 0;
+    }
+  }
+
+  return p;
+}
+
+template<> size_t
+GenericDataConverter::decimate(SUFLOAT *data, size_t len)
+{
+  unsigned int n = this->format.decimation;
+  SUFLOAT k = 1.f / static_cast<SUFLOAT>(n);
+  size_t i, p = 0;
+
+  for (i = 0; i < len; ++i) {
+    this->acc += data[i];
+
+    if (++this->count == n) {
+      data[p++] = k * SU_C_REAL(this->acc);
+      this->acc   = 0;
+      this->count = 0;
+    }
+  }
+
+  return p;
+}
+
+const uint8_t *
+GenericDataConverter::convert(
+    const uint8_t *data,
+    size_t bytes,
+    size_t &outBytes)
+{
+  const SUCOMPLEX *cdata = reinterpret_cast<const SUCOMPLEX *>(data);
+  const SUFLOAT *fdata = reinterpret_cast<const SUFLOAT *>(data);
+  size_t len = bytes / GenericDataFormat::typeSize(this->format.input);
+  SUFLOAT *floats;
+  size_t i;
+
+  if (this->format.isIdentity()) {
+    outBytes = bytes;
+    return data;
+  }
+
+  // Decimation without conversion
+  if (this->format.conversion == GENERIC_DATA_CONVERSION_NONE) {
+    if (this->format.input == GENERIC_DATA_TYPE_CF32) {
+      this->complexes.assign(cdata, cdata + len);
+      len = this->decimate(this->complexes.data(), len);
+      outBytes = len * sizeof(SUCOMPLEX);
+      return reinterpret_cast<const uint8_t *>(this->complexes.data());
+    }
+
+    this->floats.assign(fdata, fdata + len);
+    len = this->decimate(this->floats.data(), len);
+    outBytes = len * sizeof(SUFLOAT);
+    return reinterpret_cast<const uint8_t *>(this->floats.data());
+  }
+
+  // Everything else goes through a float stage
+  this->floats.resize(len);
+  floats = this->floats.data();
+
+  switch (this->format.conversion) {
+    case GENERIC_DATA_CONVERSION_MODULUS:
+      for (i = 0; i < len; ++i)
+        floats[i] = SU_C_ABS(cdata[i]);
+      break;
+
+    case GENERIC_DATA_CONVERSION_ARGUMENT:
+      for (i = 0; i < len; ++i)
+        floats[i] = SU_C_ARG(SU_I * cdata[i]) / PI;
+      break;
+
+    case GENERIC_DATA_CONVERSION_REAL:
+      for (i = 0; i < len; ++i)
+        floats[i] = SU_C_REAL(cdata[i]);
+      break;
+
+    case GENERIC_DATA_CONVERSION_IMAG:
+      for (i = 0; i < len; ++i)
+        floats[i] = SU_C_IMAG(cdata[i]);
+      break;
+
+    default:
+      for (i = 0; i < len; ++i)
+        floats[i] = fdata[i];
+  }
+
+  if (this->format.decimation > 1)
+    len = this->decimate(floats, len);
+
+  if (this->format.conversion == GENERIC_DATA_CONVERSION_TO_S16) {
+    SUFLOAT x;
+
+    this->shorts.resize(len);
+    for (i = 0; i < len; ++i) {
+      x = 32767.f * floats[i];
+      if (x > 32767.f)
+        x = 32767.f;
+      else if (x < -32768.f)
+        x = -32768.f;
+      this->shorts[i] = static_cast<int16_t>(x);
+    }
+
+    outBytes = len * sizeof(int16_t);
+    return reinterpret_cast<const uint8_t *>(this->shorts.data());
+  }
+
+  outBytes = len * sizeof(SUFLOAT);
+  return reinterpret_cast<const uint8_t *>(floats);
+}
+
+QString
+GenericDataSaverMetrics::toString(void) const
+{
+  return
+      QString::number(this->bytesPerSecond / (1 << 20), 'f', 2) + " MiB/s, "
+      + "peak fill " + QString::number(this->peakFill * 100, 'f', 0) + "%, "
+      + "commit latency " + QString::number(this->commitLatency / 1000)
+      + " ms (max " + QString::number(this->maxCommitLatency / 1000)
+      + " ms), convert " + QString::number(this->convertTime / 1000)
+      + " ms, write " + QString::number(this->writeTime / 1000)
+      + " ms (longest call " + QString::number(this->maxWriteCall / 1000)
+      + " ms), " + QString::number(this->drops) + " drops ("
+      + QString::number(this->droppedBytes) + " bytes)";
+}
+
 GenericDataWorker::GenericDataWorker(GenericDataSaver *instance)
 {
   this->instance = instance;
@@ -70,22 +313,42 @@ GenericDataWorker::onCommit(void)
     this->instance->bufferReady = true;
   } else if (!this->failed) {
     QMutexLocker locker(&this->instance->dataMutex);
-    struct timeval tv, otv, sub;
+    struct timeval tv, otv, sub, ctv, wtv;
+    quint64 longest = 0, callTime, convertTime, latency;
     ssize_t dumped;
     size_t allocation = this->instance->allocation;
     std::vector<uint8_t> *thisBuf =
         &this->instance->buffers[1 - this->instance->buffer];
-    uint8_t *buffer = thisBuf->data();
-    int remaining = static_cast<int>(this->instance->commitedSize);
+    const uint8_t *buffer;
+    size_t converted;
+    int remaining;
 
+    this->converter.setFormat(this->instance->format);
     locker.unlock();
 
     gettimeofday(&otv, nullptr);
 
+    buffer = this->converter.convert(
+          thisBuf->data(),
+          this->instance->commitedSize,
+          converted);
+    remaining = static_cast<int>(converted);
+
+    gettimeofday(&wtv, nullptr);
+    timersub(&wtv, &otv, &sub);
+    convertTime = static_cast<quint64>(sub.tv_usec + sub.tv_sec * 1000000l);
+
     while (remaining > 0) {
+      gettimeofday(&ctv, nullptr);
       dumped = this->instance->writer->write(
             buffer,
             static_cast<unsigned>(remaining));
+      gettimeofday(&tv, nullptr);
+
+      timersub(&tv, &ctv, &sub);
+      callTime = static_cast<quint64>(sub.tv_usec + sub.tv_sec * 1000000l);
+      if (callTime > longest)
+        longest = callTime;
 
       if (dumped < 1) {
         this->failed = true;
@@ -99,6 +362,14 @@ GenericDataWorker::onCommit(void)
 
     gettimeofday(&tv, nullptr);
 
+    // Latency is taken here, not when the queued signal reaches the
+    // owner thread. commitRequest cannot move until bufferReady is set.
+    this->instance->metricsMutex.lock();
+    this->instance->lastWriteCall = longest;
+    timersub(&tv, &this->instance->commitRequest, &sub);
+    latency = static_cast<quint64>(sub.tv_usec + sub.tv_sec * 1000000l);
+    this->instance->metricsMutex.unlock();
+
     // Requested allocation does not match buffer size.
     if (thisBuf->size() != allocation) {
       try {
@@ -113,8 +384,10 @@ GenericDataWorker::onCommit(void)
     this->instance->bufferReady = true;
     timersub(&tv, &otv, &sub);
 
-    emit writeFinished(static_cast<quint64>(
-          sub.tv_usec + sub.tv_sec * 1000000l));
+    emit writeFinished(
+          static_cast<quint64>(sub.tv_usec + sub.tv_sec * 1000000l),
+          convertTime,
+          latency);
   }
 }
 
@@ -125,6 +398,9 @@ GenericDataSaver::GenericDataSaver(
   this->writer = writer;
   this->setSampleRate(1000000);
 
+  // Metrics are always collected, logging them is opt-in
+  this->logMetrics = getenv("SIGDIGGER_SAVER_METRICS") != nullptr;
+
   QObject::connect(
         this,
         SIGNAL(prepare()),
@@ -139,9 +415,9 @@ GenericDataSaver::GenericDataSaver(
 
   QObject::connect(
         &this->workerObject,
-        SIGNAL(writeFinished(quint64)),
+        SIGNAL(writeFinished(quint64, quint64, quint64)),
         this,
-        SLOT(onWriteFinished(quint64)));
+        SLOT(onWriteFinished(quint64, quint64, quint64)));
 
   QObject::connect(
         &this->workerObject,
@@ -164,6 +440,8 @@ GenericDataSaver::GenericDataSaver(
 
 GenericDataSaver::~GenericDataSaver()
 {
+  // The worker may still be inside onCommit. Join it before the writer
+  // is closed and released.
   this->workerThread.quit();
   this->workerThread.wait();
 
@@ -171,6 +449,8 @@ GenericDataSaver::~GenericDataSaver()
     QMutexLocker locker(&this->dataMutex);
     this->writer->close();
   }
+
+  delete this->writer;
 }
 
 // Protected by mutex
@@ -191,6 +471,15 @@ GenericDataSaver::doCommit(void)
 
     this->buffer = 1 - this->buffer;
     this->commitedSize = this->ptr;
+
+    this->metricsMutex.lock();
+    this->commitRequest = this->lastCommit;
+    if (this->writeTime > 0)
+      this->commitRate =
+          1e6 * static_cast<qreal>(this->commitedSize)
+          / static_cast<qreal>(this->writeTime);
+    this->metricsMutex.unlock();
+
     this->size += this->commitedSize;
     this->ptr = 0;
     this->bufferReady = false;
@@ -199,6 +488,21 @@ GenericDataSaver::doCommit(void)
   }
 }
 
+// Protected by mutex
+void
+GenericDataSaver::reallocate(void)
+{
+  // Up to 3 sec of data. Untyped savers get one byte per sample.
+  this->allocation =
+      3 * this->rateHint * GenericDataFormat::typeSize(this->format.input);
+
+  // No data is being written, we can reallocate here
+  if (!this->dataWritten) {
+    this->buffers[0].resize(this->allocation);
+    this->buffers[1].resize(this->allocation);
+  }
+}
+
 void
 GenericDataSaver::setSampleRate(unsigned int rate)
 {
@@ -206,16 +510,30 @@ GenericDataSaver::setSampleRate(unsigned int rate)
     QMutexLocker locker(&this->dataMutex);
 
     this->rateHint = rate;
-    this->allocation = 3 * rate; // Up to 3 sec of data
-
-    // No data is being written, we can reallocate here
-    if (!this->dataWritten) {
-      this->buffers[0].resize(this->allocation);
-      this->buffers[1].resize(this->allocation);
-    }
+    this->reallocate();
   }
 }
 
+bool
+GenericDataSaver::setFormat(GenericDataFormat const &format)
+{
+  QMutexLocker locker(&this->dataMutex);
+
+  if (this->dataWritten || !format.isValid())
+    return false;
+
+  this->format = format;
+  this->reallocate();
+
+  return true;
+}
+
+GenericDataFormat
+GenericDataSaver::getFormat(void) const
+{
+  return this->format;
+}
+
 void
 GenericDataSaver::setBufferSize(unsigned int size)
 {
@@ -230,10 +548,32 @@ GenericDataSaver::write(const T *data, size_t size)
     QMutexLocker locker(&this->dataMutex);
     size_t totalBytes = this->buffers[this->buffer].size();
     size_t avail = (totalBytes - this->ptr) / sizeof(T);
+    qreal fill;
 
     this->dataWritten = true;
 
+    if (this->format.input != GENERIC_DATA_TYPE_RAW
+        && this->format.input != typeOf(data)) {
+      if (!this->typeMismatch) {
+        SU_ERROR(
+              "Saver expects %s samples, dropping writes of another type\n",
+              GenericDataFormat::typeName(this->format.input));
+        this->typeMismatch = true;
+      }
+
+      this->metricsMutex.lock();
+      ++this->metrics.drops;
+      this->metrics.droppedBytes += size * sizeof(T);
+      this->metricsMutex.unlock();
+      return;
+    }
+
     if (size > avail) {
+      this->metricsMutex.lock();
+      ++this->metrics.drops;
+      this->metrics.droppedBytes += size * sizeof(T);
+      this->metricsMutex.unlock();
+
       emit swamped();
       return;
     }
@@ -246,6 +586,13 @@ GenericDataSaver::write(const T *data, size_t size)
 
     this->ptr += size * sizeof(T);
 
+    fill = static_cast<qreal>(this->ptr) / static_cast<qreal>(totalBytes);
+    if (fill > this->metrics.peakFill) {
+      this->metricsMutex.lock();
+      this->metrics.peakFill = fill;
+      this->metricsMutex.unlock();
+    }
+
     if (this->ptr > totalBytes / 2) {
       // Buffer starts to get filled up, issue commit request
       this->doCommit();
@@ -264,6 +611,14 @@ GenericDataSaver::getSize(void) const
   return this->size;
 }
 
+GenericDataSaverMetrics
+GenericDataSaver::getMetrics(void) const
+{
+  QMutexLocker locker(&this->metricsMutex);
+
+  return this->metrics;
+}
+
 QString
 GenericDataSaver::getLastError(void) const
 {
@@ -284,15 +639,44 @@ GenericDataSaver::onError(QString error)
 }
 
 void
-GenericDataSaver::onWriteFinished(quint64 usec)
+GenericDataSaver::onWriteFinished(
+    quint64 usec,
+    quint64 convertUsec,
+    quint64 latency)
 {
+  GenericDataSaverMetrics current;
+
   this->commitTime = usec;
 
+  this->metricsMutex.lock();
+  this->metrics.commitLatency = latency;
+  this->metrics.convertTime   = convertUsec;
+  this->metrics.writeTime     = usec - convertUsec;
+
+  if (this->metrics.commitLatency > this->metrics.maxCommitLatency)
+    this->metrics.maxCommitLatency = this->metrics.commitLatency;
+
+  if (this->lastWriteCall > this->metrics.maxWriteCall)
+    this->metrics.maxWriteCall = this->lastWriteCall;
+
+  this->metrics.bytesPerSecond = this->commitRate;
+
+  current = this->metrics;
+  this->metricsMutex.unlock();
+
+  if (this->logMetrics)
+    SU_INFO(
+          "%s: %s\n",
+          this->metaObject()->className(),
+          current.toString().toStdString().c_str());
+
   if (this->writeTime > 0) {
     emit dataRate(
           static_cast<qreal>(this->commitTime)
           / static_cast<qreal>(this->writeTime));
   }
+
+  emit metricsUpdated();
 }
 
 void
@@ -0,0 +1,721 @@
+//
+//    IQCodec.cpp: Lossless block codec for cs16 baseband recordings
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include "IQCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace SigDigger;
+
+// Quotients at or above this value are escaped and stored verbatim
+#define IQCODEC_ESCAPE_QUOTIENT 32
+#define IQCODEC_ESCAPE_BITS     20
+#define IQCODEC_MAX_RICE_PARAM  19
+#define IQCODEC_FULL_SCALE      32767.f
+#define IQCODEC_PARTITION       SIGDIGGER_IQCODEC_PARTITION_LENGTH
+
+namespace {
+  class BitWriter {
+    std::vector<uint8_t> &out;
+    uint64_t acc = 0;
+    unsigned int bits = 0;
+
+  public:
+    BitWriter(std::vector<uint8_t> &out) : out(out)
+    {
+    }
+
+    // n <= 32
+    inline void
+    put(uint32_t value, unsigned int n)
+    {
+      if (n == 0)
+        return;
+
+      this->acc   = (this->acc << n) | (value & (0xffffffffu >> (32 - n)));
+      this->bits += n;
+
+      while (this->bits >= 8) {
+        this->bits -= 8;
+        this->out.push_back(static_cast<uint8_t>(this->acc >> this->bits));
+      }
+    }
+
+    inline void
+    ones(unsigned int n)
+    {
+      while (n >= 16) {
+        this->put(0xffff, 16);
+        n -= 16;
+      }
+
+      this->put((1u << n) - 1, n);
+    }
+
+    inline void
+    unary(unsigned int q)
+    {
+      this->ones(q);
+      this->put(0, 1);
+    }
+
+    void
+    flush(void)
+    {
+      if (this->bits > 0) {
+        this->out.push_back(
+              static_cast<uint8_t>(this->acc << (8 - this->bits)));
+        this->bits = 0;
+      }
+    }
+  };
+
+  class BitReader {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint64_t acc = 0;     // MSB-aligned
+    unsigned int bits = 0;
+    size_t padding = 0;   // Bytes read past the end
+
+  public:
+    // Guarantees at least 57 bits in the accumulator
+    inline void
+    refill(void)
+    {
+      while (this->bits <= 56) {
+        uint64_t byte = 0;
+
+        if (this->p < this->end)
+          byte = *this->p++;
+        else
+          ++this->padding;
+
+        this->acc  |= byte << (56 - this->bits);
+        this->bits += 8;
+      }
+    }
+
+    BitReader(const uint8_t *data, size_t size) : p(data), end(data + size)
+    {
+    }
+
+    // n <= 32
+    inline uint32_t
+    get(unsigned int n)
+    {
+      this->refill();
+
+      return this->take(n);
+    }
+
+    // Like get(), but without refilling. Caller must ensure there are
+    // enough bits in the accumulator.
+    inline uint32_t
+    take(unsigned int n)
+    {
+      uint32_t value;
+
+      if (n == 0)
+        return 0;
+
+      value = static_cast<uint32_t>(this->acc >> (64 - n));
+      this->acc  <<= n;
+      this->bits  -= n;
+
+      return value;
+    }
+
+    // Returns the number of leading ones, saturated to `limit'. Does
+    // not refill.
+    inline unsigned int
+    unary(unsigned int limit)
+    {
+      uint64_t inv;
+      unsigned int n;
+
+      inv = ~this->acc;
+      n = inv == 0 ? 64 : static_cast<unsigned int>(__builtin_clzll(inv));
+
+      if (n >= limit) {
+        this->acc <<= limit;
+        this->bits -= limit;
+        return limit;
+      }
+
+      // Ones plus the terminating zero
+      this->acc <<= n + 1;
+      this->bits -= n + 1;
+
+      return n;
+    }
+
+    bool
+    overrun(void) const
+    {
+      return this->padding * 8 > this->bits;
+    }
+  };
+
+  inline uint32_t
+  zigzag(int32_t e)
+  {
+    return (static_cast<uint32_t>(e) << 1) ^ static_cast<uint32_t>(e >> 31);
+  }
+
+  inline int32_t
+  unzigzag(uint32_t u)
+  {
+    return static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+  }
+
+  inline int32_t
+  predict(const int16_t *x, size_t i, unsigned int order)
+  {
+    switch (order) {
+      case 1:
+        return x[i - 1];
+
+      case 2:
+        return 2 * x[i - 1] - x[i - 2];
+    }
+
+    return 0;
+  }
+
+  void
+  encodeChannel(
+      const int16_t *x,
+      size_t n,
+      BitWriter &w,
+      std::vector<uint32_t> &res)
+  {
+    uint64_t sum[3] = {0, 0, 0};
+    unsigned int order = 0;
+
+    // Pick the cheapest fixed predictor for this channel
+    for (size_t i = 2; i < n; ++i) {
+      int32_t e0 = x[i];
+      int32_t e1 = e0 - x[i - 1];
+      int32_t e2 = e1 - (x[i - 1] - x[i - 2]);
+
+      sum[0] += static_cast<uint64_t>(std::abs(e0));
+      sum[1] += static_cast<uint64_t>(std::abs(e1));
+      sum[2] += static_cast<uint64_t>(std::abs(e2));
+    }
+
+    if (n > 2) {
+      if (sum[1] < sum[order])
+        order = 1;
+      if (sum[2] < sum[order])
+        order = 2;
+    }
+
+    w.put(order, 2);
+
+    for (size_t i = 0; i < order; ++i)
+      w.put(static_cast<uint16_t>(x[i]), 16);
+
+    res.resize(n - order);
+    for (size_t i = order; i < n; ++i)
+      res[i - order] = zigzag(x[i] - predict(x, i, order));
+
+    for (size_t p = 0; p < res.size(); p += IQCODEC_PARTITION) {
+      size_t len = std::min<size_t>(IQCODEC_PARTITION, res.size() - p);
+      uint64_t psum = 0;
+      unsigned int k = 0;
+
+      for (size_t i = 0; i < len; ++i)
+        psum += res[p + i];
+
+      while (k < IQCODEC_MAX_RICE_PARAM
+             && (static_cast<uint64_t>(len) << (k + 1)) <= psum)
+        ++k;
+
+      w.put(k, 5);
+
+      for (size_t i = 0; i < len; ++i) {
+        uint32_t u = res[p + i];
+        uint32_t q = u >> k;
+
+        if (q + 1 + k <= 32) {
+          // Common case: unary code and remainder in a single put
+          uint32_t code = (((1u << q) - 1) << 1) << k;
+          w.put(code | (u & ((1u << k) - 1)), q + 1 + k);
+        } else if (q < IQCODEC_ESCAPE_QUOTIENT) {
+          w.unary(q);
+          w.put(u, k);
+        } else {
+          w.ones(IQCODEC_ESCAPE_QUOTIENT);
+          w.put(u, IQCODEC_ESCAPE_BITS);
+        }
+      }
+    }
+  }
+
+  bool
+  decodeChannel(BitReader &r, int16_t *x, size_t n)
+  {
+    unsigned int order = r.get(2);
+    size_t i;
+
+    if (order > 2)
+      return false;
+
+    for (i = 0; i < order && i < n; ++i)
+      x[i] = static_cast<int16_t>(r.get(16));
+
+    while (i < n) {
+      size_t len = std::min<size_t>(IQCODEC_PARTITION, n - i);
+      unsigned int k = r.get(5);
+
+      if (k > IQCODEC_MAX_RICE_PARAM)
+        return false;
+
+      for (size_t j = 0; j < len; ++j, ++i) {
+        unsigned int q;
+        uint32_t u;
+
+        // 57 bits are enough for both the longest unary and the remainder
+        r.refill();
+        q = r.unary(IQCODEC_ESCAPE_QUOTIENT);
+
+        if (q == IQCODEC_ESCAPE_QUOTIENT)
+          u = r.take(IQCODEC_ESCAPE_BITS);
+        else
+          u = (q << k) | r.take(k);
+
+        x[i] = static_cast<int16_t>(predict(x, i, order) + unzigzag(u));
+      }
+    }
+
+    return !r.overrun();
+  }
+
+  inline int16_t
+  quantize(SUFLOAT x, SUFLOAT k, size_t &clipped)
+  {
+    SUFLOAT v = x * k;
+
+    if (std::isnan(v)) {
+      ++clipped;
+      return 0;
+    }
+
+    if (v > IQCODEC_FULL_SCALE) {
+      ++clipped;
+      v = IQCODEC_FULL_SCALE;
+    } else if (v < -IQCODEC_FULL_SCALE - 1) {
+      ++clipped;
+      v = -IQCODEC_FULL_SCALE - 1;
+    }
+
+    return static_cast<int16_t>(std::lrint(v));
+  }
+}
+
+/////////////////////////////////// IQCodec ////////////////////////////////////
+size_t
+IQCodec::encodeBlock(
+    const SUCOMPLEX *samples,
+    size_t count,
+    uint64_t firstSample,
+    std::vector<uint8_t> &output)
+{
+  IQBlockHeader header;
+  size_t headerPos = output.size();
+  size_t payloadPos = headerPos + sizeof(IQBlockHeader);
+  std::vector<int16_t> i(count), q(count);
+  std::vector<uint32_t> res;
+  SUFLOAT peak = 0, k;
+  size_t clipped = 0;
+
+  // Full scale is the peak of the block, so that finite samples never
+  // clip and weak signals keep all 16 bits
+  for (size_t n = 0; n < count; ++n) {
+    SUFLOAT re = std::fabs(SU_C_REAL(samples[n]));
+    SUFLOAT im = std::fabs(SU_C_IMAG(samples[n]));
+
+    if (std::isfinite(re) && re > peak)
+      peak = re;
+    if (std::isfinite(im) && im > peak)
+      peak = im;
+  }
+
+  if (peak <= 0)
+    peak = 1;
+
+  k = IQCODEC_FULL_SCALE / peak;
+
+  for (size_t n = 0; n < count; ++n) {
+    i[n] = quantize(SU_C_REAL(samples[n]), k, clipped);
+    q[n] = quantize(SU_C_IMAG(samples[n]), k, clipped);
+  }
+
+  output.resize(payloadPos);
+  output.reserve(payloadPos + 4 * count);
+
+  {
+    BitWriter w(output);
+
+    encodeChannel(i.data(), count, w, res);
+    encodeChannel(q.data(), count, w, res);
+    w.flush();
+  }
+
+  // Incompressible block (e.g. saturated wideband noise). Store it as is.
+  if (output.size() - payloadPos >= 4 * count) {
+    output.resize(payloadPos + 4 * count);
+
+    for (size_t n = 0; n < count; ++n) {
+      memcpy(&output[payloadPos + 4 * n], &i[n], sizeof(int16_t));
+      memcpy(&output[payloadPos + 4 * n + 2], &q[n], sizeof(int16_t));
+    }
+
+    header.encoding = SIGDIGGER_IQCODEC_BLOCK_RAW;
+  }
+
+  header.samples     = static_cast<uint32_t>(count);
+  header.payloadSize = static_cast<uint32_t>(output.size() - payloadPos);
+  header.firstSample = firstSample;
+  header.fullScale   = peak;
+
+  memcpy(&output[headerPos], &header, sizeof(IQBlockHeader));
+
+  return clipped;
+}
+
+bool
+IQCodec::decodeBlock(
+    const uint8_t *payload,
+    size_t size,
+    uint32_t encoding,
+    SUCOMPLEX *samples,
+    size_t count,
+    SUFLOAT fullScale)
+{
+  std::vector<int16_t> i(count), q(count);
+  SUFLOAT k = fullScale / IQCODEC_FULL_SCALE;
+
+  if (encoding == SIGDIGGER_IQCODEC_BLOCK_RAW) {
+    if (size < 4 * count)
+      return false;
+
+    for (size_t n = 0; n < count; ++n) {
+      memcpy(&i[n], payload + 4 * n, sizeof(int16_t));
+      memcpy(&q[n], payload + 4 * n + 2, sizeof(int16_t));
+    }
+  } else if (encoding == SIGDIGGER_IQCODEC_BLOCK_RICE) {
+    BitReader r(payload, size);
+
+    if (!decodeChannel(r, i.data(), count))
+      return false;
+
+    if (!decodeChannel(r, q.data(), count))
+      return false;
+  } else {
+    return false;
+  }
+
+  for (size_t n = 0; n < count; ++n)
+    samples[n] = k * (SU_ASFLOAT(i[n]) + SU_I * SU_ASFLOAT(q[n]));
+
+  return true;
+}
+
+////////////////////////////// IQCompressedReader //////////////////////////////
+bool
+IQCompressedReader::readAt(void *data, size_t size, uint64_t offset)
+{
+  uint8_t *as_bytes = static_cast<uint8_t *>(data);
+  ssize_t got;
+
+  if (lseek(this->fd, static_cast<off_t>(offset), SEEK_SET) == -1) {
+    this->lastError = "lseek() failed: " + std::string(strerror(errno));
+    return false;
+  }
+
+  while (size > 0) {
+    got = ::read(this->fd, as_bytes, size);
+
+    if (got < 1) {
+      this->lastError = got == 0
+          ? std::string("Unexpected end of file")
+          : "read() failed: " + std::string(strerror(errno));
+      return false;
+    }
+
+    as_bytes += got;
+    size     -= static_cast<size_t>(got);
+  }
+
+  return true;
+}
+
+bool
+IQCompressedReader::loadIndex(uint64_t fileSize)
+{
+  IQIndexTrailer trailer;
+  IQBlockHeader last;
+  uint64_t indexSize;
+
+  if (fileSize < sizeof(IQFileHeader) + sizeof(IQIndexTrailer))
+    return false;
+
+  if (!this->readAt(
+        &trailer,
+        sizeof(IQIndexTrailer),
+        fileSize - sizeof(IQIndexTrailer)))
+    return false;
+
+  if (trailer.magic != SIGDIGGER_IQCODEC_INDEX_MAGIC || trailer.count == 0)
+    return false;
+
+  indexSize = trailer.count * sizeof(IQIndexEntry);
+  if (indexSize + sizeof(IQIndexTrailer) + sizeof(IQFileHeader) > fileSize)
+    return false;
+
+  this->index.resize(trailer.count);
+  if (!this->readAt(
+        this->index.data(),
+        indexSize,
+        fileSize - sizeof(IQIndexTrailer) - indexSize))
+    return false;
+
+  if (!this->readAt(&last, sizeof(IQBlockHeader), this->index.back().offset))
+    return false;
+
+  if (last.magic != SIGDIGGER_IQCODEC_BLOCK_MAGIC)
+    return false;
+
+  this->sampleCount = last.firstSample + last.samples;
+
+  return true;
+}
+
+bool
+IQCompressedReader::rebuildIndex(uint64_t fileSize)
+{
+  uint64_t offset = sizeof(IQFileHeader);
+  IQBlockHeader header;
+  IQIndexEntry entry;
+
+  this->index.clear();
+  this->sampleCount = 0;
+
+  while (offset + sizeof(IQBlockHeader) <= fileSize) {
+    if (!this->readAt(&header, sizeof(IQBlockHeader), offset))
+      break;
+
+    if (header.magic != SIGDIGGER_IQCODEC_BLOCK_MAGIC)
+      break;
+
+    // Truncated block: the capture was interrupted while writing it
+    if (offset + sizeof(IQBlockHeader) + header.payloadSize > fileSize)
+      break;
+
+    entry.offset = offset;
+    entry.firstSample = header.firstSample;
+    this->index.push_back(entry);
+    this->sampleCount = header.firstSample + header.samples;
+
+    offset += sizeof(IQBlockHeader) + header.payloadSize;
+  }
+
+  this->lastError.clear();
+
+  return true;
+}
+
+bool
+IQCompressedReader::loadBlock(size_t block)
+{
+  IQBlockHeader header;
+
+  if (!this->readAt(&header, sizeof(IQBlockHeader), this->index[block].offset))
+    return false;
+
+  if (header.magic != SIGDIGGER_IQCODEC_BLOCK_MAGIC) {
+    this->lastError = "Corrupted block header";
+    return false;
+  }
+
+  this->payload.resize(header.payloadSize);
+  this->decoded.resize(header.samples);
+
+  if (!this->readAt(
+        this->payload.data(),
+        header.payloadSize,
+        this->index[block].offset + sizeof(IQBlockHeader)))
+    return false;
+
+  if (!IQCodec::decodeBlock(
+        this->payload.data(),
+        this->payload.size(),
+        header.encoding,
+        this->decoded.data(),
+        this->decoded.size(),
+        header.fullScale)) {
+    this->lastError = "Corrupted block payload";
+    this->haveBlock = false;
+    return false;
+  }
+
+  this->currBlock = block;
+  this->haveBlock = true;
+
+  return true;
+}
+
+size_t
+IQCompressedReader::findBlock(uint64_t sample) const
+{
+  auto it = std::upper_bound(
+        this->index.begin(),
+        this->index.end(),
+        sample,
+        [] (uint64_t sample, IQIndexEntry const &entry) {
+          return sample < entry.firstSample;
+        });
+
+  if (it == this->index.begin())
+    return 0;
+
+  return static_cast<size_t>(it - this->index.begin()) - 1;
+}
+
+bool
+IQCompressedReader::open(std::string const &path)
+{
+  struct stat sbuf;
+
+  this->close();
+
+  if ((this->fd = ::open(path.c_str(), O_RDONLY)) == -1) {
+    this->lastError = "Cannot open " + path + ": " + strerror(errno);
+    return false;
+  }
+
+  if (fstat(this->fd, &sbuf) == -1) {
+    this->lastError = "fstat() failed: " + std::string(strerror(errno));
+    goto fail;
+  }
+
+  if (!this->readAt(&this->header, sizeof(IQFileHeader), 0))
+    goto fail;
+
+  if (this->header.magic != SIGDIGGER_IQCODEC_FILE_MAGIC) {
+    this->lastError = path + " is not a compressed SigDigger capture";
+    goto fail;
+  }
+
+  if (this->header.version != SIGDIGGER_IQCODEC_VERSION) {
+    this->lastError = "Unsupported compressed capture version";
+    goto fail;
+  }
+
+  if (!this->loadIndex(static_cast<uint64_t>(sbuf.st_size)))
+    this->rebuildIndex(static_cast<uint64_t>(sbuf.st_size));
+
+  this->position = 0;
+
+  return true;
+
+fail:
+  this->close();
+  return false;
+}
+
+void
+IQCompressedReader::close(void)
+{
+  if (this->fd != -1) {
+    ::close(this->fd);
+    this->fd = -1;
+  }
+
+  this->index.clear();
+  this->haveBlock = false;
+  this->sampleCount = 0;
+  this->position = 0;
+}
+
+bool
+IQCompressedReader::seek(uint64_t sample)
+{
+  if (this->fd == -1 || sample > this->sampleCount)
+    return false;
+
+  this->position = sample;
+
+  return true;
+}
+
+ssize_t
+IQCompressedReader::read(SUCOMPLEX *samples, size_t count)
+{
+  size_t got = 0;
+
+  if (this->fd == -1)
+    return -1;
+
+  while (got < count && this->position < this->sampleCount) {
+    size_t block, offset, chunk;
+
+    if (this->haveBlock
+        && this->position >= this->index[this->currBlock].firstSample
+        && this->position - this->index[this->currBlock].firstSample
+           < this->decoded.size())
+      block = this->currBlock;
+    else
+      block = this->findBlock(this->position);
+
+    if (!this->haveBlock || block != this->currBlock)
+      if (!this->loadBlock(block))
+        return got > 0 ? static_cast<ssize_t>(got) : -1;
+
+    offset = static_cast<size_t>(
+          this->position - this->index[block].firstSample);
+
+    // Gap between blocks (should not happen): stop here.
+    if (offset >= this->decoded.size())
+      break;
+
+    chunk = std::min(count - got, this->decoded.size() - offset);
+
+    std::copy(
+          this->decoded.begin() + static_cast<ssize_t>(offset),
+          this->decoded.begin() + static_cast<ssize_t>(offset + chunk),
+          samples + got);
+
+    got            += chunk;
+    this->position += chunk;
+  }
+
+  return static_cast<ssize_t>(got);
+}
+
+IQCompressedReader::~IQCompressedReader()
+{
+  this->close();
+}
@@ -0,0 +1,98 @@
+//
+//    PackedSymbolStream.cpp: Pack symbol decisions into a bit stream
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <PackedSymbolStream.h>
+#include <utility>
+
+using namespace SigDigger;
+
+void
+PackedSymbolStream::setBitsPerSymbol(unsigned int bps)
+{
+  if (bps < 1)
+    bps = 1;
+  else if (bps > 8)
+    bps = 8;
+
+  if (bps != this->bps) {
+    this->flush();
+    this->bps = bps;
+  }
+}
+
+void
+PackedSymbolStream::append(const uint8_t *data, size_t len)
+{
+  uint32_t mask = (1u << this->bps) - 1;
+  size_t i = 0;
+
+  this->bytes.reserve(
+        this->bytes.size() + (len * this->bps + this->accBits + 7) / 8);
+
+  // Binary streams, byte-aligned: eight symbols per byte, no shifting
+  // across the accumulator.
+  if (this->bps == 1 && this->accBits == 0) {
+    for (; i + 8 <= len; i += 8)
+      this->bytes.push_back(static_cast<uint8_t>(
+            ((data[i + 0] & 1) << 7) | ((data[i + 1] & 1) << 6)
+          | ((data[i + 2] & 1) << 5) | ((data[i + 3] & 1) << 4)
+          | ((data[i + 4] & 1) << 3) | ((data[i + 5] & 1) << 2)
+          | ((data[i + 6] & 1) << 1) |  (data[i + 7] & 1)));
+  }
+
+  for (; i < len; ++i) {
+    this->acc      = (this->acc << this->bps) | (data[i] & mask);
+    this->accBits += this->bps;
+
+    if (this->accBits >= 8) {
+      this->accBits -= 8;
+      this->bytes.push_back(static_cast<uint8_t>(this->acc >> this->accBits));
+      this->acc &= (1u << this->accBits) - 1;
+    }
+  }
+
+  this->symbols += len;
+}
+
+void
+PackedSymbolStream::flush(void)
+{
+  if (this->accBits > 0) {
+    this->bytes.push_back(
+          static_cast<uint8_t>(this->acc << (8 - this->accBits)));
+    this->acc     = 0;
+    this->accBits = 0;
+  }
+}
+
+void
+PackedSymbolStream::clear(void)
+{
+  this->acc     = 0;
+  this->accBits = 0;
+  this->symbols = 0;
+  this->bytes.clear();
+}
+
+void
+PackedSymbolStream::take(std::vector<uint8_t> &dest)
+{
+  dest.clear();
+  std::swap(dest, this->bytes);
+}
@@ -0,0 +1,337 @@
+//
+//    RMSHistory.cpp: Bounded multi-resolution history of power measurements
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <RMSHistory.h>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <algorithm>
+#include <memory>
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  class RMSHistoryTierTask : public QRunnable {
+    RMSHistory *history;
+    unsigned int tier;
+    const float *values;
+    uint64_t count;
+    const RMSHistoryBucket *blocks;
+    uint64_t blockSize;
+
+  public:
+    RMSHistoryTierTask(
+        RMSHistory *history,
+        unsigned int tier,
+        const float *values,
+        uint64_t count,
+        const RMSHistoryBucket *blocks,
+        uint64_t blockSize) :
+      history(history),
+      tier(tier),
+      values(values),
+      count(count),
+      blocks(blocks),
+      blockSize(blockSize)
+    {
+    }
+
+    void
+    run(void) override
+    {
+      this->history->buildTier(
+            this->tier,
+            this->values,
+            this->count,
+            this->blocks,
+            this->blockSize);
+    }
+  };
+}
+
+RMSHistory::RMSHistory(size_t memory)
+{
+  this->clear();
+  this->setMemoryLimit(memory);
+}
+
+void
+RMSHistory::setMemoryLimit(size_t bytes)
+{
+  unsigned int i;
+
+  this->capacity = bytes / (
+        sizeof(float) + (RMS_HISTORY_TIERS - 1) * sizeof(RMSHistoryBucket));
+  if (this->capacity < RMS_HISTORY_FACTOR)
+    this->capacity = RMS_HISTORY_FACTOR;
+
+  for (i = 0; i < RMS_HISTORY_TIERS; ++i) {
+    Tier &tier = this->tiers[i];
+    while (tier.size() > this->capacity)
+      tier.popFront();
+  }
+}
+
+void
+RMSHistory::resetTier(unsigned int index)
+{
+  this->tiers[index] = Tier();
+  this->tiers[index].raw = index == 0;
+}
+
+void
+RMSHistory::clear(void)
+{
+  unsigned int i;
+
+  for (i = 0; i < RMS_HISTORY_TIERS; ++i)
+    this->resetTier(i);
+
+  this->count = 0;
+}
+
+void
+RMSHistory::append(unsigned int index, RMSHistoryBucket const &bucket)
+{
+  Tier &tier = this->tiers[index];
+
+  tier.push(bucket);
+  if (tier.size() > this->capacity)
+    tier.popFront();
+
+  if (index + 1 == RMS_HISTORY_TIERS)
+    return;
+
+  // Partial mean is kept as a sum until the bucket is complete
+  if (tier.partialCount++ == 0) {
+    tier.partial = bucket;
+  } else {
+    tier.partial.min   = std::min(tier.partial.min, bucket.min);
+    tier.partial.max   = std::max(tier.partial.max, bucket.max);
+    tier.partial.mean += bucket.mean;
+  }
+
+  if (tier.partialCount == RMS_HISTORY_FACTOR) {
+    tier.partial.mean /= RMS_HISTORY_FACTOR;
+    tier.partialCount  = 0;
+    this->append(index + 1, tier.partial);
+  }
+}
+
+void
+RMSHistory::push(float value)
+{
+  RMSHistoryBucket bucket;
+
+  bucket.min = bucket.max = bucket.mean = value;
+
+  this->append(0, bucket);
+  ++this->count;
+}
+
+//
+// Computes the buckets of one tier straight from the samples, as if they
+// had been pushed one by one. Only the last `capacity' are kept, so the
+// work per tier is bounded as well. Touches nothing but its own tier.
+//
+void
+RMSHistory::buildTier(
+    unsigned int index,
+    const float *values,
+    uint64_t count,
+    const RMSHistoryBucket *blocks,
+    uint64_t blockSize)
+{
+  Tier &tier = this->tiers[index];
+  RMSHistoryBucket bucket;
+  uint64_t scale = 1;
+  uint64_t n, start, per, i, j;
+  unsigned int k;
+  bool useBlocks;
+  double sum;
+
+  for (k = 0; k < index; ++k)
+    scale *= RMS_HISTORY_FACTOR;
+
+  useBlocks = blocks != nullptr && blockSize > 0 && scale % blockSize == 0;
+  per       = useBlocks ? scale / blockSize : scale;
+
+  n     = count / scale;
+  start = n > this->capacity ? n - this->capacity : 0;
+
+  this->resetTier(index);
+  tier.first = start;
+
+  for (j = start; j < n; ++j) {
+    if (useBlocks) {
+      const RMSHistoryBucket *src = blocks + j * per;
+      bucket = src[0];
+      sum    = src[0].mean;
+      for (i = 1; i < per; ++i) {
+        bucket.min = std::min(bucket.min, src[i].min);
+        bucket.max = std::max(bucket.max, src[i].max);
+        sum       += src[i].mean;
+      }
+    } else {
+      const float *src = values + j * per;
+      bucket.min = bucket.max = src[0];
+      sum = src[0];
+      for (i = 1; i < per; ++i) {
+        bucket.min = std::min(bucket.min, src[i]);
+        bucket.max = std::max(bucket.max, src[i]);
+        sum       += src[i];
+      }
+    }
+
+    bucket.mean = static_cast<float>(sum / static_cast<double>(per));
+    tier.push(bucket);
+  }
+
+  // Buckets not rolled up into the tier above yet. See append().
+  if (index + 1 < RMS_HISTORY_TIERS) {
+    tier.partialCount = static_cast<unsigned>(n % RMS_HISTORY_FACTOR);
+    for (j = n - tier.partialCount; j < n; ++j) {
+      RMSHistoryBucket b = tier.at(j - tier.first);
+      if (j == n - tier.partialCount) {
+        tier.partial = b;
+      } else {
+        tier.partial.min   = std::min(tier.partial.min, b.min);
+        tier.partial.max   = std::max(tier.partial.max, b.max);
+        tier.partial.mean += b.mean;
+      }
+    }
+  }
+}
+
+void
+RMSHistory::load(
+    const float *values,
+    uint64_t count,
+    const RMSHistoryBucket *blocks,
+    uint64_t blockSize)
+{
+  std::unique_ptr<RMSHistoryTierTask> tasks[RMS_HISTORY_TIERS];
+  QThreadPool pool;
+  unsigned int i;
+
+  this->clear();
+
+  pool.setMaxThreadCount(QThread::idealThreadCount());
+
+  for (i = 0; i < RMS_HISTORY_TIERS; ++i) {
+    tasks[i].reset(
+          new RMSHistoryTierTask(this, i, values, count, blocks, blockSize));
+    tasks[i]->setAutoDelete(false);
+    pool.start(tasks[i].get());
+  }
+
+  pool.waitForDone();
+
+  this->count = count;
+}
+
+bool
+RMSHistory::query(
+    unsigned int index,
+    uint64_t from,
+    uint64_t to,
+    RMSHistoryBucket &dest) const
+{
+  Tier const &tier = this->tiers[index];
+  uint64_t scale = 1;
+  uint64_t first, last, end, i;
+  float sum = 0;
+  unsigned int k;
+
+  for (k = 0; k < index; ++k)
+    scale *= RMS_HISTORY_FACTOR;
+
+  first = from / scale;
+  last  = (to + scale - 1) / scale;
+  end   = tier.first + tier.size();
+
+  if (first < tier.first || first >= end)
+    return false;
+
+  if (last > end)
+    last = end;
+
+  dest = tier.at(first - tier.first);
+  for (i = first + 1; i < last; ++i) {
+    RMSHistoryBucket bucket = tier.at(i - tier.first);
+    dest.min = std::min(dest.min, bucket.min);
+    dest.max = std::max(dest.max, bucket.max);
+    sum     += bucket.mean;
+  }
+
+  dest.mean = (dest.mean + sum) / static_cast<float>(last - first);
+
+  return true;
+}
+
+bool
+RMSHistory::query(uint64_t from, uint64_t to, RMSHistoryBucket &dest) const
+{
+  uint64_t scale = RMS_HISTORY_FACTOR;
+  unsigned int best = 0;
+  int i;
+
+  if (to <= from)
+    return false;
+
+  // Coarsest tier that still spends RMS_HISTORY_FACTOR buckets on the
+  // range, so that misaligned edges do not weigh too much.
+  while (best + 1 < RMS_HISTORY_TIERS
+         && scale * RMS_HISTORY_FACTOR <= to - from) {
+    ++best;
+    scale *= RMS_HISTORY_FACTOR;
+  }
+
+  // Too recent for it: samples not rolled up yet are in finer tiers
+  for (i = static_cast<int>(best); i >= 0; --i)
+    if (this->query(static_cast<unsigned>(i), from, to, dest))
+      return true;
+
+  // Too old for it: only coarser tiers remember them
+  for (i = static_cast<int>(best) + 1; i < RMS_HISTORY_TIERS; ++i)
+    if (this->query(static_cast<unsigned>(i), from, to, dest))
+      return true;
+
+  return false;
+}
+
+void
+RMSHistory::render(std::vector<float> &dest, uint64_t decimation) const
+{
+  RMSHistoryBucket bucket;
+  uint64_t i, length;
+  float last = 0;
+
+  if (decimation < 1)
+    decimation = 1;
+
+  length = this->count / decimation;
+  dest.resize(static_cast<size_t>(length));
+
+  for (i = 0; i < length; ++i) {
+    if (this->query(i * decimation, (i + 1) * decimation, bucket))
+      last = bucket.mean;
+    dest[static_cast<size_t>(i)] = last;
+  }
+}
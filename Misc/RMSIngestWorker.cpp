@@ -0,0 +1,123 @@
+//
+//    RMSIngestWorker.cpp: Read RMS feeds off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <RMSIngestWorker.h>
+#include <RMSStream.h>
+#include <QTcpSocket>
+#include <sigutils/log.h>
+
+Q_DECLARE_METATYPE(SigDigger::RMSStream *);
+
+using namespace SigDigger;
+
+RMSIngestWorker::RMSIngestWorker(QObject *parent) : QObject(parent)
+{
+  static bool registered = false;
+
+  if (!registered) {
+    qRegisterMetaType<QTcpSocket *>();
+    qRegisterMetaType<SigDigger::RMSStream *>();
+    registered = true;
+  }
+}
+
+RMSIngestWorker::~RMSIngestWorker()
+{
+  for (auto socket : this->streams.keys())
+    delete socket;
+}
+
+QTcpSocket *
+RMSIngestWorker::findSocket(RMSStream *stream) const
+{
+  for (auto it = this->streams.begin(); it != this->streams.end(); ++it)
+    if (it.value() == stream)
+      return it.key();
+
+  return nullptr;
+}
+
+void
+RMSIngestWorker::drop(QTcpSocket *socket)
+{
+  RMSStream *stream = this->streams.value(socket, nullptr);
+
+  if (stream == nullptr)
+    return;
+
+  this->streams.remove(socket);
+  socket->disconnect(this);
+  socket->close();
+  socket->deleteLater();
+
+  // Last time we touch it
+  stream->setOnline(false);
+}
+
+///////////////////////////////// Slots ////////////////////////////////////////
+void
+RMSIngestWorker::onAdopt(QTcpSocket *socket, RMSStream *stream)
+{
+  this->streams[socket] = stream;
+
+  connect(
+        socket,
+        SIGNAL(readyRead(void)),
+        this,
+        SLOT(onReadyRead(void)));
+
+  connect(
+        socket,
+        SIGNAL(disconnected(void)),
+        this,
+        SLOT(onDisconnected(void)));
+
+  socket->write(RMS_STREAM_CAPS_LINE);
+
+  // Anything that arrived before we were listening
+  if (!stream->ingest(socket))
+    this->drop(socket);
+}
+
+void
+RMSIngestWorker::onClose(RMSStream *stream)
+{
+  QTcpSocket *socket = this->findSocket(stream);
+
+  if (socket != nullptr)
+    this->drop(socket);
+}
+
+void
+RMSIngestWorker::onReadyRead(void)
+{
+  QTcpSocket *socket = static_cast<QTcpSocket *>(this->sender());
+  RMSStream *stream = this->streams.value(socket, nullptr);
+
+  if (stream != nullptr && !stream->ingest(socket)) {
+    SU_WARNING("RMS peer misbehaved, disconnecting\n");
+    this->drop(socket);
+  }
+}
+
+void
+RMSIngestWorker::onDisconnected(void)
+{
+  this->drop(static_cast<QTcpSocket *>(this->sender()));
+}
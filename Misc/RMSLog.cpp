@@ -0,0 +1,569 @@
+//
+//    RMSLog.cpp: Compact binary power logs
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <RMSLog.h>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QDateTime>
+#include <QtEndian>
+#include <sigutils/log.h>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+
+using namespace SigDigger;
+
+namespace SigDigger {
+  static inline void
+  putU32(char *dest, uint32_t value)
+  {
+    value = qToLittleEndian(value);
+    memcpy(dest, &value, sizeof(uint32_t));
+  }
+
+  static inline void
+  putFloat(char *dest, float value)
+  {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(float));
+    putU32(dest, bits);
+  }
+
+  static inline void
+  putDouble(char *dest, double value)
+  {
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(double));
+    bits = qToLittleEndian(bits);
+    memcpy(dest, &bits, sizeof(uint64_t));
+  }
+
+  static inline uint32_t
+  getU32(const uchar *src)
+  {
+    uint32_t value;
+
+    memcpy(&value, src, sizeof(uint32_t));
+    return qFromLittleEndian(value);
+  }
+
+  static inline float
+  getFloat(const uchar *src)
+  {
+    uint32_t bits = getU32(src);
+    float value;
+
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+  }
+
+  static inline double
+  getDouble(const uchar *src)
+  {
+    uint64_t bits;
+    double value;
+
+    memcpy(&bits, src, sizeof(uint64_t));
+    bits = qFromLittleEndian(bits);
+    memcpy(&value, &bits, sizeof(double));
+    return value;
+  }
+
+  class RMSLogDecodeTask : public QRunnable {
+    const uchar *map;
+    const qint64 *offsets;
+    const uint32_t *counts;
+    const uint64_t *firsts;
+    size_t blocks;
+    float *values;
+
+  public:
+    RMSLogDecodeTask(
+        const uchar *map,
+        const qint64 *offsets,
+        const uint32_t *counts,
+        const uint64_t *firsts,
+        size_t blocks,
+        float *values) :
+      map(map),
+      offsets(offsets),
+      counts(counts),
+      firsts(firsts),
+      blocks(blocks),
+      values(values)
+    {
+    }
+
+    void
+    run(void) override
+    {
+      size_t i;
+      uint32_t j;
+
+      for (i = 0; i < this->blocks; ++i) {
+        const uchar *p = this->map + this->offsets[i] + sizeof(double);
+        float *dest = this->values + this->firsts[i];
+
+        for (j = 0; j < this->counts[i]; ++j, p += RMS_LOG_RECORD_SIZE)
+          dest[j] = getFloat(p);
+      }
+    }
+  };
+}
+
+////////////////////////////// RMSLogFileWriter ////////////////////////////////
+RMSLogFileWriter::RMSLogFileWriter(bool summary) : m_summary(summary)
+{
+  m_block.resize(RMS_LOG_BLOCK_SIZE * RMS_LOG_RECORD_SIZE);
+}
+
+RMSLogFileWriter::~RMSLogFileWriter()
+{
+  this->close();
+}
+
+bool
+RMSLogFileWriter::open(std::string const &path, qreal rate)
+{
+  char header[RMS_LOG_HEADER_SIZE];
+
+  if (m_fp != nullptr)
+    return false;
+
+  if ((m_fp = fopen(path.c_str(), "wb")) == nullptr) {
+    SU_ERROR("Cannot open %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  memset(header, 0, sizeof(header));
+  memcpy(header, RMS_LOG_MAGIC, 8);
+  putU32(header + 8, RMS_LOG_VERSION);
+  putU32(header + 12, m_summary ? RMS_LOG_FLAG_SUMMARY : 0);
+  putU32(header + 16, RMS_LOG_BLOCK_SIZE);
+  putDouble(header + 24, rate);
+
+  if (fwrite(header, sizeof(header), 1, m_fp) != 1) {
+    SU_ERROR("Cannot write log header: %s\n", strerror(errno));
+    fclose(m_fp);
+    m_fp = nullptr;
+    return false;
+  }
+
+  m_count       = 0;
+  m_synced      = 0;
+  m_blockOffset = RMS_LOG_HEADER_SIZE;
+  m_lastSync.start();
+
+  return true;
+}
+
+//
+// Writes the block being filled with its current count. Its header and
+// any records already synced are overwritten in place, so the block only
+// moves on once it is full.
+//
+bool
+RMSLogFileWriter::flush(void)
+{
+  char header[4 + 3 * sizeof(float)];
+  size_t headerSize = 4;
+  size_t pending = m_count - m_synced;
+
+  m_lastSync.restart();
+
+  if (m_count == m_synced)
+    return true;
+
+  putU32(header, m_count);
+
+  if (m_summary) {
+    putFloat(header + 4, m_stats.min);
+    putFloat(header + 8, m_stats.max);
+    putFloat(header + 12, static_cast<float>(m_sum / m_count));
+    headerSize += 3 * sizeof(float);
+  }
+
+  if (fseek(m_fp, m_blockOffset, SEEK_SET) == -1
+      || fwrite(header, headerSize, 1, m_fp) != 1
+      || fseek(
+        m_fp,
+        static_cast<long>(m_synced * RMS_LOG_RECORD_SIZE),
+        SEEK_CUR) == -1
+      || fwrite(
+        m_block.data() + m_synced * RMS_LOG_RECORD_SIZE,
+        RMS_LOG_RECORD_SIZE,
+        pending,
+        m_fp) != pending
+      || fflush(m_fp) != 0) {
+    SU_ERROR("Cannot write log block: %s\n", strerror(errno));
+    return false;
+  }
+
+  m_synced = m_count;
+
+  if (m_count == RMS_LOG_BLOCK_SIZE) {
+    m_blockOffset += static_cast<long>(
+          headerSize + m_count * RMS_LOG_RECORD_SIZE);
+    m_count  = 0;
+    m_synced = 0;
+  }
+
+  return true;
+}
+
+bool
+RMSLogFileWriter::write(qreal timeStamp, float power)
+{
+  char *record;
+
+  if (m_fp == nullptr)
+    return false;
+
+  if (m_count == 0) {
+    m_stats.min = m_stats.max = power;
+    m_sum = 0;
+  } else {
+    m_stats.min = std::min(m_stats.min, power);
+    m_stats.max = std::max(m_stats.max, power);
+  }
+
+  m_sum += power;
+
+  record = m_block.data() + m_count * RMS_LOG_RECORD_SIZE;
+  putDouble(record, timeStamp);
+  putFloat(record + sizeof(double), power);
+
+  if (++m_count == RMS_LOG_BLOCK_SIZE
+      || m_lastSync.hasExpired(1000 * RMS_LOG_SYNC_INTERVAL))
+    return this->flush();
+
+  return true;
+}
+
+bool
+RMSLogFileWriter::close(void)
+{
+  bool ok = true;
+
+  if (m_fp != nullptr) {
+    // Last block may be short
+    ok = this->flush();
+    if (fclose(m_fp) != 0)
+      ok = false;
+    m_fp = nullptr;
+  }
+
+  return ok;
+}
+
+//////////////////////////////// RMSLogReader //////////////////////////////////
+RMSLogReader::~RMSLogReader()
+{
+  this->close();
+}
+
+bool
+RMSLogReader::fail(QString const &error)
+{
+  m_error = error;
+  this->close();
+
+  return false;
+}
+
+void
+RMSLogReader::close(void)
+{
+  if (m_map != nullptr) {
+    m_file.unmap(const_cast<uchar *>(m_map));
+    m_map = nullptr;
+  }
+
+  if (m_file.isOpen())
+    m_file.close();
+
+  m_blocks.clear();
+  m_summaries.clear();
+  m_count = 0;
+  m_size = 0;
+}
+
+bool
+RMSLogReader::open(QString const &path)
+{
+  qint64 offset = RMS_LOG_HEADER_SIZE;
+  qint64 blockHeader;
+  uint32_t count, avail;
+  bool uniform = true;
+
+  this->close();
+
+  m_file.setFileName(path);
+  if (!m_file.open(QIODevice::ReadOnly))
+    return this->fail("Cannot open file: " + m_file.errorString());
+
+  m_size = m_file.size();
+  if (m_size < RMS_LOG_HEADER_SIZE)
+    return this->fail("File is too short to be a power log");
+
+  if ((m_map = m_file.map(0, m_size)) == nullptr)
+    return this->fail("Cannot map file: " + m_file.errorString());
+
+  if (memcmp(m_map, RMS_LOG_MAGIC, 8) != 0)
+    return this->fail("Not a SigDigger power log");
+
+  if (getU32(m_map + 8) != RMS_LOG_VERSION)
+    return this->fail("Unsupported power log version");
+
+  m_flags     = getU32(m_map + 12);
+  m_blockSize = getU32(m_map + 16);
+  m_rate      = getDouble(m_map + 24);
+
+  if (m_blockSize == 0)
+    return this->fail("Invalid block size");
+
+  blockHeader = 4;
+  if (m_flags & RMS_LOG_FLAG_SUMMARY)
+    blockHeader += 3 * sizeof(float);
+
+  // Only block headers are touched here. A truncated last block (e.g.
+  // the logger was killed) is read up to its last complete record.
+  while (offset + blockHeader <= m_size) {
+    count = getU32(m_map + offset);
+    if (count == 0 || count > m_blockSize)
+      return this->fail("Corrupt block at offset " + QString::number(offset));
+
+    avail = static_cast<uint32_t>(std::min<qint64>(
+          count,
+          (m_size - offset - blockHeader) / RMS_LOG_RECORD_SIZE));
+    if (avail == 0)
+      break;
+
+    // Summaries are only usable if all blocks but the last are full
+    if (!m_blocks.empty() && m_blocks.back().count != m_blockSize)
+      uniform = false;
+
+    if (m_flags & RMS_LOG_FLAG_SUMMARY) {
+      RMSHistoryBucket summary;
+      summary.min  = getFloat(m_map + offset + 4);
+      summary.max  = getFloat(m_map + offset + 8);
+      summary.mean = getFloat(m_map + offset + 12);
+      m_summaries.push_back(summary);
+    }
+
+    m_blocks.push_back({offset + blockHeader, avail});
+    m_count += avail;
+
+    if (avail < count)
+      break;
+
+    offset += blockHeader + static_cast<qint64>(count) * RMS_LOG_RECORD_SIZE;
+  }
+
+  if (!uniform)
+    m_summaries.clear();
+
+  if (m_count == 0)
+    return this->fail("Power log is empty");
+
+  return true;
+}
+
+void
+RMSLogReader::load(RMSHistory &history) const
+{
+  std::vector<qint64> offsets(m_blocks.size());
+  std::vector<uint32_t> counts(m_blocks.size());
+  std::vector<uint64_t> firsts(m_blocks.size());
+  std::vector<float> values(m_count);
+  std::vector<std::unique_ptr<RMSLogDecodeTask>> tasks;
+  QThreadPool pool;
+  uint64_t first = 0;
+  size_t i, per, threads;
+
+  for (i = 0; i < m_blocks.size(); ++i) {
+    offsets[i] = m_blocks[i].offset;
+    counts[i]  = m_blocks[i].count;
+    firsts[i]  = first;
+    first     += m_blocks[i].count;
+  }
+
+  threads = static_cast<size_t>(std::max(1, QThread::idealThreadCount()));
+  per     = (m_blocks.size() + threads - 1) / threads;
+
+  pool.setMaxThreadCount(static_cast<int>(threads));
+
+  for (i = 0; i < m_blocks.size(); i += per) {
+    tasks.emplace_back(
+          new RMSLogDecodeTask(
+            m_map,
+            offsets.data() + i,
+            counts.data() + i,
+            firsts.data() + i,
+            std::min(per, m_blocks.size() - i),
+            values.data()));
+    tasks.back()->setAutoDelete(false);
+    pool.start(tasks.back().get());
+  }
+
+  pool.waitForDone();
+
+  history.load(
+        values.data(),
+        m_count,
+        m_summaries.empty() ? nullptr : m_summaries.data(),
+        m_blockSize);
+}
+
+QString
+RMSLogReader::getError(void) const
+{
+  return m_error;
+}
+
+uint64_t
+RMSLogReader::size(void) const
+{
+  return m_count;
+}
+
+qreal
+RMSLogReader::getFirstTimeStamp(void) const
+{
+  if (m_blocks.empty())
+    return 0;
+
+  return getDouble(m_map + m_blocks.front().offset);
+}
+
+qreal
+RMSLogReader::getLastTimeStamp(void) const
+{
+  if (m_blocks.empty())
+    return 0;
+
+  return getDouble(
+        m_map
+        + m_blocks.back().offset
+        + static_cast<qint64>(m_blocks.back().count - 1) * RMS_LOG_RECORD_SIZE);
+}
+
+qreal
+RMSLogReader::getRate(void) const
+{
+  qreal span;
+
+  if (m_rate > 0)
+    return m_rate;
+
+  // Not recorded: assume measures evenly spread
+  span = this->getLastTimeStamp() - this->getFirstTimeStamp();
+  if (m_count > 1 && span > 0)
+    return static_cast<qreal>(m_count - 1) / span;
+
+  return 1;
+}
+
+///////////////////////////// Datasaver callbacks //////////////////////////////
+extern "C" {
+  static char *
+  sigdigger_rms_log_fname(void *)
+  {
+    QString name =
+        "sigdigger_rms_"
+        + QDateTime::currentDateTimeUtc().toString("yyyyMMdd_HHmmss")
+        + "." RMS_LOG_EXTENSION;
+
+    return strdup(name.toStdString().c_str());
+  }
+
+  static void *
+  sigdigger_rms_log_open(void *userdata)
+  {
+    const hashlist_t *params = static_cast<const hashlist_t *>(userdata);
+    const char *path, *interval;
+    RMSLogFileWriter *writer;
+    qreal rate = 0;
+
+    path = static_cast<const char *>(hashlist_get(params, "path"));
+    if (path == nullptr) {
+      SU_ERROR("No path given for the power log\n");
+      return nullptr;
+    }
+
+    // Integration time, in milliseconds
+    interval = static_cast<const char *>(hashlist_get(params, "interval"));
+    if (interval != nullptr && strtod(interval, nullptr) > 0)
+      rate = 1e3 / strtod(interval, nullptr);
+
+    writer = new RMSLogFileWriter();
+    if (!writer->open(path, rate)) {
+      delete writer;
+      return nullptr;
+    }
+
+    return writer;
+  }
+
+  static SUBOOL
+  sigdigger_rms_log_write(
+      void *state,
+      const struct suscli_sample *samples,
+      size_t length)
+  {
+    RMSLogFileWriter *writer = static_cast<RMSLogFileWriter *>(state);
+    size_t i;
+
+    for (i = 0; i < length; ++i)
+      if (!writer->write(
+            static_cast<qreal>(samples[i].timestamp.tv_sec)
+            + 1e-6 * static_cast<qreal>(samples[i].timestamp.tv_usec),
+            samples[i].value))
+        return SU_FALSE;
+
+    return SU_TRUE;
+  }
+
+  static SUBOOL
+  sigdigger_rms_log_close(void *state)
+  {
+    RMSLogFileWriter *writer = static_cast<RMSLogFileWriter *>(state);
+    bool ok = writer->close();
+
+    delete writer;
+
+    return ok ? SU_TRUE : SU_FALSE;
+  }
+}
+
+void
+SigDigger::sigdigger_rms_log_params_init(
+    struct suscli_datasaver_params *self,
+    const hashlist_t *params)
+{
+  self->userdata = const_cast<hashlist_t *>(params);
+  self->fname    = sigdigger_rms_log_fname;
+  self->open     = sigdigger_rms_log_open;
+  self->write    = sigdigger_rms_log_write;
+  self->close    = sigdigger_rms_log_close;
+}
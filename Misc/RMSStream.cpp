@@ -0,0 +1,263 @@
+//
+//    RMSStream.cpp: One remote power meter, independent of any widget
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <RMSStream.h>
+#include <QIODevice>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+using namespace SigDigger;
+
+RMSStream::RMSStream(QString const &peer)
+{
+  this->info.peer = peer;
+
+  // Whatever is left after a read is shorter than a line
+  this->rxBuffer.resize(RMS_STREAM_READ_SIZE + RMS_STREAM_MAX_LINE_SIZE);
+}
+
+void
+RMSStream::measure(qreal timeStamp, qreal mag)
+{
+  if (this->info.count++ == 0) {
+    this->info.min = this->info.max = mag;
+  } else {
+    this->info.min = std::min(this->info.min, mag);
+    this->info.max = std::max(this->info.max, mag);
+  }
+
+  this->info.last     = mag;
+  this->info.lastTime = timeStamp;
+
+  if (this->keep) {
+    if (this->pending.size() >= RMS_STREAM_MAX_PENDING)
+      this->pending.erase(
+            this->pending.begin(),
+            this->pending.begin() + RMS_STREAM_MAX_PENDING / 2);
+    this->pending.push_back({timeStamp, mag});
+  }
+}
+
+//
+// Parses one line in place. `line' is NUL-terminated, and its commas
+// are overwritten to split it into fields without copying.
+//
+bool
+RMSStream::parseLine(char *line, size_t len)
+{
+  char *fields[4];
+  unsigned int count = 1;
+  char *p, *end;
+  long sec;
+  qreal usec, rate;
+  float mag;
+
+  // Description line allows commas and stuff
+  if (strncmp(line, "DESC,", 5) == 0) {
+    this->info.title = QString::fromUtf8(line + 5, static_cast<int>(len - 5));
+    ++this->info.titleSerial;
+    return true;
+  }
+
+  if (strcmp(line, RMS_STREAM_BINARY_LINE) == 0) {
+    this->binary = true;
+    return true;
+  }
+
+  fields[0] = line;
+  for (p = line; *p != '\0'; ++p) {
+    if (*p == ',') {
+      if (count == 4)
+        return false;
+      *p = '\0';
+      fields[count++] = p + 1;
+    }
+  }
+
+  if (count == 2) {
+    if (strcmp(fields[0], "RATE") != 0)
+      return false;
+
+    rate = strtod(fields[1], &end);
+    if (end == fields[1])
+      return false;
+
+    this->info.rate = rate;
+    ++this->info.rateSerial;
+    return true;
+  } else if (count == 4) {
+    sec = strtol(fields[0], &end, 10);
+    if (end == fields[0])
+      return false;
+
+    usec = strtod(fields[1], &end);
+    if (end == fields[1])
+      return false;
+
+    mag = strtof(fields[2], &end);
+    if (end == fields[2])
+      return false;
+
+    // The dB field is redundant, but must be there
+    (void) strtof(fields[3], &end);
+    if (end == fields[3])
+      return false;
+
+    this->measure(static_cast<qreal>(sec) + usec, static_cast<qreal>(mag));
+
+    return true;
+  }
+
+  return false;
+}
+
+size_t
+RMSStream::parseText(char *data, size_t len)
+{
+  char *p = data;
+  char *nl;
+  size_t lineLen;
+
+  // Stops right after a switch to binary. The caller takes it from there.
+  while (!this->binary) {
+    nl = static_cast<char *>(
+          memchr(p, '\n', len - static_cast<size_t>(p - data)));
+    if (nl == nullptr)
+      break;
+
+    lineLen = static_cast<size_t>(nl - p);
+    if (lineLen > 0 && p[lineLen - 1] == '\r')
+      --lineLen;
+    p[lineLen] = '\0';
+
+    this->parseLine(p, lineLen);
+    p = nl + 1;
+  }
+
+  return static_cast<size_t>(p - data);
+}
+
+size_t
+RMSStream::parseBinary(const char *data, size_t len)
+{
+  size_t p;
+  quint64 tsBits;
+  quint32 magBits;
+  double timeStamp;
+  float mag;
+
+  for (p = 0;
+       p + RMS_STREAM_RECORD_SIZE <= len;
+       p += RMS_STREAM_RECORD_SIZE) {
+    memcpy(&tsBits, data + p, sizeof(quint64));
+    memcpy(&magBits, data + p + sizeof(quint64), sizeof(quint32));
+
+    tsBits  = qFromLittleEndian(tsBits);
+    magBits = qFromLittleEndian(magBits);
+
+    memcpy(&timeStamp, &tsBits, sizeof(double));
+    memcpy(&mag, &magBits, sizeof(float));
+
+    this->measure(static_cast<qreal>(timeStamp), static_cast<qreal>(mag));
+  }
+
+  return p;
+}
+
+bool
+RMSStream::ingest(QIODevice *dev)
+{
+  char *buf = this->rxBuffer.data();
+  size_t consumed;
+  qint64 got;
+  bool wasBinary;
+
+  while (dev->bytesAvailable() > 0) {
+    got = dev->read(
+          buf + this->rxLen,
+          static_cast<qint64>(this->rxBuffer.size() - this->rxLen));
+    if (got < 1)
+      return false;
+
+    this->rxLen += static_cast<size_t>(got);
+
+    QMutexLocker locker(&this->mutex);
+
+    // The peer may switch to binary in the middle of a read
+    consumed = 0;
+    do {
+      wasBinary = this->binary;
+      if (this->binary)
+        consumed += this->parseBinary(buf + consumed, this->rxLen - consumed);
+      else
+        consumed += this->parseText(buf + consumed, this->rxLen - consumed);
+    } while (wasBinary != this->binary);
+
+    this->rxLen -= consumed;
+    memmove(buf, buf + consumed, this->rxLen);
+
+    // Remote peer attempted to flood us
+    if (!this->binary && this->rxLen >= RMS_STREAM_MAX_LINE_SIZE) {
+      this->rxLen = 0;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void
+RMSStream::setOnline(bool online)
+{
+  QMutexLocker locker(&this->mutex);
+
+  this->info.online = online;
+}
+
+void
+RMSStream::setKeepMeasures(bool keep)
+{
+  QMutexLocker locker(&this->mutex);
+
+  this->keep = keep;
+  if (!keep)
+    this->pending.clear();
+}
+
+bool
+RMSStream::takeMeasures(std::vector<RMSMeasure> &dest)
+{
+  QMutexLocker locker(&this->mutex);
+
+  dest.clear();
+  std::swap(dest, this->pending);
+
+  return !dest.empty();
+}
+
+RMSStreamInfo
+RMSStream::getInfo(void) const
+{
+  QMutexLocker locker(&this->mutex);
+
+  return this->info;
+}
@@ -18,7 +18,7 @@
 //
 
 #include "SNREstimator.h"
-#include <cstdio>
+#include <algorithm>
 
 using namespace SigDigger;
 
@@ -28,155 +28,125 @@ SNREstimator::SNREstimator()
 }
 
 void
-SNREstimator::recalculateModel(void)
+SNREstimator::recalculateModel(unsigned int length)
 {
-  if (this->length > 0 && this->intervals > 0) {
-    unsigned int i, j;
-    float x;
-    float max = 0;
-    float intlen, start;
-    float sigma2 = this->sigma * this->sigma;
-
-    // Step 1: compute gaussian
-    for (i = 0; i < this->length; ++i) {
-      x = i * this->hx;
-      if (x >= .5f)
-        x -= 1.f;
-
-      this->gaussian[i] = expf(-x * x / sigma2);
+  unsigned int i;
+  int k;
+  float u, d, x, max = 0;
+  float sigma2 = this->sigma * this->sigma;
+
+  this->Hi.resize(length);
+
+  if (length == 0 || this->intervals == 0)
+    return;
+
+  // Distance to the center of each bin's own interval and both
+  // neighbours. Farther centers contribute nothing at any useful SNR.
+  for (i = 0; i < length; ++i) {
+    u = static_cast<float>(i) * this->intervals / length;
+    d = u - floorf(u) - .5f;
+
+    this->Hi[i] = 0;
+    for (k = -1; k <= 1; ++k) {
+      x = (d + k) / this->intervals;
+      this->Hi[i] += expf(-x * x / sigma2);
     }
 
-    // Step 2: Repeat in through the whole interval, N times
-    intlen = 1.f  / this->intervals;
-    start = .5f * intlen;
-
-    std::fill(this->Hi.begin(), this->Hi.end(), 0.f);
+    if (this->Hi[i] > max)
+      max = this->Hi[i];
+  }
 
-    for (j = 0; j < this->intervals; ++j) {
-      float skip = start + j * intlen;
-      float t = 1.f - (skip - floorf(skip));
-      unsigned int skipint = static_cast<unsigned>(floorf(this->length * skip));
-      unsigned int i1, i2;
-      for (i = 0; i < this->length; ++i) {
-        i1 = static_cast<unsigned>(this->length + i - skipint) % this->length;
-        i2 = static_cast<unsigned>(this->length + i1 - 1) % this->length;
+  if (max > 0.f)
+    for (i = 0; i < length; ++i)
+      this->Hi[i] /= max;
 
-        this->Hi[i] += t * this->gaussian[i1];
-        this->Hi[i] += (1 - t) * this->gaussian[i2];
-      }
-    }
-
-    // Step 3: Normalize
-    for (i = 0; i < this->length; ++i)
-      if (this->Hi[i] > max)
-        max = this->Hi[i];
+  this->dirty = false;
+}
 
-    if (max > 0.f)
-      for (i = 0; i < this->length; ++i)
-        this->Hi[i] /= max;
+void
+SNREstimator::setBps(unsigned int bps)
+{
+  if (this->bps != bps) {
+    this->bps = bps;
+    this->intervals = 1 << bps;
+    this->reset();
   }
 }
 
 void
-SNREstimator::iterate()
+SNREstimator::setDecisionMode(bool modulus)
 {
-  if (this->length > 0 && this->intervals > 0) {
-    float delta = 0, x;
-    float term;
-    unsigned int i, j;
-    float intlen, start;
-    float skip;
-    float sigmainv = 1.f / this->sigma;
-    float sigma3inv = sigmainv * sigmainv * sigmainv;
-
-    this->recalculateModel();
-
-    intlen = 1.f  / this->intervals;
-    start = .5f * intlen;
-
-    for (i = 0; i < this->length; ++i) {
-      x = i * this->hx;
-      if (x >= .5f)
-        x -= 1.f;
-
-      term = 0;
-      for (j = 0; j < this->intervals; ++j) {
-        skip = start + j * intlen;
-        term += (x - skip) * (x - skip);
-      }
-
-      term *= (this->Hi[i] - this->Htilde[i]) / sigma3inv;
-
-      delta += term;
-    }
-
-    this->delta = delta / this->length;
-    this->sigma += -this->alpha * this->delta;
-    this->dirty = true;
+  if (this->modulus != modulus) {
+    this->modulus = modulus;
+    this->reset();
   }
 }
 
 void
-SNREstimator::calculateSquareError(void)
+SNREstimator::setRange(float min, float max)
 {
-  if (this->length && this->intervals > 0) {
-    float err;
-    this->sqerr = 0;
-    for (unsigned i = 0; i < this->length; ++i) {
-      err = (this->Hi[i] - this->Htilde[i]) * (this->Hi[i] - this->Htilde[i]);
-      this->sqerr += err * err;
-    }
+  this->min   = min;
+  this->range = max - min;
+  this->reset();
+}
 
-    this->dirty = false;
-  }
+void
+SNREstimator::setWindow(unsigned int samples)
+{
+  this->alpha = 1.f / std::max(samples, 1u);
 }
 
 void
-SNREstimator::setBps(unsigned int bps)
+SNREstimator::reset(void)
 {
-  if (this->bps != bps) {
-    this->bps = bps;
-    this->sigma = SNR_ESTIMATOR_DEFAULT_SIGMA;
-    this->intervals = 1 << bps;
-    this->hx = 1.f / this->length;
-  }
+  this->m2    = 0;
+  this->count = 0;
+  this->sigma = SNR_ESTIMATOR_DEFAULT_SIGMA;
+  this->dirty = true;
 }
 
 void
-SNREstimator::feed(std::vector<unsigned int> const &history)
+SNREstimator::feed(const SUCOMPLEX *data, size_t size)
 {
-  unsigned int max = 0;
-
-  if (this->length != history.size()) {
-    this->length = static_cast<unsigned int>(history.size());
-    this->gaussian.resize(this->length);
-    this->Hi.resize(this->length);
-    this->Htilde.resize(this->length);
-    this->hx = 1.f / this->length;
-  }
+  float k, x, u, d, a;
+  float m2 = this->m2;
+  unsigned int count = this->count;
+  size_t i;
 
-  for (unsigned int i = 0; i < history.size(); ++i)
-    if (max < history[i])
-      max = history[i];
+  if (this->intervals == 0 || this->range <= 0 || size == 0)
+    return;
 
-  if (max == 0)
-    max = 1;
+  k = this->intervals / this->range;
 
-  for (unsigned int i = 0; i < history.size(); ++i)
-    this->Htilde[i] = static_cast<float>(history[i]) / max;
+  for (i = 0; i < size; ++i) {
+    x = this->modulus ? SU_C_ABS(data[i]) : SU_C_ARG(data[i]);
+    u = (x - this->min) * k;
+    d = u - floorf(u) - .5f;
 
-  this->iterate();
-}
+    // Plain mean until the window is full, exponential afterwards
+    if (count * this->alpha < 1.f)
+      ++count;
+    a = std::max(this->alpha, 1.f / count);
 
-void
-SNREstimator::setAlpha(float alpha)
-{
-  this->alpha = alpha;
+    m2 += a * (d * d - m2);
+  }
+
+  this->m2    = m2;
+  this->count = count;
+
+  // exp(-x^2 / sigma^2) has variance sigma^2 / 2. Offsets are measured in
+  // interval units, hence the division by the number of intervals.
+  if (m2 > 0) {
+    this->sigma = sqrtf(2 * m2) / this->intervals;
+    this->dirty = true;
+  }
 }
 
-void
-SNREstimator::setSigma(float sigma)
+std::vector<float> const &
+SNREstimator::getModel(unsigned int length)
 {
-  this->sigma = sigma;
-}
+  if (this->dirty || this->Hi.size() != length)
+    this->recalculateModel(length);
 
+  return this->Hi;
+}
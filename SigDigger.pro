@@ -6,6 +6,7 @@
 
 QT           += core gui network widgets opengl
 unix: QMAKE_LFLAGS   += -rdynamic
+linux: LIBS          += -lrt
 darwin: QMAKE_LFLAGS += -Wl,-export_dynamic
 
 greaterThan(QT_MAJOR_VERSION, 5): QT += openglwidgets
@@ -111,9 +112,11 @@ SOURCES += \
     Default/DefaultTab/DefaultTabWidgetFactory.cpp \
     Default/FFT/FFTWidget.cpp \
     Default/FFT/FFTWidgetFactory.cpp \
+    Default/GenericInspector/FACProcessorWorker.cpp \
     Default/GenericInspector/FACTab.cpp \
     Default/GenericInspector/GenericInspector.cpp \
     Default/GenericInspector/GenericInspectorFactory.cpp \
+    Default/GenericInspector/InspectorFeedWorker.cpp \
     Default/GenericInspector/InspectorCtl/AfcControl.cpp \
     Default/GenericInspector/InspectorCtl/AskControl.cpp \
     Default/GenericInspector/InspectorCtl/ClockRecovery.cpp \
@@ -125,6 +128,8 @@ SOURCES += \
     Default/GenericInspector/InspectorCtl/ToneControl.cpp \
     Default/GenericInspector/InspectorUI.cpp \
     Default/GenericInspector/SymViewTab.cpp \
+    Default/GenericInspector/SyncWordTab.cpp \
+    Default/GenericInspector/SyncWordWorker.cpp \
     Default/GenericInspector/TVProcessorTab.cpp \
     Default/GenericInspector/TVProcessorWorker.cpp \
     Default/GenericInspector/WaveformTab.cpp \
@@ -132,6 +137,8 @@ SOURCES += \
     Default/Inspection/InspToolWidgetFactory.cpp \
     Default/RMSInspector/RMSInspector.cpp \
     Default/RMSInspector/RMSInspectorFactory.cpp \
+    Default/RMSInspector/RMSLogWriter.cpp \
+    Default/RMSInspector/SpectrumBandMeter.cpp \
     Default/Registration.cpp \
     Default/Source/SourceWidget.cpp \
     Default/Source/SourceWidgetFactory.cpp \
@@ -147,8 +154,10 @@ SOURCES += \
     Default/SourceTimeWidget/SourceTimeWidget.cpp \
     Misc/AutoGain.cpp \
     Misc/Averager.cpp \
+    Misc/ConstellationDensity.cpp \
     Misc/FileViewer.cpp \
     Misc/GlobalProperty.cpp \
+    Misc/IQCodec.cpp \
     Misc/Palette.cpp \
     Misc/SNREstimator.cpp \
     Misc/SigDiggerHelpers.cpp \
@@ -212,8 +221,17 @@ SOURCES += \
     UIMediator/UIMediator.cpp \
     main.cpp \
     Misc/GenericDataSaver.cpp \
+    Misc/CompressedFileDataSaver.cpp \
+    Misc/ChunkedExecutor.cpp \
+    Misc/FFTWPlanCache.cpp \
     Misc/FileDataSaver.cpp \
+    Misc/PackedSymbolStream.cpp \
+    Misc/RMSHistory.cpp \
+    Misc/RMSIngestWorker.cpp \
+    Misc/RMSLog.cpp \
+    Misc/RMSStream.cpp \
     UDP/SocketForwarder.cpp \
+    UDP/SharedMemoryForwarder.cpp \
     Components/NetForwarderUI.cpp \
     Components/WaitingSpinnerWidget.cpp \
     Components/DeviceDialog.cpp \
@@ -241,8 +259,15 @@ INSTALL_HEADERS += \
     include/AudioPlayback.h \
     include/Averager.h \
     include/ColorConfig.h \
+    include/ConstellationDensity.h \
     include/ConfigTab.h \
     include/FeatureFactory.h \
+    include/FFTWPlanCache.h \
+    include/PackedSymbolStream.h \
+    include/RMSHistory.h \
+    include/RMSIngestWorker.h \
+    include/RMSLog.h \
+    include/RMSStream.h \
     include/GuiConfig.h \
     include/GlobalProperty.h \
     include/InspectionWidgetFactory.h \
@@ -315,9 +340,11 @@ HEADERS += \
     Default/DefaultTab/DefaultTabWidgetFactory.h \
     Default/FFT/FFTWidget.h \
     Default/FFT/FFTWidgetFactory.h \
+    Default/GenericInspector/FACProcessorWorker.h \
     Default/GenericInspector/FACTab.h \
     Default/GenericInspector/GenericInspector.h \
     Default/GenericInspector/GenericInspectorFactory.h \
+    Default/GenericInspector/InspectorFeedWorker.h \
     Default/GenericInspector/InspectorCtl/AfcControl.h \
     Default/GenericInspector/InspectorCtl/AskControl.h \
     Default/GenericInspector/InspectorCtl/ClockRecovery.h \
@@ -329,6 +356,8 @@ HEADERS += \
     Default/GenericInspector/InspectorCtl/ToneControl.h \
     Default/GenericInspector/InspectorUI.h \
     Default/GenericInspector/SymViewTab.h \
+    Default/GenericInspector/SyncWordTab.h \
+    Default/GenericInspector/SyncWordWorker.h \
     Default/GenericInspector/TVProcessorTab.h \
     Default/GenericInspector/TVProcessorWorker.h \
     Default/GenericInspector/WaveformTab.h \
@@ -336,6 +365,8 @@ HEADERS += \
     Default/Inspection/InspToolWidgetFactory.h \
     Default/RMSInspector/RMSInspector.h \
     Default/RMSInspector/RMSInspectorFactory.h \
+    Default/RMSInspector/RMSLogWriter.h \
+    Default/RMSInspector/SpectrumBandMeter.h \
     Default/Registration.h \
     Default/Source/SourceWidget.h \
     Default/Source/SourceWidgetFactory.h \
@@ -356,6 +387,7 @@ HEADERS += \
     include/AudioConfigTab.h \
     include/CarrierDetector.h \
     include/CarrierXlator.h \
+    include/ChunkedExecutor.h \
     include/ColorConfigTab.h \
     include/CostasRecoveryTask.h \
     include/DelayedConjTask.h \
@@ -392,11 +424,15 @@ HEADERS += \
     include/Loader.h \
     include/SaveProfileDialog.h \
     include/SNREstimator.h \
+    include/SPSCRing.h \
     include/Suscan/Device.h \
     include/TLESourceTab.h \
     include/TimeWindow.h \
     include/FileDataSaver.h \
+    include/CompressedFileDataSaver.h \
+    include/IQCodec.h \
     include/SocketForwarder.h \
+    include/SharedMemoryForwarder.h \
     include/NetForwarderUI.h \
     include/ToolBarWidgetFactory.h \
     include/WaitingSpinnerWidget.h \
@@ -424,6 +460,7 @@ FORMS += \
     Default/GenericInspector/FACTab.ui \
     Default/GenericInspector/GenericInspector.ui \
     Default/GenericInspector/SymViewTab.ui \
+    Default/GenericInspector/SyncWordTab.ui \
     Default/GenericInspector/TVProcessorTab.ui \
     Default/GenericInspector/WaveformTab.ui \
     Default/Inspection/InspToolWidget.ui \
@@ -486,6 +523,9 @@ unix {
 CONFIG += link_pkgconfig
 PKGCONFIG += suscan fftw3f
 
+# Needed by fftwf_make_planner_thread_safe
+LIBS += -lfftw3f_threads
+
 packagesExist(libcurl) {
   PKGCONFIG += libcurl
   QMAKE_CXXFLAGS += -DHAVE_CURL
@@ -533,6 +573,7 @@ CONFIG(debug, debug|release): BUILD_CONFIG = debug
 INCLUDEPATH += $$PWD/../SuWidgets
 INCLUDEPATH += $$PWD/..
 LIBS += -L$$PWD/../build/SuWidgets/$$BUILD_CONFIG/ -lsuwidgets
+LIBS += -lfftw3f_threads
 
 }
 
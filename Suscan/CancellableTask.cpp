@@ -18,6 +18,7 @@
 //
 #include <Suscan/CancellableTask.h>
 #include <Suscan/Library.h>
+#include <QElapsedTimer>
 
 using namespace Suscan;
 
@@ -61,11 +62,29 @@ CancellableTask::setStatus(QString status)
   this->status = status;
 }
 
+void
+CancellableTask::yieldSlice(void)
+{
+  this->yielding = true;
+}
+
 void
 CancellableTask::onWorkRequested(void)
 {
+  QElapsedTimer timer;
+  bool more;
+
+  timer.start();
+  this->yielding = false;
+
   try {
-    if (this->work())
+    do
+      more = this->work();
+    while (more
+           && !this->yielding
+           && timer.elapsed() < SUSCAN_CANCELLABLE_TASK_BUDGET_MS);
+
+    if (more)
       emit progress(prog, status);
   } catch (Suscan::Exception &e) {
     emit error(QString::fromStdString(e.what()));
@@ -17,6 +17,7 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include "CarrierDetector.h"
+#include <FFTWPlanCache.h>
 #include <sigutils/taps.h>
 
 using namespace SigDigger;
@@ -39,9 +40,7 @@ CarrierDetector::CarrierDetector(
 
 CarrierDetector::~CarrierDetector()
 {
-  if (this->plan != nullptr)
-    SU_FFTW(_destroy_plan)(this->plan);
-
+  // Plans belong to FFTWPlanCache
   if (this->buffer != nullptr)
     SU_FFTW(_free)(this->buffer);
 }
@@ -64,12 +63,11 @@ CarrierDetector::work(void)
         return false;
       }
 
-      if ((this->plan = SU_FFTW(_plan_dft_1d)(
-             this->allocation,
-             this->buffer,
-             this->buffer,
+      if ((this->plan = FFTWPlanCache::instance()->get(
+             static_cast<int>(this->allocation),
              FFTW_FORWARD,
-             FFTW_ESTIMATE)) == nullptr) {
+             this->buffer,
+             this->buffer)) == nullptr) {
         emit error("Failed to initialize FFT plan.");
         return false;
       }
@@ -91,7 +89,7 @@ CarrierDetector::work(void)
       break;
 
     case EXECUTING:
-      SU_FFTW(_execute)(this->plan);
+      SU_FFTW(_execute_dft)(this->plan, this->buffer, this->buffer);
       this->transitionTo(COMPUTING);
       break;
 
@@ -18,6 +18,9 @@
 //
 
 #include <CarrierXlator.h>
+#include <algorithm>
+#include <sigutils/sampling.h>
+#include <cmath>
 
 using namespace SigDigger;
 
@@ -33,8 +36,8 @@ CarrierXlator::CarrierXlator(
   this->destination = destination;
   this->length      = length;
 
-  su_ncqo_init(&this->ncqo, -relFreq);
-  su_ncqo_set_phase(&this->ncqo, -phase);
+  this->relFreq     = relFreq;
+  this->phase       = phase;
 
   this->setProgress(0);
 
@@ -48,16 +51,30 @@ CarrierXlator::~CarrierXlator()
 bool
 CarrierXlator::work(void)
 {
-  size_t amount = this->length - this->p;
-  size_t p = this->p;
-
-  if (amount > SIGDIGGER_CARRIER_XLATOR_BLOCK_LENGTH)
-    amount = SIGDIGGER_CARRIER_XLATOR_BLOCK_LENGTH;
-
-  while (amount--) {
-    this->destination[p] = this->origin[p] * su_ncqo_read(&this->ncqo);
-    ++p;
-  }
+  size_t p = this->p + std::min(this->length - this->p, this->executor.span());
+  const SUCOMPLEX *origin = this->origin;
+  SUCOMPLEX *destination = this->destination;
+  SUFLOAT relFreq = this->relFreq;
+  qreal omega = SU_NORM2ANG_FREQ(static_cast<qreal>(relFreq));
+  qreal phase = this->phase;
+
+  // Each chunk starts its own oscillator at the phase it would have
+  // reached by then. In place is fine: every sample only needs itself.
+  this->executor.run(
+        this->p,
+        p,
+        [&](size_t, size_t first, size_t last) {
+    qreal phi = phase + omega * static_cast<qreal>(first);
+    su_ncqo_t ncqo;
+
+    su_ncqo_init(&ncqo, -relFreq);
+    su_ncqo_set_phase(
+          &ncqo,
+          -static_cast<SUFLOAT>(std::remainder(phi, 2 * M_PI)));
+
+    for (size_t i = first; i < last; ++i)
+      destination[i] = origin[i] * su_ncqo_read(&ncqo);
+  });
 
   this->p = p;
 
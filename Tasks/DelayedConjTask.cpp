@@ -18,8 +18,7 @@
 //
 #include <DelayedConjTask.h>
 #include <Suscan/Library.h>
-
-#define SIGDIGGER_DELAYEDCONJ_BLOCK_LENGTH 4096
+#include <algorithm>
 
 DelayedConjTask::DelayedConjTask(
     const SUCOMPLEX *data,
@@ -27,7 +26,8 @@ DelayedConjTask::DelayedConjTask(
     size_t length,
     SUSCOUNT delay,
     QObject *parent) :
-  Suscan::CancellableTask(parent)
+  Suscan::CancellableTask(parent),
+  input(data, destination, length, delay)
 {
   this->origin = data;
   this->destination = destination;
@@ -37,8 +37,6 @@ DelayedConjTask::DelayedConjTask(
   if (delay == 0)
     throw Suscan::Exception("Delay is zero samples\n");
 
-  this->delayLine.resize(delay);
-
   this->setProgress(0);
   this->setStatus("Processing...");
 }
@@ -58,30 +56,32 @@ isnan(SUCOMPLEX val)
 bool
 DelayedConjTask::work(void)
 {
-  size_t amount = this->length - this->p;
-  size_t p = this->p;
-  SUCOMPLEX x, prev;
+  size_t p = this->p + std::min(this->length - this->p, this->executor.span());
+  SUCOMPLEX *destination = this->destination;
+  SigDigger::OverlapWindow const &input = this->input;
   SUSCOUNT delay = this->delay;
-  SUFLOAT kinv;
 
-  if (amount > SIGDIGGER_DELAYEDCONJ_BLOCK_LENGTH)
-    amount = SIGDIGGER_DELAYEDCONJ_BLOCK_LENGTH;
-
-  while (amount--) {
-    x = this->origin[p];
-    if (p < delay) {
-      this->destination[p] = 0;
-    } else {
-      prev = this->delayLine[q];
-      kinv = 1. / (SU_C_ABS(prev) + 1e-3);
-      this->destination[p] = kinv * x * SU_C_CONJ(prev);
+  this->input.advance(this->p, p);
+
+  // The delay line of each chunk is the input right before it
+  this->executor.run(
+        this->p,
+        p,
+        [&](size_t, size_t first, size_t last) {
+    SUCOMPLEX x, prev;
+    SUFLOAT kinv;
+
+    for (size_t i = first; i < last; ++i) {
+      x = input[i];
+      if (i < delay) {
+        destination[i] = 0;
+      } else {
+        prev = input[i - delay];
+        kinv = 1. / (SU_C_ABS(prev) + 1e-3);
+        destination[i] = kinv * x * SU_C_CONJ(prev);
+      }
     }
-
-    this->delayLine[q++] = x;
-    if (q == delay)
-      q = 0;
-    ++p;
-  }
+  });
 
   this->p = p;
   this->setStatus("Processing ("
@@ -17,6 +17,7 @@
 //    <http://www.gnu.org/licenses/>
 //
 #include "DopplerCalculator.h"
+#include <FFTWPlanCache.h>
 #include <sigutils/taps.h>
 #include <sigutils/sampling.h>
 
@@ -42,9 +43,7 @@ DopplerCalculator::DopplerCalculator(
 
 DopplerCalculator::~DopplerCalculator()
 {
-  if (this->plan != nullptr)
-    SU_FFTW(_destroy_plan)(this->plan);
-
+  // Plans belong to FFTWPlanCache
   if (this->buffer != nullptr)
     SU_FFTW(_free)(this->buffer);
 }
@@ -69,12 +68,11 @@ DopplerCalculator::work(void)
         return false;
       }
 
-      if ((this->plan = SU_FFTW(_plan_dft_1d)(
-             this->allocation,
-             this->buffer,
-             this->buffer,
+      if ((this->plan = FFTWPlanCache::instance()->get(
+             static_cast<int>(this->allocation),
              FFTW_FORWARD,
-             FFTW_ESTIMATE)) == nullptr) {
+             this->buffer,
+             this->buffer)) == nullptr) {
         emit error("Failed to initialize FFT plan.");
         return false;
       }
@@ -96,7 +94,7 @@ DopplerCalculator::work(void)
       break;
 
     case EXECUTING:
-      SU_FFTW(_execute)(this->plan);
+      SU_FFTW(_execute_dft)(this->plan, this->buffer, this->buffer);
       this->transitionTo(COMPUTE);
       break;
 
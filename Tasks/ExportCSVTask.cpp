@@ -19,11 +19,12 @@
 
 #include <ExportCSVTask.h>
 #include <QCoreApplication>
+#include <algorithm>
+#include <sstream>
 
 using namespace SigDigger;
 
 #define SIGDIGGER_EXPORT_CSV_BREATHE_INTERVAL_MS 100
-#define SIGDIGGER_EXPORT_CSV_BREATHE_BLOCK_SIZE  0x10000
 
 void
 ExportCSVTask::breathe(quint64 i)
@@ -52,21 +53,39 @@ ExportCSVTask::exportToCSV()
   m_of << "\n";
 
 
-  for (SUSCOUNT i = 0; !m_cancelFlag && i < m_size; ++i) {
-    c = 0;
+  // Rows are formatted in parallel, chunk by chunk, and written in order
+  for (SUSCOUNT i = 0; !m_cancelFlag && i < m_size; ) {
+    SUSCOUNT next = i + std::min<SUSCOUNT>(m_size - i, m_executor.span());
+    std::vector<std::string> text(m_executor.chunks(i, next));
 
-    for (auto &p : m_columns) {
-      if (c++ > 0)
-        m_of << ",";
+    m_executor.run(
+          i,
+          next,
+          [&](size_t chunk, size_t first, size_t last) {
+      std::ostringstream os;
+      unsigned int col;
 
-      m_of
-         << SU_C_REAL(p.second[i]) << "+"
-         << SU_C_IMAG(p.second[i]) << "i";
-    }
+      for (size_t j = first; j < last; ++j) {
+        col = 0;
 
+        for (auto &p : m_columns) {
+          if (col++ > 0)
+            os << ",";
 
-    if (i % SIGDIGGER_EXPORT_CSV_BREATHE_BLOCK_SIZE == 0)
-      breathe(i);
+          os
+             << SU_C_REAL(p.second[j]) << "+"
+             << SU_C_IMAG(p.second[j]) << "i";
+        }
+      }
+
+      text[chunk] = os.str();
+    });
+
+    for (auto const &chunk : text)
+      m_of << chunk;
+
+    breathe(i);
+    i = next;
   }
 
   m_of << "];\n";
@@ -18,6 +18,8 @@
 //
 #include <ExportSamplesTask.h>
 #include <QCoreApplication>
+#include <algorithm>
+#include <sstream>
 
 using namespace SigDigger;
 
@@ -54,13 +56,33 @@ ExportSamplesTask::exportToMatlab(void)
   of << std::setprecision(std::numeric_limits<float>::digits10);
 
 
-  for (size_t i = 0; !this->cancelFlag && i < size; ++i) {
-    of
-       << SU_C_REAL(this->data[i]) << " + "
-       << SU_C_IMAG(this->data[i]) << "i, ";
+  // Text formatting is the slow part: chunks are formatted in parallel
+  // and written in order.
+  for (size_t i = 0; !this->cancelFlag && i < size; ) {
+    size_t p = i + std::min(size - i, this->executor.span());
+    std::vector<std::string> text(this->executor.chunks(i, p));
 
-    if (i % SIGDIGGER_EXPORT_SAMPLES_BREATHE_BLOCK_SIZE == 0)
-      this->breathe(i);
+    this->executor.run(
+          i,
+          p,
+          [&](size_t chunk, size_t first, size_t last) {
+      std::ostringstream os;
+
+      os << std::setprecision(std::numeric_limits<float>::digits10);
+
+      for (size_t j = first; j < last; ++j)
+        os
+           << SU_C_REAL(this->data[j]) << " + "
+           << SU_C_IMAG(this->data[j]) << "i, ";
+
+      text[chunk] = os.str();
+    });
+
+    for (auto const &chunk : text)
+      of << chunk;
+
+    this->breathe(i);
+    i = p;
   }
 
   of << "];\n";
@@ -18,13 +18,21 @@
 //
 
 #include <HistogramFeeder.h>
+#include <algorithm>
 
 using namespace SigDigger;
 
+static bool registered;
+
 HistogramFeeder::HistogramFeeder(
     SamplingProperties const &props,
     QObject *parent) : CancellableTask(parent)
 {
+  if (!registered) {
+    qRegisterMetaType<QVector<float>>();
+    registered = true;
+  }
+
   this->properties = props;
 }
 
@@ -35,36 +43,48 @@ HistogramFeeder::~HistogramFeeder()
 bool
 HistogramFeeder::work(void)
 {
-  size_t amount = this->properties.length - this->p;
-  size_t p = this->p;
-  unsigned int q = 0;
-
-  if (amount > SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH)
-    amount = SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH;
-
-  switch (this->properties.space) {
-    case AMPLITUDE:
-      while (amount--)
-        this->block[q++] = SU_C_ABS(this->properties.data[p++]);
-      break;
-
-    case PHASE:
-      while (amount--)
-        this->block[q++] = SU_C_ARG(this->properties.data[p++]);
-      break;
-
-    case FREQUENCY:
-      while (amount--) {
-        if (p > 0)
-          this->block[q++] = SU_C_ARG(
-              this->properties.data[p]
-              * SU_C_CONJ(this->properties.data[p - 1]));
-        ++p;
-      }
-
-      break;
-  }
-
+  size_t p = this->p + std::min(
+        this->properties.length - this->p,
+        this->executor.span());
+  const SUCOMPLEX *samples = this->properties.data;
+  SamplingSpace space = this->properties.space;
+  size_t base = this->p;
+  QVector<float> block;
+  float *buffer;
+
+  // There is no frequency for the very first sample
+  if (space == FREQUENCY && base == 0)
+    base = 1;
+
+  if (p > base)
+    block.resize(static_cast<int>(p - base));
+
+  buffer = block.data();
+
+  // Blocks are sent by value: the slot runs later, in the GUI thread
+  this->executor.run(
+        base,
+        p,
+        [&](size_t, size_t first, size_t last) {
+    float *out = buffer + (first - base);
+
+    switch (space) {
+      case AMPLITUDE:
+        for (size_t i = first; i < last; ++i)
+          *out++ = SU_C_ABS(samples[i]);
+        break;
+
+      case PHASE:
+        for (size_t i = first; i < last; ++i)
+          *out++ = SU_C_ARG(samples[i]);
+        break;
+
+      case FREQUENCY:
+        for (size_t i = first; i < last; ++i)
+          *out++ = SU_C_ARG(samples[i] * SU_C_CONJ(samples[i - 1]));
+        break;
+    }
+  });
 
   this->p = p;
 
@@ -77,7 +97,12 @@ HistogramFeeder::work(void)
   this->setProgress(
         static_cast<qreal>(p) / static_cast<qreal>(this->properties.length));
 
-  emit data(this->block, q);
+  // One block in flight at a time. The GUI gets it before the progress
+  // report that brings us back here, so it never falls behind.
+  if (!block.isEmpty()) {
+    emit data(block);
+    this->yieldSlice();
+  }
 
   if (this->p < this->properties.length)
     return true;
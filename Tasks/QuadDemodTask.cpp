@@ -18,15 +18,15 @@
 //
 #include <QuadDemodTask.h>
 #include <Suscan/Library.h>
-
-#define SIGDIGGER_CYCLO_BLOCK_LENGTH 4096
+#include <algorithm>
 
 QuadDemodTask::QuadDemodTask(
     const SUCOMPLEX *data,
     SUCOMPLEX *destination,
     size_t length,
     QObject *parent) :
-  Suscan::CancellableTask(parent)
+  Suscan::CancellableTask(parent),
+  input(data, destination, length, 1)
 {
   this->origin = data;
   this->destination = destination;
@@ -39,25 +39,29 @@ QuadDemodTask::QuadDemodTask(
 bool
 QuadDemodTask::work(void)
 {
-  size_t amount = this->length - this->p;
-  size_t p = this->p;
+  size_t p = this->p + std::min(this->length - this->p, this->executor.span());
+  SUCOMPLEX *destination = this->destination;
+  SigDigger::OverlapWindow const &input = this->input;
   SUFLOAT k = 1. / PI;
-  SUCOMPLEX x;
 
-  if (amount > SIGDIGGER_CYCLO_BLOCK_LENGTH)
-    amount = SIGDIGGER_CYCLO_BLOCK_LENGTH;
+  this->input.advance(this->p, p);
 
-  while (amount--) {
-    x = this->origin[p];
-    if (p < 1) {
-      this->destination[p] = 0;
-    } else {
-      this->destination[p] = SU_I * k * SU_C_ARG(x * SU_C_CONJ(this->prev));
-    }
+  this->executor.run(
+        this->p,
+        p,
+        [&](size_t, size_t first, size_t last) {
+    SUCOMPLEX x, prev = first > 0 ? input[first - 1] : 0;
 
-    this->prev = x;
-    ++p;
-  }
+    for (size_t i = first; i < last; ++i) {
+      x = input[i];
+      if (i < 1)
+        destination[i] = 0;
+      else
+        destination[i] = SU_I * k * SU_C_ARG(x * SU_C_CONJ(prev));
+
+      prev = x;
+    }
+  });
 
   this->p = p;
   this->setStatus("Processing ("
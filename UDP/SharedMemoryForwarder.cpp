@@ -0,0 +1,346 @@
+//
+//    SharedMemoryForwarder.cpp: Export samples through a shared memory ring
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#include <SharedMemoryForwarder.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <unistd.h>
+#  define SIGDIGGER_HAVE_POSIX_SHM
+#endif // _WIN32
+
+using namespace SigDigger;
+
+static_assert(
+    sizeof(SharedMemoryRingHeader) <= SIGDIGGER_SHM_RING_HEADER_SIZE,
+    "Shared memory ring header does not fit in its page");
+
+static_assert(
+    std::atomic<uint64_t>::is_always_lock_free,
+    "Shared memory ring needs lock-free 64-bit atomics");
+
+namespace SigDigger {
+  class SharedMemoryDataWriter : public GenericDataWriter {
+    SharedMemoryForwarderParams params;
+    std::string lastError;
+    int fd = -1;
+    void *map = nullptr;
+    size_t mapSize = 0;
+    bool prepared = false;
+    dev_t segDev = 0;
+    ino_t segIno = 0;
+
+    SharedMemoryRingHeader *header = nullptr;
+    uint8_t *data = nullptr;
+    uint64_t capacity = 0;
+    uint64_t index = 0;
+
+    bool isStale(void) const;
+    bool ownsName(void) const;
+
+  public:
+    SharedMemoryDataWriter(SharedMemoryForwarderParams const &params);
+
+    bool prepare(void) override;
+    std::string getError(void) const override;
+    bool canWrite(void) const override;
+    ssize_t write(const void *data, size_t len) override;
+    bool close(void) override;
+    ~SharedMemoryDataWriter() override;
+  };
+}
+
+SharedMemoryDataWriter::SharedMemoryDataWriter(
+    SharedMemoryForwarderParams const &params) :
+  params(params)
+{
+  // POSIX wants shared memory names to start with a slash
+  if (this->params.name.empty() || this->params.name[0] != '/')
+    this->params.name = "/" + this->params.name;
+}
+
+#ifdef SIGDIGGER_HAVE_POSIX_SHM
+//
+// A segment under our name is stale if it is one of our rings and the
+// process that created it is gone (crashed before it could unlink it).
+// Anything else, including a ring being set up right now, is left alone.
+//
+bool
+SharedMemoryDataWriter::isStale(void) const
+{
+  struct stat sbuf;
+  bool stale = false;
+  void *map;
+  int fd;
+
+  if ((fd = shm_open(this->params.name.c_str(), O_RDONLY, 0)) == -1)
+    return errno == ENOENT;
+
+  if (fstat(fd, &sbuf) == 0
+      && sbuf.st_size >= SIGDIGGER_SHM_RING_HEADER_SIZE) {
+    map = mmap(
+          nullptr,
+          SIGDIGGER_SHM_RING_HEADER_SIZE,
+          PROT_READ,
+          MAP_SHARED,
+          fd,
+          0);
+
+    if (map != MAP_FAILED) {
+      auto header = static_cast<const SharedMemoryRingHeader *>(map);
+      pid_t pid   = static_cast<pid_t>(header->writerPid);
+
+      if (header->magic == SIGDIGGER_SHM_RING_MAGIC) {
+        if (!(header->flags.load(std::memory_order_acquire)
+              & SIGDIGGER_SHM_RING_FLAG_ACTIVE))
+          stale = true;
+        else if (pid > 0 && kill(pid, 0) == -1 && errno == ESRCH)
+          stale = true;
+      }
+
+      munmap(map, SIGDIGGER_SHM_RING_HEADER_SIZE);
+    }
+  }
+
+  ::close(fd);
+
+  return stale;
+}
+
+// True if our name still refers to the segment we created
+bool
+SharedMemoryDataWriter::ownsName(void) const
+{
+  struct stat sbuf;
+  bool owns = false;
+  int fd;
+
+  if ((fd = shm_open(this->params.name.c_str(), O_RDONLY, 0)) == -1)
+    return false;
+
+  if (fstat(fd, &sbuf) == 0)
+    owns = sbuf.st_dev == this->segDev && sbuf.st_ino == this->segIno;
+
+  ::close(fd);
+
+  return owns;
+}
+#endif // SIGDIGGER_HAVE_POSIX_SHM
+
+bool
+SharedMemoryDataWriter::prepare(void)
+{
+#ifdef SIGDIGGER_HAVE_POSIX_SHM
+  if (!this->prepared) {
+    uint64_t capacity = 1;
+    struct stat sbuf;
+
+    // Power of two capacity, so that wrapping is a mask and sample
+    // boundaries never straddle the end of the ring.
+    while (capacity < this->params.capacity)
+      capacity <<= 1;
+
+    if (capacity < this->params.sampleSize) {
+      this->lastError = "Shared memory ring is too small";
+      return false;
+    }
+
+    this->fd = shm_open(
+          this->params.name.c_str(),
+          O_RDWR | O_CREAT | O_EXCL,
+          0644);
+
+    // Replace stale segments left behind by a crashed session. Readers
+    // still attached to them keep their (inactive) mapping. Live ones
+    // belong to someone else.
+    if (this->fd == -1 && errno == EEXIST) {
+      if (!this->isStale()) {
+        this->lastError =
+            "Shared memory segment " + this->params.name
+            + " is in use by another process";
+        return false;
+      }
+
+      shm_unlink(this->params.name.c_str());
+      this->fd = shm_open(
+            this->params.name.c_str(),
+            O_RDWR | O_CREAT | O_EXCL,
+            0644);
+    }
+
+    if (this->fd == -1) {
+      this->lastError =
+          "Cannot create shared memory segment " + this->params.name
+          + ": " + strerror(errno);
+      return false;
+    }
+
+    if (fstat(this->fd, &sbuf) == 0) {
+      this->segDev = sbuf.st_dev;
+      this->segIno = sbuf.st_ino;
+    }
+
+    this->mapSize = SIGDIGGER_SHM_RING_HEADER_SIZE + capacity;
+
+    if (ftruncate(this->fd, static_cast<off_t>(this->mapSize)) == -1) {
+      this->lastError =
+          "Cannot allocate shared memory ring: "
+          + std::string(strerror(errno));
+      this->close();
+      return false;
+    }
+
+    this->map = mmap(
+          nullptr,
+          this->mapSize,
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED,
+          this->fd,
+          0);
+
+    if (this->map == MAP_FAILED) {
+      this->map = nullptr;
+      this->lastError =
+          "Cannot map shared memory ring: " + std::string(strerror(errno));
+      this->close();
+      return false;
+    }
+
+    this->capacity = capacity;
+    this->data     = static_cast<uint8_t *>(this->map)
+        + SIGDIGGER_SHM_RING_HEADER_SIZE;
+    this->header   = new (this->map) SharedMemoryRingHeader();
+
+    this->header->format     = this->params.format;
+    this->header->sampleSize = this->params.sampleSize;
+    this->header->sampleRate = this->params.sampleRate;
+    this->header->capacity   = capacity;
+    this->header->writerPid  = static_cast<uint32_t>(getpid());
+    this->header->bitsPerSymbol = this->params.bitsPerSymbol;
+    this->header->reserveIndex.store(0, std::memory_order_relaxed);
+    this->header->writeIndex.store(0, std::memory_order_relaxed);
+    this->header->flags.store(
+          SIGDIGGER_SHM_RING_FLAG_ACTIVE,
+          std::memory_order_release);
+
+    this->prepared = true;
+  }
+
+  return this->prepared;
+#else
+  this->lastError = "Shared memory export is not supported in this platform";
+  return false;
+#endif // SIGDIGGER_HAVE_POSIX_SHM
+}
+
+std::string
+SharedMemoryDataWriter::getError(void) const
+{
+  return this->lastError;
+}
+
+bool
+SharedMemoryDataWriter::canWrite(void) const
+{
+  return !this->prepared || this->header != nullptr;
+}
+
+ssize_t
+SharedMemoryDataWriter::write(const void *data, size_t len)
+{
+  const uint8_t *as_bytes = static_cast<const uint8_t *>(data);
+  uint64_t mask = this->capacity - 1;
+  uint64_t offset;
+  size_t chunk;
+
+  if (this->header == nullptr)
+    return 0;
+
+  // Never overwrite more than half the ring in one go, so readers that
+  // keep up always have something consistent to read.
+  if (len > this->capacity / 2)
+    len = this->capacity / 2;
+
+  this->header->reserveIndex.store(
+        this->index + len,
+        std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  offset = this->index & mask;
+  chunk  = std::min<size_t>(len, this->capacity - offset);
+
+  memcpy(this->data + offset, as_bytes, chunk);
+  if (chunk < len)
+    memcpy(this->data, as_bytes + chunk, len - chunk);
+
+  this->index += len;
+  this->header->writeIndex.store(this->index, std::memory_order_release);
+
+  return static_cast<ssize_t>(len);
+}
+
+bool
+SharedMemoryDataWriter::close(void)
+{
+#ifdef SIGDIGGER_HAVE_POSIX_SHM
+  if (this->header != nullptr) {
+    this->header->flags.store(0, std::memory_order_release);
+    this->header->~SharedMemoryRingHeader();
+    this->header = nullptr;
+  }
+
+  if (this->map != nullptr) {
+    munmap(this->map, this->mapSize);
+    this->map = nullptr;
+  }
+
+  // Only unlink the name if it still refers to our segment. Another
+  // writer may have replaced it after deciding ours was stale.
+  if (this->fd != -1) {
+    if (this->ownsName())
+      shm_unlink(this->params.name.c_str());
+    ::close(this->fd);
+    this->fd = -1;
+  }
+#endif // SIGDIGGER_HAVE_POSIX_SHM
+
+  return true;
+}
+
+SharedMemoryDataWriter::~SharedMemoryDataWriter(void)
+{
+  this->close();
+}
+
+SharedMemoryForwarder::SharedMemoryForwarder(
+    SharedMemoryForwarderParams const &params,
+    QObject *parent) :
+  GenericDataSaver(
+    new SharedMemoryDataWriter(params),
+    parent)
+{
+
+}
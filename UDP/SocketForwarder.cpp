@@ -19,36 +19,98 @@
 
 #include <SocketForwarder.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <sigutils/util/compat-socket.h>
 #include <sigutils/util/compat-in.h>
 #include <sigutils/util/compat-netdb.h>
+#include <sigutils/util/compat-time.h>
+#include <sigutils/log.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#  include <sys/uio.h>
+#  define SIGDIGGER_HAVE_SENDMMSG
+#endif // __linux__
 
 #ifndef MSG_NOSIGNAL
 #  define MSG_NOSIGNAL 0
 #endif // MSG_NOSIGNAL
 
+// IP + UDP headers
+#define SIGDIGGER_UDPFORWARDER_IP_OVERHEAD   28
+#define SIGDIGGER_UDPFORWARDER_IPV6_OVERHEAD 48
+
 using namespace SigDigger;
 
 namespace SigDigger {
+  typedef std::shared_ptr<std::vector<uint8_t>> SocketFrame;
+
+  struct SocketClient {
+    int fd = -1;
+    std::string name;
+    std::deque<SocketFrame> queue;
+    size_t queued = 0; // Bytes in queue, minus those already sent
+    size_t offset = 0; // Bytes of queue.front() already sent
+    uint64_t dropped = 0;
+  };
+
   class SocketDataWriter : public GenericDataWriter {
-    std::string host;
-    uint16_t port;
-    char pad[2];
-    struct sockaddr_in addr;
+    SocketForwarderParams params;
+    struct sockaddr_storage addr;
+    socklen_t addrLen = 0;
     int fd = -1;
     bool solved = false;
-    bool tcp = false;
-    char pad2[2];
-    unsigned int size = 0;
+    unsigned int payloadSize = 0;
     std::string lastError;
 
+    // Framing state
+    uint32_t sequence = 0;
+    uint64_t bytesSent = 0;
+    std::vector<SocketForwarderHeader> headers;
+
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+    std::vector<struct mmsghdr> msgs;
+    std::vector<struct iovec> iovs;
+#else
+    std::vector<uint8_t> scratch;
+#endif // SIGDIGGER_HAVE_SENDMMSG
+
+    // Listen mode. Clients are shared with the service thread.
+    std::list<SocketClient> clients;
+    std::mutex clientMutex;
+    std::thread service;
+    int wakeFds[2] = {-1, -1};
+    bool stopping = false;
+
+    bool openSocket(void);
+    void fillHeader(SocketForwarderHeader &, size_t, uint64_t);
+    unsigned int queryPathMtu(void) const;
+    ssize_t writeUdp(const uint8_t *data, size_t len);
+    ssize_t writeTcp(const uint8_t *data, size_t len);
+    ssize_t writeClients(const uint8_t *data, size_t len);
+
+    void acceptClients(void);
+    bool enqueueFrame(SocketClient &, SocketFrame const &);
+    bool flushClient(SocketClient &);
+    void dropClient(SocketClient &, const char *reason);
+
+    bool startService(void);
+    void stopService(void);
+    void wakeService(void);
+    void serviceLoop(void);
+
   public:
-    SocketDataWriter(
-        std::string const &host,
-        uint16_t port,
-        unsigned int size,
-        bool tcp);
+    SocketDataWriter(SocketForwarderParams const &params);
 
     bool prepare(void) override;
     std::string getError(void) const override;
@@ -59,49 +121,256 @@ namespace SigDigger {
   };
 }
 
-SocketDataWriter::SocketDataWriter(
-    std::string const &host,
-    uint16_t port,
-    unsigned int size,
-    bool tcp) :
-  host(host), port(port), tcp(tcp), size(size)
+static inline uint64_t
+toNet64(uint64_t val)
+{
+  return
+      (static_cast<uint64_t>(htonl(static_cast<uint32_t>(val))) << 32)
+      | htonl(static_cast<uint32_t>(val >> 32));
+}
+
+static inline uint64_t
+timestampUsec(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, nullptr);
+
+  return static_cast<uint64_t>(tv.tv_sec) * 1000000ull
+      + static_cast<uint64_t>(tv.tv_usec);
+}
+
+static bool
+setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL);
+
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+static std::string
+addressToString(const struct sockaddr *addr, socklen_t len)
+{
+  char host[NI_MAXHOST];
+  char serv[NI_MAXSERV];
+
+  if (getnameinfo(
+        addr,
+        len,
+        host,
+        sizeof(host),
+        serv,
+        sizeof(serv),
+        NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+    return "unknown";
+
+  if (addr->sa_family == AF_INET6)
+    return "[" + std::string(host) + "]:" + serv;
+
+  return std::string(host) + ":" + serv;
+}
+
+SocketDataWriter::SocketDataWriter(SocketForwarderParams const &params) :
+  params(params)
+{
+  this->headers.resize(SIGDIGGER_UDPFORWARDER_MAX_BATCH);
+
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+  this->msgs.resize(SIGDIGGER_UDPFORWARDER_MAX_BATCH);
+  this->iovs.resize(2 * SIGDIGGER_UDPFORWARDER_MAX_BATCH);
+#endif // SIGDIGGER_HAVE_SENDMMSG
+}
+
+unsigned int
+SocketDataWriter::queryPathMtu(void) const
 {
-  this->pad[0] = this->pad2[0] = 0; // Shut up
+  unsigned int mtu = 0;
+
+#if defined(__linux__) && defined(IP_MTU) && defined(IPV6_MTU)
+  int probe;
+  int value = 0;
+  int family = this->addr.ss_family;
+  socklen_t len = sizeof(int);
+  bool ok;
+
+  // IP_MTU is only available in connected sockets. We do not want to
+  // connect the forwarding socket itself, as that would turn ICMP port
+  // unreachable messages into send errors.
+  if ((probe = socket(family, SOCK_DGRAM, 0)) != -1) {
+    ok = connect(
+          probe,
+          reinterpret_cast<const struct sockaddr *>(&this->addr),
+          this->addrLen) == 0;
+
+    if (ok) {
+      if (family == AF_INET6)
+        ok = getsockopt(probe, IPPROTO_IPV6, IPV6_MTU, &value, &len) == 0;
+      else
+        ok = getsockopt(probe, IPPROTO_IP, IP_MTU, &value, &len) == 0;
+    }
+
+    if (ok && value > SIGDIGGER_UDPFORWARDER_IPV6_OVERHEAD)
+      mtu = static_cast<unsigned int>(value);
+
+    ::close(probe);
+  }
+#endif // defined(__linux__) && defined(IP_MTU) && defined(IPV6_MTU)
+
+  return mtu;
+}
+
+bool
+SocketDataWriter::openSocket(void)
+{
+  struct addrinfo hints;
+  struct addrinfo *list = nullptr;
+  std::vector<struct addrinfo *> candidates;
+  std::string port = std::to_string(this->params.port);
+  const char *host = nullptr;
+  int result;
+  int one = 1;
+
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = this->params.tcp ? SOCK_STREAM : SOCK_DGRAM;
+
+  if (this->params.listen)
+    hints.ai_flags = AI_PASSIVE;
+
+  if (!this->params.host.empty())
+    host = this->params.host.c_str();
+
+  if ((result = getaddrinfo(host, port.c_str(), &hints, &list)) != 0) {
+    this->lastError =
+        "Failed to resolve hostname " + this->params.host + ": "
+        + gai_strerror(result);
+    return false;
+  }
+
+  // Prefer IPv6 wildcard sockets when listening on any address: with
+  // IPV6_V6ONLY disabled they accept IPv4 clients too.
+  for (struct addrinfo *ai = list; ai != nullptr; ai = ai->ai_next)
+    candidates.push_back(ai);
+
+  if (this->params.listen && host == nullptr)
+    std::stable_partition(
+          candidates.begin(),
+          candidates.end(),
+          [] (const struct addrinfo *p) { return p->ai_family == AF_INET6; });
+
+  this->lastError = "No usable address for " + this->params.host;
+
+  for (auto ai : candidates) {
+    if ((this->fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol))
+        == -1) {
+      this->lastError =
+          "Failed to open socket: " + std::string(strerror(errno));
+      continue;
+    }
+
+    if (this->params.listen) {
+      int zero = 0;
+
+      setsockopt(
+            this->fd,
+            SOL_SOCKET,
+            SO_REUSEADDR,
+            reinterpret_cast<const char *>(&one),
+            sizeof(int));
+
+      if (ai->ai_family == AF_INET6)
+        setsockopt(
+              this->fd,
+              IPPROTO_IPV6,
+              IPV6_V6ONLY,
+              reinterpret_cast<const char *>(&zero),
+              sizeof(int));
+
+      if (bind(this->fd, ai->ai_addr, ai->ai_addrlen) == -1
+          || ::listen(this->fd, SIGDIGGER_UDPFORWARDER_MAX_CLIENTS) == -1
+          || !setNonBlocking(this->fd)) {
+        this->lastError =
+            "Cannot listen on " + addressToString(ai->ai_addr, ai->ai_addrlen)
+            + ": " + std::string(strerror(errno));
+        ::close(this->fd);
+        this->fd = -1;
+        continue;
+      }
+    } else if (this->params.tcp) {
+      if (connect(this->fd, ai->ai_addr, ai->ai_addrlen) == -1) {
+        this->lastError =
+            "Cannot connect to host: " + std::string(strerror(errno));
+        ::close(this->fd);
+        this->fd = -1;
+        continue;
+      }
+    }
+
+    memcpy(&this->addr, ai->ai_addr, ai->ai_addrlen);
+    this->addrLen = static_cast<socklen_t>(ai->ai_addrlen);
+    break;
+  }
+
+  freeaddrinfo(list);
+
+  return this->fd != -1;
 }
 
 bool
 SocketDataWriter::prepare(void)
 {
   if (!this->solved) {
-    struct hostent *ent;
+    unsigned int frameLen = this->params.frameLen;
+    unsigned int headerLen =
+        this->params.header ? sizeof(SocketForwarderHeader) : 0;
 
-    if ((ent = gethostbyname(this->host.c_str())) == nullptr) {
-      this->lastError = "Failed to resolve hostname " + this->host;
+    if (!this->openSocket())
       return false;
+
+    if (!this->params.tcp) {
+      unsigned int mtu = this->queryPathMtu();
+      unsigned int overhead = this->addr.ss_family == AF_INET6
+          ? SIGDIGGER_UDPFORWARDER_IPV6_OVERHEAD
+          : SIGDIGGER_UDPFORWARDER_IP_OVERHEAD;
+
+      if (frameLen > SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE)
+        frameLen = SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE;
+
+      if (mtu > overhead && frameLen > mtu - overhead) {
+        frameLen = mtu - overhead;
+        SU_WARNING(
+              "UDP frame size reduced to %d bytes to fit path MTU\n",
+              frameLen);
+      }
     }
 
-    if ((this->fd = socket(
-           AF_INET,
-           this->tcp ? SOCK_STREAM : SOCK_DGRAM,
-           0)) == -1) {
-      this->lastError = "Failed to open socket: " + std::string(strerror(errno));
+    // Never split a sample across frames: receivers would have to
+    // reassemble them, and a single lost datagram would misalign the rest
+    // of the stream.
+    if (frameLen > headerLen)
+      this->payloadSize = frameLen - headerLen;
+    else
+      this->payloadSize = 0;
+
+    if (this->params.sampleSize > 1)
+      this->payloadSize -= this->payloadSize % this->params.sampleSize;
+
+    if (this->payloadSize == 0) {
+      this->lastError = "Frame size is too small";
       return false;
     }
 
-    this->addr.sin_family = AF_INET;
-    this->addr.sin_port = htons(this->port);
-    this->addr.sin_addr = *reinterpret_cast<struct in_addr *>(ent->h_addr);
-    memset(this->addr.sin_zero, 0, 8);
-
-    if (this->tcp) {
-      if (connect(
-            this->fd,
-            reinterpret_cast<struct sockaddr *>(&this->addr),
-            sizeof(struct sockaddr_in)) == -1) {
-        this->lastError = "Cannot connect to host: " + std::string(strerror(errno));
+    if (this->params.listen) {
+      if (!this->startService())
         return false;
-      }
+
+      SU_INFO(
+            "Forwarder listening on %s\n",
+            addressToString(
+              reinterpret_cast<const struct sockaddr *>(&this->addr),
+              this->addrLen).c_str());
     }
+
     this->solved = true;
   }
 
@@ -120,21 +389,197 @@ SocketDataWriter::canWrite(void) const
   return !this->solved || this->fd != -1;
 }
 
+void
+SocketDataWriter::fillHeader(
+    SocketForwarderHeader &header,
+    size_t payload,
+    uint64_t timestamp)
+{
+  uint64_t sampleIndex = this->bytesSent;
+
+  if (this->params.sampleSize > 1)
+    sampleIndex /= this->params.sampleSize;
+
+  header.magic       = htons(SIGDIGGER_UDPFORWARDER_HEADER_MAGIC);
+  header.version     = SIGDIGGER_UDPFORWARDER_HEADER_VERSION;
+  header.sampleSize  = static_cast<uint8_t>(this->params.sampleSize);
+  header.sequence    = htonl(this->sequence++);
+  header.payloadSize = htonl(static_cast<uint32_t>(payload));
+  header.bitsPerSymbol = static_cast<uint8_t>(this->params.bitsPerSymbol);
+  memset(header.reserved, 0, sizeof(header.reserved));
+  header.sampleIndex = toNet64(sampleIndex);
+  header.timestamp   = toNet64(timestamp);
+
+  this->bytesSent += payload;
+}
+
 ssize_t
-SocketDataWriter::write(const void *data, size_t len)
+SocketDataWriter::writeUdp(const uint8_t *data, size_t len)
 {
-  ssize_t sent;
+  bool withHeader = this->params.header;
+  size_t count = (len + this->payloadSize - 1) / this->payloadSize;
+  size_t sent = 0;
+  uint64_t timestamp = timestampUsec();
+
+  if (count > SIGDIGGER_UDPFORWARDER_MAX_BATCH)
+    count = SIGDIGGER_UDPFORWARDER_MAX_BATCH;
+
+#ifdef SIGDIGGER_HAVE_SENDMMSG
+  int result;
+
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = i * this->payloadSize;
+    size_t chunk = std::min<size_t>(this->payloadSize, len - offset);
+    struct iovec *iov = &this->iovs[2 * i];
+    struct msghdr *hdr = &this->msgs[i].msg_hdr;
+
+    memset(hdr, 0, sizeof(struct msghdr));
+
+    if (withHeader) {
+      this->fillHeader(this->headers[i], chunk, timestamp);
+      iov->iov_base = &this->headers[i];
+      iov->iov_len  = sizeof(SocketForwarderHeader);
+      ++iov;
+    }
+
+    iov->iov_base = const_cast<uint8_t *>(data + offset);
+    iov->iov_len  = chunk;
+
+    hdr->msg_name    = &this->addr;
+    hdr->msg_namelen = this->addrLen;
+    hdr->msg_iov     = &this->iovs[2 * i];
+    hdr->msg_iovlen  = withHeader ? 2 : 1;
+  }
 
-  if (len > this->size)
-    len = this->size;
+  result = sendmmsg(
+        this->fd,
+        this->msgs.data(),
+        static_cast<unsigned int>(count),
+        MSG_NOSIGNAL);
 
-  sent = sendto(
+  if (result < 1) {
+    this->lastError = std::string(strerror(errno));
+    return -1;
+  }
+
+  for (int i = 0; i < result; ++i)
+    sent += this->iovs[2 * i + (withHeader ? 1 : 0)].iov_len;
+
+  // Partial batch: rewind framing state of the unsent datagrams
+  if (withHeader && static_cast<size_t>(result) < count) {
+    size_t batchLen = std::min<size_t>(len, count * this->payloadSize);
+
+    this->sequence  -= static_cast<uint32_t>(count - static_cast<size_t>(result));
+    this->bytesSent -= batchLen - sent;
+  }
+#else
+  for (size_t i = 0; i < count; ++i) {
+    size_t offset = i * this->payloadSize;
+    size_t chunk = std::min<size_t>(this->payloadSize, len - offset);
+    const uint8_t *frame = data + offset;
+    size_t frameLen = chunk;
+    ssize_t result;
+
+    if (withHeader) {
+      this->scratch.resize(sizeof(SocketForwarderHeader) + chunk);
+      this->fillHeader(this->headers[0], chunk, timestamp);
+      memcpy(
+            this->scratch.data(),
+            &this->headers[0],
+            sizeof(SocketForwarderHeader));
+      memcpy(
+            this->scratch.data() + sizeof(SocketForwarderHeader),
+            frame,
+            chunk);
+      frame    = this->scratch.data();
+      frameLen = this->scratch.size();
+    }
+
+    result = sendto(
           this->fd,
-          reinterpret_cast<const char *>(data),
-          len,
+          reinterpret_cast<const char *>(frame),
+          frameLen,
           MSG_NOSIGNAL,
           reinterpret_cast<struct sockaddr *>(&this->addr),
-          sizeof(struct sockaddr_in));
+          this->addrLen);
+
+    if (result < 1) {
+      if (withHeader) {
+        --this->sequence;
+        this->bytesSent -= chunk;
+      }
+
+      if (sent > 0)
+        break;
+
+      this->lastError = std::string(strerror(errno));
+      return -1;
+    }
+
+    sent += chunk;
+  }
+#endif // SIGDIGGER_HAVE_SENDMMSG
+
+  return static_cast<ssize_t>(sent);
+}
+
+ssize_t
+SocketDataWriter::writeTcp(const uint8_t *data, size_t len)
+{
+  ssize_t sent;
+
+  if (len > this->payloadSize)
+    len = this->payloadSize;
+
+  if (this->params.header) {
+    SocketForwarderHeader *header = &this->headers[0];
+    const uint8_t *as_bytes = reinterpret_cast<const uint8_t *>(header);
+    size_t remaining = sizeof(SocketForwarderHeader);
+
+    this->fillHeader(*header, len, timestampUsec());
+
+    // Header and payload must not be interleaved with partial writes
+    while (remaining > 0) {
+      sent = send(
+            this->fd,
+            reinterpret_cast<const char *>(as_bytes),
+            remaining,
+            MSG_NOSIGNAL);
+
+      if (sent < 1) {
+        this->lastError = std::string(strerror(errno));
+        return -1;
+      }
+
+      as_bytes  += sent;
+      remaining -= static_cast<size_t>(sent);
+    }
+
+    remaining = len;
+    while (remaining > 0) {
+      sent = send(
+            this->fd,
+            reinterpret_cast<const char *>(data),
+            remaining,
+            MSG_NOSIGNAL);
+
+      if (sent < 1) {
+        this->lastError = std::string(strerror(errno));
+        return -1;
+      }
+
+      data      += sent;
+      remaining -= static_cast<size_t>(sent);
+    }
+
+    return static_cast<ssize_t>(len);
+  }
+
+  sent = send(
+        this->fd,
+        reinterpret_cast<const char *>(data),
+        len,
+        MSG_NOSIGNAL);
 
   if (sent < 1)
     this->lastError = std::string(strerror(errno));
@@ -142,13 +587,326 @@ SocketDataWriter::write(const void *data, size_t len)
   return sent;
 }
 
+void
+SocketDataWriter::dropClient(SocketClient &client, const char *reason)
+{
+  if (client.fd != -1) {
+    SU_INFO(
+          "Forwarder client %s disconnected (%s)\n",
+          client.name.c_str(),
+          reason);
+    ::close(client.fd);
+    client.fd = -1;
+  }
+
+  client.queue.clear();
+  client.queued = 0;
+  client.offset = 0;
+}
+
+void
+SocketDataWriter::acceptClients(void)
+{
+  struct sockaddr_storage peer;
+  socklen_t peerLen;
+  int cfd;
+
+  for (;;) {
+    peerLen = sizeof(struct sockaddr_storage);
+    cfd = accept(
+          this->fd,
+          reinterpret_cast<struct sockaddr *>(&peer),
+          &peerLen);
+
+    if (cfd == -1)
+      break;
+
+    if (this->clients.size() >= SIGDIGGER_UDPFORWARDER_MAX_CLIENTS
+        || !setNonBlocking(cfd)) {
+      ::close(cfd);
+      continue;
+    }
+
+    this->clients.push_back(SocketClient());
+    this->clients.back().fd   = cfd;
+    this->clients.back().name = addressToString(
+          reinterpret_cast<struct sockaddr *>(&peer),
+          peerLen);
+
+    SU_INFO(
+          "Forwarder client %s connected\n",
+          this->clients.back().name.c_str());
+  }
+}
+
+bool
+SocketDataWriter::enqueueFrame(SocketClient &client, SocketFrame const &frame)
+{
+  if (client.queued + frame->size() > this->params.clientQueueSize) {
+    if (this->params.policy == SLOW_CLIENT_POLICY_DISCONNECT) {
+      this->dropClient(client, "too slow");
+      return false;
+    }
+
+    ++client.dropped;
+    return true;
+  }
+
+  client.queue.push_back(frame);
+  client.queued += frame->size();
+
+  return true;
+}
+
+bool
+SocketDataWriter::flushClient(SocketClient &client)
+{
+  ssize_t sent;
+
+  while (!client.queue.empty()) {
+    SocketFrame &front = client.queue.front();
+    size_t remaining = front->size() - client.offset;
+
+    sent = send(
+          client.fd,
+          reinterpret_cast<const char *>(front->data() + client.offset),
+          remaining,
+          MSG_NOSIGNAL | MSG_DONTWAIT);
+
+    if (sent < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return true;
+
+      this->dropClient(client, strerror(errno));
+      return false;
+    }
+
+    client.queued -= static_cast<size_t>(sent);
+
+    if (static_cast<size_t>(sent) < remaining) {
+      client.offset += static_cast<size_t>(sent);
+      return true;
+    }
+
+    client.offset = 0;
+    client.queue.pop_front();
+  }
+
+  return true;
+}
+
+ssize_t
+SocketDataWriter::writeClients(const uint8_t *data, size_t len)
+{
+  bool withHeader = this->params.header;
+  size_t headerLen = withHeader ? sizeof(SocketForwarderHeader) : 0;
+  size_t maxChunk = this->payloadSize;
+  uint64_t timestamp = timestampUsec();
+  size_t offset = 0;
+  std::vector<SocketFrame> frames;
+
+  // Without headers there are no frame boundaries to honour, but frames
+  // are still bounded: dropping one must not throw away a whole commit.
+  if (!withHeader) {
+    maxChunk = SIGDIGGER_UDPFORWARDER_CLIENT_FRAME_SIZE;
+    if (this->params.sampleSize > 1)
+      maxChunk -= maxChunk % this->params.sampleSize;
+    if (maxChunk == 0)
+      maxChunk = this->params.sampleSize;
+  }
+
+  // Frames are built once and shared by all client queues
+  while (offset < len) {
+    size_t chunk = std::min(maxChunk, len - offset);
+    SocketFrame frame = std::make_shared<std::vector<uint8_t>>(
+          headerLen + chunk);
+
+    if (withHeader) {
+      SocketForwarderHeader header;
+      this->fillHeader(header, chunk, timestamp);
+      memcpy(frame->data(), &header, headerLen);
+    }
+
+    memcpy(frame->data() + headerLen, data + offset, chunk);
+    frames.push_back(frame);
+
+    offset += chunk;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->clientMutex);
+
+    for (auto &client : this->clients)
+      for (auto &frame : frames)
+        if (client.fd != -1 && !this->enqueueFrame(client, frame))
+          break;
+  }
+
+  this->wakeService();
+
+  // A listening forwarder never blocks the saver: slow clients are
+  // handled by their own queues.
+  return static_cast<ssize_t>(len);
+}
+
+bool
+SocketDataWriter::startService(void)
+{
+  if (pipe(this->wakeFds) == -1
+      || !setNonBlocking(this->wakeFds[0])
+      || !setNonBlocking(this->wakeFds[1])) {
+    this->lastError =
+        "Cannot create wake pipe: " + std::string(strerror(errno));
+    return false;
+  }
+
+  this->stopping = false;
+  this->service = std::thread(&SocketDataWriter::serviceLoop, this);
+
+  return true;
+}
+
+void
+SocketDataWriter::wakeService(void)
+{
+  char byte = 0;
+  ssize_t ignored;
+
+  // If the pipe is full, a wakeup is pending anyway
+  if (this->wakeFds[1] != -1) {
+    ignored = ::write(this->wakeFds[1], &byte, 1);
+    (void) ignored;
+  }
+}
+
+void
+SocketDataWriter::stopService(void)
+{
+  if (this->service.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(this->clientMutex);
+      this->stopping = true;
+    }
+
+    this->wakeService();
+    this->service.join();
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    if (this->wakeFds[i] != -1) {
+      ::close(this->wakeFds[i]);
+      this->wakeFds[i] = -1;
+    }
+  }
+}
+
+void
+SocketDataWriter::serviceLoop(void)
+{
+  std::vector<struct pollfd> fds;
+  std::vector<SocketClient *> polled;
+  char drain[64];
+
+  for (;;) {
+    fds.clear();
+    polled.clear();
+
+    fds.push_back({this->wakeFds[0], POLLIN, 0});
+    fds.push_back({this->fd, POLLIN, 0});
+
+    {
+      std::lock_guard<std::mutex> lock(this->clientMutex);
+
+      if (this->stopping)
+        break;
+
+      for (auto &client : this->clients) {
+        short events = client.queue.empty() ? POLLIN : POLLIN | POLLOUT;
+        fds.push_back({client.fd, events, 0});
+        polled.push_back(&client);
+      }
+    }
+
+    if (poll(
+          fds.data(),
+          static_cast<nfds_t>(fds.size()),
+          SIGDIGGER_UDPFORWARDER_SERVICE_INTERVAL_MS) == -1
+        && errno != EINTR)
+      break;
+
+    if (fds[0].revents & POLLIN)
+      while (::read(this->wakeFds[0], drain, sizeof(drain)) > 0);
+
+    std::lock_guard<std::mutex> lock(this->clientMutex);
+
+    if (this->stopping)
+      break;
+
+    // Clients are only removed here, so the pointers are still valid
+    for (size_t i = 0; i < polled.size(); ++i) {
+      SocketClient &client = *polled[i];
+      short revents = fds[i + 2].revents;
+
+      if (client.fd == -1)
+        continue;
+
+      if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        this->dropClient(client, "connection lost");
+        continue;
+      }
+
+      // Clients are not expected to talk. This is how we see them leave.
+      if ((revents & POLLIN)
+          && recv(client.fd, drain, sizeof(drain), MSG_DONTWAIT) == 0) {
+        this->dropClient(client, "closed by peer");
+        continue;
+      }
+
+      if (!client.queue.empty())
+        this->flushClient(client);
+    }
+
+    this->clients.remove_if(
+          [] (SocketClient const &client) { return client.fd == -1; });
+
+    if (fds[1].revents & POLLIN)
+      this->acceptClients();
+  }
+}
+
+ssize_t
+SocketDataWriter::write(const void *data, size_t len)
+{
+  const uint8_t *as_bytes = static_cast<const uint8_t *>(data);
+
+  if (this->fd == -1)
+    return 0;
+
+  if (this->params.listen)
+    return this->writeClients(as_bytes, len);
+
+  if (this->params.tcp)
+    return this->writeTcp(as_bytes, len);
+
+  return this->writeUdp(as_bytes, len);
+}
+
 bool
 SocketDataWriter::close(void)
 {
   bool ok = true;
 
+  this->stopService();
+
+  for (auto &client : this->clients)
+    this->dropClient(client, "forwarding stopped");
+  this->clients.clear();
+
   if (this->fd != -1) {
-    ok = ::shutdown(this->fd, 2) == 0;
+    if (this->params.listen)
+      ok = ::close(this->fd) == 0;
+    else
+      ok = ::shutdown(this->fd, 2) == 0;
     this->fd = -1;
   }
 
@@ -161,13 +919,10 @@ SocketDataWriter::~SocketDataWriter(void)
 }
 
 SocketForwarder::SocketForwarder(
-    std::string const &host,
-    uint16_t port,
-    unsigned int size,
-    bool tcp,
+    SocketForwarderParams const &params,
     QObject *parent) :
   GenericDataSaver(
-    this->writer = new SocketDataWriter(host, port, size, tcp),
+    new SocketDataWriter(params),
     parent)
 {
 
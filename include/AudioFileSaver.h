@@ -28,8 +28,6 @@ namespace SigDigger {
   class AudioFileSaver : public GenericDataSaver {
     Q_OBJECT
 
-    AudioFileWriter *writer = nullptr;
-
   public:
     struct AudioFileParams {
       std::string savePath;
@@ -41,7 +39,6 @@ namespace SigDigger {
     AudioFileParams params;
 
     AudioFileSaver(AudioFileParams const &, QObject *);
-    ~AudioFileSaver();
   };
 }
 
@@ -20,12 +20,11 @@
 #define CARRIERXLATOR_H
 
 #include <Suscan/CancellableTask.h>
+#include <ChunkedExecutor.h>
 
 #include <sigutils/types.h>
 #include <sigutils/ncqo.h>
 
-#define SIGDIGGER_CARRIER_XLATOR_BLOCK_LENGTH 4096
-
 namespace SigDigger {
   class CarrierXlator : public Suscan::CancellableTask {
     Q_OBJECT
@@ -36,7 +35,10 @@ namespace SigDigger {
     size_t length;
     size_t p = 0;
 
-    su_ncqo_t ncqo;
+    SUFLOAT relFreq;
+    SUFLOAT phase;
+
+    ChunkedExecutor executor;
 
   public:
     CarrierXlator(
@@ -0,0 +1,96 @@
+//
+//    ChunkedExecutor.h: Run stateless sample transforms in parallel
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+#ifndef CHUNKEDEXECUTOR_H
+#define CHUNKEDEXECUTOR_H
+
+#include <QThreadPool>
+#include <functional>
+#include <vector>
+#include <sigutils/types.h>
+
+#define SIGDIGGER_CHUNKED_EXECUTOR_CHUNK_SIZE 0x10000
+
+namespace SigDigger {
+  //
+  // Splits a sample range in fixed-size chunks and runs a kernel on each
+  // of them from a thread pool. Idle threads keep taking the next pending
+  // chunk, so uneven chunks do not leave cores waiting.
+  //
+  // Chunk boundaries depend only on the range and the chunk size, never
+  // on the number of threads, so results are the same on any machine.
+  // Kernels must only depend on their input: anything they need from
+  // before the chunk start (the previous sample, a delay line) is read
+  // from the input again, through an OverlapWindow if the transform
+  // runs in place.
+  //
+  class ChunkedExecutor {
+    QThreadPool m_pool;
+    size_t m_chunkSize;
+
+  public:
+    // Kernel(chunk index, first sample, one past the last sample)
+    typedef std::function<void (size_t, size_t, size_t)> Kernel;
+
+    ChunkedExecutor(size_t chunkSize = SIGDIGGER_CHUNKED_EXECUTOR_CHUNK_SIZE);
+
+    // Samples worth handing in one run() call to keep all threads busy
+    size_t span(void) const;
+    size_t chunks(size_t from, size_t to) const;
+
+    // Blocks until every chunk of [from, to) is done
+    void run(size_t from, size_t to, Kernel const &kernel);
+  };
+
+  //
+  // Keeps the input of a transform readable while its output is written
+  // over it. Ranges must be consecutive. Sample k can be read for
+  // k in [from - overlap, to) of the last advance() call.
+  //
+  class OverlapWindow {
+    const SUCOMPLEX *m_input;
+    std::vector<SUCOMPLEX> m_span;    // Copy of [m_from, m_to)
+    std::vector<SUCOMPLEX> m_history; // Sample k lives at k % overlap
+    size_t m_from = 0;
+    size_t m_to = 0;
+    bool m_copy;
+
+  public:
+    OverlapWindow(
+        const SUCOMPLEX *input,
+        const SUCOMPLEX *output,
+        size_t length,
+        size_t overlap);
+
+    void advance(size_t from, size_t to);
+
+    inline SUCOMPLEX
+    operator[](size_t k) const
+    {
+      if (!m_copy)
+        return m_input[k];
+
+      if (k >= m_from)
+        return m_span[k - m_from];
+
+      return m_history[k % m_history.size()];
+    }
+  };
+}
+
+#endif // CHUNKEDEXECUTOR_H
@@ -0,0 +1,46 @@
+//
+//    CompressedFileDataSaver.h: save baseband data as compressed cs16
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef COMPRESSEDFILEDATASAVER_H
+#define COMPRESSEDFILEDATASAVER_H
+
+#include "GenericDataSaver.h"
+#include "IQCodec.h"
+
+namespace SigDigger {
+  class CompressedFileDataWriter;
+
+  //
+  // Same as FileDataSaver, but expects SUCOMPLEX samples only. These are
+  // quantized to cs16 (scaled to the peak of each block) and stored in
+  // independent, losslessly compressed blocks (see IQCodec.h). Blocks are
+  // encoded by a pool of worker threads.
+  //
+  class CompressedFileDataSaver : public GenericDataSaver {
+    Q_OBJECT
+
+  public:
+    CompressedFileDataSaver(
+        int fd,
+        unsigned int sampleRate,
+        QObject *parent = nullptr);
+  };
+}
+
+#endif // COMPRESSEDFILEDATASAVER_H
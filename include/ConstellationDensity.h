@@ -0,0 +1,78 @@
+//
+//    ConstellationDensity.h: Decaying 2D histogram of the constellation
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef CONSTELLATIONDENSITY_H
+#define CONSTELLATIONDENSITY_H
+
+#include <QImage>
+#include <QColor>
+#include <vector>
+#include <sigutils/types.h>
+
+// Grid side, in cells
+#define CONSTELLATION_DENSITY_DEFAULT_SIZE    128
+
+// Half the side of the plotted square, in signal units
+#define CONSTELLATION_DENSITY_DEFAULT_EXTENT  1.5f
+
+// Samples after which the weight of a point has dropped to 1/e
+#define CONSTELLATION_DENSITY_DEFAULT_WINDOW  65536
+
+namespace SigDigger {
+  //
+  // Accumulates samples in a fixed grid instead of keeping them, so the
+  // cost of drawing does not depend on the sample rate. Old samples fade
+  // out exponentially. Rather than decaying every cell on every sample,
+  // each new sample is added with a weight that grows at the inverse
+  // rate, and the grid is rescaled only when that weight gets too large.
+  //
+  class ConstellationDensity
+  {
+      unsigned int size = CONSTELLATION_DENSITY_DEFAULT_SIZE;
+      float extent = CONSTELLATION_DENSITY_DEFAULT_EXTENT;
+      float growth = 1.f;   // Per-sample weight increase (1 / decay)
+      float weight = 1.f;   // Weight of the next sample
+      std::vector<float> grid;
+      QRgb palette[256];
+
+      void renormalize(void);
+
+    public:
+      ConstellationDensity();
+
+      void setSize(unsigned int);
+      void setExtent(float);
+      void setWindow(unsigned int samples);
+      void setPalette(const QColor *gradient);
+
+      void feed(const SUCOMPLEX *data, size_t size);
+      void reset(void);
+
+      // Densities are compressed logarithmically, relative to the peak
+      void render(QImage &dest) const;
+
+      unsigned int
+      getSize(void) const
+      {
+        return this->size;
+      }
+  };
+}
+
+#endif // CONSTELLATIONDENSITY_H
@@ -30,6 +30,7 @@ namespace SigDigger {
   class DataSaverConfig : public Suscan::Serializable {
   public:
     std::string path;
+    bool compress = false;
 
     // Overriden methods
     void deserialize(Suscan::Object const &conf) override;
@@ -52,10 +53,13 @@ namespace SigDigger {
       void setCaptureSize(quint64) override;
       void setIORate(qreal) override;
       void setRecordState(bool state) override;
+      void setMetrics(GenericDataSaverMetrics const &) override;
+      void setCompressionAvailable(bool);
 
       // Getters
       bool getRecordState(void) const override;
       std::string getRecordSavePath(void) const override;
+      bool getCompress(void) const;
 
       // Other overriden methods
       Suscan::Serializable *allocConfig(void) override;
@@ -67,6 +71,7 @@ namespace SigDigger {
   public slots:
       void onChangeSavePath(void);
       void onRecordStartStop(void);
+      void onToggleCompress(void);
 
   private:
       Ui::DataSaverUI *ui;
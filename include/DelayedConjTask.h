@@ -20,6 +20,7 @@
 #define DELAYEDCONJTASK_H
 
 #include <Suscan/CancellableTask.h>
+#include <ChunkedExecutor.h>
 #include <sigutils/types.h>
 
 class DelayedConjTask : public Suscan::CancellableTask
@@ -29,8 +30,8 @@ class DelayedConjTask : public Suscan::CancellableTask
   const SUCOMPLEX *origin = nullptr;
   SUCOMPLEX       *destination = nullptr;
 
-  std::vector<SUCOMPLEX> delayLine;
-  SUSCOUNT q = 0;
+  SigDigger::ChunkedExecutor executor;
+  SigDigger::OverlapWindow input;
 
   size_t length;
   size_t p = 0;
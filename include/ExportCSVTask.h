@@ -25,6 +25,7 @@
 #include <iomanip>
 #include <fstream>
 #include "SigDiggerHelpers.h"
+#include "ChunkedExecutor.h"
 
 namespace SigDigger {
   class ExportCSVTask : public Suscan::CancellableTask
@@ -40,6 +41,7 @@ namespace SigDigger {
 
       QString m_lastError;
       bool m_cancelFlag = false;
+      ChunkedExecutor m_executor;
 
       void breathe(quint64);
       bool openCSV();
@@ -27,6 +27,7 @@
 #include <sndfile.h>
 
 #include "SigDiggerHelpers.h"
+#include "ChunkedExecutor.h"
 
 namespace SigDigger {
   class ExportSamplesTask : public Suscan::CancellableTask
@@ -46,6 +47,7 @@ namespace SigDigger {
       int end;
 
       QString lastError;
+      ChunkedExecutor executor;
 
       bool openMat5(void);
       bool openMatlab(void);
@@ -0,0 +1,156 @@
+//
+//    FFTWPlanCache.h: Application-wide cache of FFTW plans
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef FFTWPLANCACHE_H
+#define FFTWPLANCACHE_H
+
+#include <QObject>
+#include <QMutex>
+#include <QAtomicInteger>
+#include <list>
+#include <map>
+#include <sigutils/types.h>
+
+class QThread;
+
+// Sizes above this are planned with FFTW_ESTIMATE only
+#define SIGDIGGER_FFTW_CACHE_MAX_MEASURE_SIZE (1 << 20)
+
+// Upper bound for a single background measurement, in seconds
+#define SIGDIGGER_FFTW_CACHE_MEASURE_TIMELIMIT 2.0
+
+namespace SigDigger {
+  struct FFTWPlanKey {
+    int  size;
+    int  direction;
+    bool inPlace;
+    int  inAlignment;
+    int  outAlignment;
+
+    inline bool
+    operator<(FFTWPlanKey const &other) const
+    {
+      if (this->size != other.size)
+        return this->size < other.size;
+      if (this->direction != other.direction)
+        return this->direction < other.direction;
+      if (this->inPlace != other.inPlace)
+        return this->inPlace < other.inPlace;
+      if (this->inAlignment != other.inAlignment)
+        return this->inAlignment < other.inAlignment;
+      return this->outAlignment < other.outAlignment;
+    }
+  };
+
+  class FFTWPlanCache;
+
+  class FFTWPlanMeasurer : public QObject {
+    Q_OBJECT
+
+    FFTWPlanCache *m_cache;
+
+  public:
+    explicit FFTWPlanMeasurer(FFTWPlanCache *cache);
+
+  public slots:
+    void measure(void);
+  };
+
+  //
+  // One-dimensional complex plans shared by the whole application. Plans
+  // are handed out immediately (from wisdom if possible, FFTW_ESTIMATE
+  // otherwise) and measured in a background thread, which then replaces
+  // the cached plan. Wisdom lives in the suscan config directory, so plans
+  // measured in a previous session are available right away.
+  //
+  // Wisdom is saved by finish(), which must run once nothing else in the
+  // process is planning (i.e. after the analyzer is gone).
+  //
+  // Returned plans belong to the cache and stay valid until the process
+  // exits. They must be run with SU_FFTW(_execute_dft), which accepts any
+  // pair of buffers with the same size, placement and alignment as the
+  // ones passed to get(). Call get() again every now and then (e.g. once
+  // per block) to pick up measured plans.
+  //
+  class FFTWPlanCache : public QObject {
+    Q_OBJECT
+
+    struct Entry {
+      SU_FFTW(_plan) plan = nullptr;
+      bool measured = false;
+    };
+
+    // FFTW planner is not reentrant, and sigutils and suscan plan from
+    // their own threads too. The constructor makes the planner lock itself
+    // (fftwf_make_planner_thread_safe), which covers every caller in the
+    // process. This mutex only keeps our timelimit changes and wisdom
+    // import/export (which the planner lock does not cover) together.
+    QMutex m_plannerMutex;
+
+    // Cache state. Never held while planning, so lookups do not wait for
+    // background measurements.
+    QMutex m_mapMutex;
+    std::map<FFTWPlanKey, Entry> m_plans;
+    std::list<SU_FFTW(_plan)> m_retired;
+    std::list<FFTWPlanKey> m_measureQueue;
+    bool m_measureScheduled = false;
+
+    QThread *m_thread = nullptr;
+    FFTWPlanMeasurer *m_measurer = nullptr;
+    QAtomicInteger<int> m_stopping;
+
+    QString m_wisdomPath;
+    unsigned int m_rigor;
+    bool m_wisdomChanged = false;
+
+    FFTWPlanCache();
+
+    void loadWisdom(void);
+    bool measureNext(void);
+
+    friend class FFTWPlanMeasurer;
+
+  public:
+    static FFTWPlanCache *instance();
+
+    SU_FFTW(_plan) get(
+        int size,
+        int direction,
+        SU_FFTW(_complex) *in,
+        SU_FFTW(_complex) *out);
+
+    SU_FFTW(_plan)
+    get(int size, int direction, SUCOMPLEX *in, SUCOMPLEX *out)
+    {
+      return this->get(
+            size,
+            direction,
+            reinterpret_cast<SU_FFTW(_complex) *>(in),
+            reinterpret_cast<SU_FFTW(_complex) *>(out));
+    }
+
+    void saveWisdom(void);
+    void finish(void);
+
+  signals:
+    void measureRequested(void);
+  };
+}
+
+#endif // FFTWPLANCACHE_H
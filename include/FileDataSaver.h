@@ -28,11 +28,8 @@ namespace SigDigger {
   class FileDataSaver : public GenericDataSaver {
     Q_OBJECT
 
-    FileDataWriter *writer = nullptr;
-
   public:
     FileDataSaver(int fd, QObject *parent = nullptr);
-    ~FileDataSaver();
   };
 }
 #endif // ASYNCDATASAVER_H
@@ -32,6 +32,69 @@
 namespace SigDigger {
   class GenericDataSaver;
 
+  enum GenericDataType {
+    GENERIC_DATA_TYPE_RAW,  // Untyped bytes, written as they come
+    GENERIC_DATA_TYPE_U8,
+    GENERIC_DATA_TYPE_S16,
+    GENERIC_DATA_TYPE_F32,
+    GENERIC_DATA_TYPE_CF32
+  };
+
+  enum GenericDataConversion {
+    GENERIC_DATA_CONVERSION_NONE,
+    GENERIC_DATA_CONVERSION_MODULUS,  // CF32 -> F32, |x|
+    GENERIC_DATA_CONVERSION_ARGUMENT, // CF32 -> F32, arg(ix) / pi
+    GENERIC_DATA_CONVERSION_REAL,     // CF32 -> F32
+    GENERIC_DATA_CONVERSION_IMAG,     // CF32 -> F32
+    GENERIC_DATA_CONVERSION_TO_S16    // F32  -> S16, full scale at +/-1
+  };
+
+  //
+  // What the producer writes and what reaches the writer. Conversion and
+  // decimation (a boxcar average of every `decimation' samples, F32 and
+  // CF32 only) run in the worker thread, right before the write.
+  //
+  struct GenericDataFormat {
+    GenericDataType       input      = GENERIC_DATA_TYPE_RAW;
+    GenericDataConversion conversion = GENERIC_DATA_CONVERSION_NONE;
+    unsigned int          decimation = 1;
+
+    GenericDataType outputType(void) const;
+    bool isValid(void) const;
+
+    inline bool
+    isIdentity(void) const
+    {
+      return this->conversion == GENERIC_DATA_CONVERSION_NONE
+          && this->decimation <= 1;
+    }
+
+    static size_t typeSize(GenericDataType);
+    static const char *typeName(GenericDataType);
+  };
+
+  //
+  // Worker-side conversion state. Decimation carries partial averages
+  // across commits.
+  //
+  class GenericDataConverter {
+    GenericDataFormat format;
+    SUCOMPLEX acc = 0;
+    unsigned int count = 0;
+
+    std::vector<SUFLOAT>   floats;
+    std::vector<SUCOMPLEX> complexes;
+    std::vector<int16_t>   shorts;
+
+    template<typename T> size_t decimate(T *data, size_t len);
+
+  public:
+    void setFormat(GenericDataFormat const &);
+
+    // Returns the converted data, valid until the next call
+    const uint8_t *convert(const uint8_t *data, size_t bytes, size_t &outBytes);
+  };
+
   // Remember: C++ templates are just a convoluted way to define C macros,
   // and unsurprisingly they are full of shortcomings. In particular, C++
   // forbids virtual template functions because it does not know how to
@@ -56,12 +119,33 @@ namespace SigDigger {
   };
 #undef TEMPLATE_FOR_WRITE_NO_MATTER_WHAT
 
+  //
+  // Saver health figures. Latencies and times are in microseconds, fill
+  // levels are fractions of the producer buffer. Commits are requested at
+  // half fill, so a peak fill well above 0.5 means the writer is lagging
+  // behind the producer.
+  //
+  struct GenericDataSaverMetrics {
+    qreal   bytesPerSecond   = 0; // Producer data rate, last commit
+    qreal   peakFill         = 0; // Since the saver was created
+    quint64 commitLatency    = 0; // Commit request to data written, last
+    quint64 maxCommitLatency = 0;
+    quint64 convertTime      = 0; // Format conversion, last commit
+    quint64 writeTime        = 0; // Time spent in the writer, last commit
+    quint64 maxWriteCall     = 0; // Longest single writer call
+    quint64 drops            = 0; // Writes rejected because of a full buffer
+    quint64 droppedBytes     = 0;
+
+    QString toString(void) const;
+  };
+
   class GenericDataWorker : public QObject {
       Q_OBJECT
 
       bool failed = false;
       bool writerPrepared = false;
       GenericDataSaver *instance;
+      GenericDataConverter converter;
 
     private slots:
       void onCommit(void);
@@ -72,7 +156,7 @@ namespace SigDigger {
 
     signals:
       void prepared(void);
-      void writeFinished(quint64 usec);
+      void writeFinished(quint64 usec, quint64 convertUsec, quint64 latency);
       void error(QString);
   };
 
@@ -85,6 +169,8 @@ namespace SigDigger {
 
       unsigned int rateHint = 0;
       size_t allocation;
+      GenericDataFormat format;
+      bool typeMismatch = false;
 
       unsigned int buffer = 0;
       unsigned int commitedSize;
@@ -98,14 +184,43 @@ namespace SigDigger {
       QMutex dataMutex;
 
       struct timeval lastCommit;
+      struct timeval commitRequest;
       quint64 commitTime = 0;
       quint64 writeTime = 0;
       quint64 size = 0;
 
+      // Metrics. Protected by metricsMutex, as they are updated from the
+      // producer, the worker and the owner threads.
+      mutable QMutex metricsMutex;
+      GenericDataSaverMetrics metrics;
+      quint64 lastWriteCall = 0;
+      qreal commitRate = 0;
+      bool logMetrics = false;
+
       // Private methods
       void doCommit(void);
+      void reallocate(void);
+
+      static inline GenericDataType
+      typeOf(const SUCOMPLEX *)
+      {
+        return GENERIC_DATA_TYPE_CF32;
+      }
+
+      static inline GenericDataType
+      typeOf(const SUFLOAT *)
+      {
+        return GENERIC_DATA_TYPE_F32;
+      }
+
+      static inline GenericDataType
+      typeOf(const uint8_t *)
+      {
+        return GENERIC_DATA_TYPE_U8;
+      }
 
     public:
+      // Takes ownership of the writer
       explicit GenericDataSaver(
           GenericDataWriter *writer,
           QObject *parent = nullptr);
@@ -114,9 +229,14 @@ namespace SigDigger {
       // Public methods
       void setBufferSize(unsigned int size);
       void setSampleRate(unsigned int i);
+
+      // Only before the first write. Writes of any other type are dropped.
+      bool setFormat(GenericDataFormat const &);
+      GenericDataFormat getFormat(void) const;
       template<typename T> void write(const T *, size_t size);
       QString getLastError(void) const;
       quint64 getSize(void) const;
+      GenericDataSaverMetrics getMetrics(void) const;
 
       // Friend classes
       friend class GenericDataWorker;
@@ -129,11 +249,12 @@ namespace SigDigger {
       void stopped(void);
       void swamped(void);
       void dataRate(qreal);
+      void metricsUpdated(void);
 
     public slots:
       void onPrepared(void);
       void onError(QString);
-      void onWriteFinished(quint64 usec);
+      void onWriteFinished(quint64 usec, quint64 convertUsec, quint64 latency);
   };
 
   extern template void GenericDataSaver::write<SUCOMPLEX>(const SUCOMPLEX *, size_t);
@@ -21,6 +21,7 @@
 #define GENERICDATASAVERUI_H
 
 #include <PersistentWidget.h>
+#include <GenericDataSaver.h>
 
 //
 // TODO: How about doing the same with the network forwarder?
@@ -45,6 +46,7 @@ namespace SigDigger {
     virtual void setCaptureSize(quint64) = 0;
     virtual void setIORate(qreal) = 0;
     virtual void setRecordState(bool state) = 0;
+    virtual void setMetrics(GenericDataSaverMetrics const &) = 0;
 
     // Getters
     virtual bool getRecordState(void) const = 0;
@@ -20,10 +20,10 @@
 #define HISTOGRAMFEEDER_H
 
 #include <Suscan/CancellableTask.h>
+#include <ChunkedExecutor.h>
+#include <QVector>
 #include "SamplingProperties.h"
 
-#define SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH 4096
-
 namespace SigDigger {
   class HistogramFeeder : public Suscan::CancellableTask {
     Q_OBJECT
@@ -31,7 +31,7 @@ namespace SigDigger {
     SamplingProperties properties;
     size_t p = 0;
 
-    SUFLOAT block[SIGDIGGER_HISTOGRAM_FEEDER_BLOCK_LENGTH];
+    ChunkedExecutor executor;
 
   public:
     HistogramFeeder(
@@ -44,7 +44,7 @@ namespace SigDigger {
 
 
   signals:
-    void data(const float *data, unsigned int size);
+    void data(QVector<float>);
   };
 }
 
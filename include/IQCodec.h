@@ -0,0 +1,172 @@
+//
+//    IQCodec.h: Lossless block codec for cs16 baseband recordings
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef IQCODEC_H
+#define IQCODEC_H
+
+#include <sigutils/types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+// File layout (all fields in host byte order, which is little endian in
+// every platform we support):
+//
+//   IQFileHeader
+//   IQBlockHeader + payload    (repeated)
+//   IQIndexEntry[count]        (only if the file was closed cleanly)
+//   IQIndexTrailer
+//
+// Blocks are independent: each one can be decoded without looking at
+// its neighbours, which is what makes the file seekable and what lets
+// us encode them in parallel. If the index is missing (e.g. the program
+// crashed before closing the capture) the reader rebuilds it by walking
+// the block headers.
+//
+// Samples are quantized to cs16 before compression, so captures are NOT
+// lossless with respect to the float32 samples. Each block is scaled to
+// its own peak (stored in its header), which keeps weak signals at full
+// 16-bit resolution and never clips finite samples. Non-finite ones are
+// saturated (NaN as 0) and counted as clipped. Inside a block, each
+// channel (I and Q) picks the fixed polynomial predictor (order 0, 1 or 2)
+// that minimizes its residuals, and residuals are Rice-coded in partitions
+// with their own parameter. Noise-like captures fall back to order 0,
+// which is still much smaller than float32 thanks to the Rice stage.
+//
+
+#define SIGDIGGER_IQCODEC_FILE_MAGIC       0x51494453 // "SDIQ"
+#define SIGDIGGER_IQCODEC_BLOCK_MAGIC      0x4b424453 // "SDBK"
+#define SIGDIGGER_IQCODEC_INDEX_MAGIC      0x58494453 // "SDIX"
+#define SIGDIGGER_IQCODEC_VERSION          2
+#define SIGDIGGER_IQCODEC_BLOCK_LENGTH     65536
+#define SIGDIGGER_IQCODEC_PARTITION_LENGTH 256
+#define SIGDIGGER_IQCODEC_FILE_EXTENSION   "sdiq"
+
+#define SIGDIGGER_IQCODEC_BLOCK_RICE       0
+#define SIGDIGGER_IQCODEC_BLOCK_RAW        1
+
+namespace SigDigger {
+  struct IQFileHeader {
+    uint32_t magic       = SIGDIGGER_IQCODEC_FILE_MAGIC;
+    uint32_t version     = SIGDIGGER_IQCODEC_VERSION;
+    uint32_t sampleRate  = 0;
+    uint32_t blockLength = SIGDIGGER_IQCODEC_BLOCK_LENGTH;
+    float    fullScale   = 1.f; // Unused since version 2, see blocks
+    uint32_t reserved[3] = {0, 0, 0};
+  };
+
+  struct IQBlockHeader {
+    uint32_t magic       = SIGDIGGER_IQCODEC_BLOCK_MAGIC;
+    uint32_t samples     = 0;
+    uint32_t payloadSize = 0;
+    uint32_t encoding    = SIGDIGGER_IQCODEC_BLOCK_RICE;
+    uint64_t firstSample = 0;
+    float    fullScale   = 1.f; // Peak amplitude, maps to 32767
+    uint32_t reserved    = 0;
+  };
+
+  struct IQIndexEntry {
+    uint64_t offset      = 0;
+    uint64_t firstSample = 0;
+  };
+
+  struct IQIndexTrailer {
+    uint64_t count       = 0;
+    uint32_t magic       = SIGDIGGER_IQCODEC_INDEX_MAGIC;
+    uint32_t reserved    = 0;
+  };
+
+  class IQCodec {
+  public:
+    // Appends header + payload of a single block to `output'. Returns
+    // the number of samples that had to be clipped.
+    static size_t encodeBlock(
+        const SUCOMPLEX *samples,
+        size_t count,
+        uint64_t firstSample,
+        std::vector<uint8_t> &output);
+
+    // Decodes a block payload into `count' samples
+    static bool decodeBlock(
+        const uint8_t *payload,
+        size_t size,
+        uint32_t encoding,
+        SUCOMPLEX *samples,
+        size_t count,
+        SUFLOAT fullScale);
+  };
+
+  // Nothing in SigDigger opens these files yet: this is for tools and
+  // for a future playback path.
+  class IQCompressedReader {
+    int fd = -1;
+    std::string lastError;
+    IQFileHeader header;
+    std::vector<IQIndexEntry> index;
+    uint64_t sampleCount = 0;
+
+    // Currently decoded block
+    std::vector<uint8_t>   payload;
+    std::vector<SUCOMPLEX> decoded;
+    size_t currBlock = 0;
+    bool haveBlock = false;
+    uint64_t position = 0;
+
+    bool readAt(void *, size_t, uint64_t);
+    bool loadIndex(uint64_t fileSize);
+    bool rebuildIndex(uint64_t fileSize);
+    bool loadBlock(size_t block);
+    size_t findBlock(uint64_t sample) const;
+
+  public:
+    bool open(std::string const &path);
+    void close(void);
+    bool seek(uint64_t sample);
+    ssize_t read(SUCOMPLEX *samples, size_t count);
+
+    uint64_t
+    getSampleCount(void) const
+    {
+      return this->sampleCount;
+    }
+
+    uint64_t
+    tell(void) const
+    {
+      return this->position;
+    }
+
+    unsigned int
+    getSampleRate(void) const
+    {
+      return this->header.sampleRate;
+    }
+
+    std::string
+    getError(void) const
+    {
+      return this->lastError;
+    }
+
+    ~IQCompressedReader();
+  };
+}
+
+#endif // IQCODEC_H
@@ -22,6 +22,7 @@
 
 #include <QWidget>
 #include <WaitingSpinnerWidget.h>
+#include <SocketForwarder.h>
 
 namespace Ui {
   class UDPForwarderUI;
@@ -50,6 +51,11 @@ namespace SigDigger {
     void setForwardEnabled(bool enabled);
     void setCaptureSize(quint64 size);
     void setTcp(bool);
+    void setListen(bool);
+    void setSharedMemory(bool);
+    void setHeader(bool);
+    void setMetrics(GenericDataSaverMetrics const &);
+    void setSlowClientPolicy(SlowClientPolicy);
 
     // Getters
     std::string getHost(void) const;
@@ -57,9 +63,14 @@ namespace SigDigger {
     unsigned int getFrameLen(void) const;
     bool getForwardState(void) const;
     bool getTcp(void) const;
+    bool getListen(void) const;
+    bool getSharedMemory(void) const;
+    bool getHeader(void) const;
+    SlowClientPolicy getSlowClientPolicy(void) const;
 
   public slots:
     void onForwardStartStop(void);
+    void onSocketTypeChanged(void);
 
   signals:
     void forwardStateChanged(bool state);
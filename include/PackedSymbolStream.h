@@ -0,0 +1,68 @@
+//
+//    PackedSymbolStream.h: Pack symbol decisions into a bit stream
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef PACKEDSYMBOLSTREAM_H
+#define PACKEDSYMBOLSTREAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace SigDigger {
+  //
+  // Turns one-symbol-per-byte decisions into a bit stream of `bps' bits
+  // per symbol. Symbols are written MSB first, and fill each byte from
+  // its MSB too, so for bps = 1 the first symbol is bit 7 of byte 0.
+  // Symbols may straddle bytes when bps does not divide 8. Bits that do
+  // not complete a byte are kept for the next append().
+  //
+  class PackedSymbolStream {
+    unsigned int bps = 1;
+    uint32_t acc = 0;
+    unsigned int accBits = 0;
+    uint64_t symbols = 0;
+    std::vector<uint8_t> bytes;
+
+  public:
+    // Pads the pending bits of the previous size, if any
+    void setBitsPerSymbol(unsigned int);
+    void append(const uint8_t *symbols, size_t len);
+
+    // Completes the last byte with zeroes
+    void flush(void);
+    void clear(void);
+
+    // Moves the complete bytes to dest, whose contents are replaced
+    void take(std::vector<uint8_t> &dest);
+
+    inline unsigned int
+    getBitsPerSymbol(void) const
+    {
+      return this->bps;
+    }
+
+    inline uint64_t
+    getSymbolCount(void) const
+    {
+      return this->symbols;
+    }
+  };
+}
+
+#endif // PACKEDSYMBOLSTREAM_H
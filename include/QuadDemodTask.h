@@ -20,6 +20,7 @@
 #define QUADDEMODTASK_H
 
 #include <Suscan/CancellableTask.h>
+#include <ChunkedExecutor.h>
 #include <sigutils/types.h>
 
 class QuadDemodTask : public Suscan::CancellableTask
@@ -28,7 +29,9 @@ class QuadDemodTask : public Suscan::CancellableTask
 
   const SUCOMPLEX *origin = nullptr;
   SUCOMPLEX       *destination = nullptr;
-  SUCOMPLEX prev = 0;
+
+  SigDigger::ChunkedExecutor executor;
+  SigDigger::OverlapWindow input;
 
   size_t length;
   size_t p = 0;
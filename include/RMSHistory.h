@@ -0,0 +1,152 @@
+//
+//    RMSHistory.h: Bounded multi-resolution history of power measurements
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RMSHISTORY_H
+#define RMSHISTORY_H
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <sigutils/types.h>
+
+// Tier k summarizes RMS_HISTORY_FACTOR^k samples per bucket
+#define RMS_HISTORY_TIERS           6
+#define RMS_HISTORY_FACTOR          8
+
+#define RMS_HISTORY_DEFAULT_MEMORY  (64 << 20) // Bytes
+
+namespace SigDigger {
+  struct RMSHistoryBucket {
+    float min  = 0;
+    float max  = 0;
+    float mean = 0;
+  };
+
+  //
+  // Tier 0 keeps the raw samples (as plain floats), and every other tier
+  // keeps min / max / mean rollups of the one below. All tiers have the
+  // same capacity and
+  // drop their oldest buckets first, so recent data is available at full
+  // resolution and older data at progressively coarser ones, within a
+  // fixed memory budget. Samples are addressed by their index since the
+  // last clear().
+  //
+  class RMSHistory
+  {
+      friend class RMSHistoryTierTask;
+
+      struct Tier {
+        bool raw = false;          // Tier 0: values instead of buckets
+        std::deque<float> values;
+        std::deque<RMSHistoryBucket> buckets;
+        uint64_t first = 0;        // Index of the front element, in buckets
+        RMSHistoryBucket partial;  // Next bucket of the tier above
+        unsigned int partialCount = 0;
+
+        inline size_t
+        size(void) const
+        {
+          return this->raw ? this->values.size() : this->buckets.size();
+        }
+
+        inline RMSHistoryBucket
+        at(size_t i) const
+        {
+          RMSHistoryBucket bucket;
+
+          if (!this->raw)
+            return this->buckets[i];
+
+          bucket.min = bucket.max = bucket.mean = this->values[i];
+          return bucket;
+        }
+
+        inline void
+        push(RMSHistoryBucket const &bucket)
+        {
+          if (this->raw)
+            this->values.push_back(bucket.mean);
+          else
+            this->buckets.push_back(bucket);
+        }
+
+        inline void
+        popFront(void)
+        {
+          if (this->raw)
+            this->values.pop_front();
+          else
+            this->buckets.pop_front();
+          ++this->first;
+        }
+      };
+
+      Tier tiers[RMS_HISTORY_TIERS];
+      size_t capacity = 0;
+      uint64_t count = 0;
+
+      void resetTier(unsigned int tier);
+      void append(unsigned int tier, RMSHistoryBucket const &);
+      void buildTier(
+          unsigned int tier,
+          const float *values,
+          uint64_t count,
+          const RMSHistoryBucket *blocks,
+          uint64_t blockSize);
+      bool query(
+          unsigned int tier,
+          uint64_t from,
+          uint64_t to,
+          RMSHistoryBucket &) const;
+
+    public:
+      RMSHistory(size_t memory = RMS_HISTORY_DEFAULT_MEMORY);
+
+      void setMemoryLimit(size_t bytes);
+      void push(float value);
+      void clear(void);
+
+      // Replaces the contents with `count' samples at once, building all
+      // tiers concurrently. If given, blocks[i] summarizes samples
+      // [i * blockSize, (i + 1) * blockSize), and tiers whose buckets are
+      // made of whole blocks are built from them instead.
+      void load(
+          const float *values,
+          uint64_t count,
+          const RMSHistoryBucket *blocks = nullptr,
+          uint64_t blockSize = 0);
+
+      // Summary of samples [from, to), taken from the finest tier that
+      // still has them. Returns false if nothing is left of that range.
+      bool query(uint64_t from, uint64_t to, RMSHistoryBucket &) const;
+
+      // Means of consecutive groups of `decimation' samples. Only the
+      // complete groups are rendered.
+      void render(std::vector<float> &dest, uint64_t decimation) const;
+
+      inline uint64_t
+      size(void) const
+      {
+        return this->count;
+      }
+  };
+}
+
+#endif // RMSHISTORY_H
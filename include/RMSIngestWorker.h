@@ -0,0 +1,59 @@
+//
+//    RMSIngestWorker.h: Read RMS feeds off the GUI thread
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RMSINGESTWORKER_H
+#define RMSINGESTWORKER_H
+
+#include <QObject>
+#include <QMap>
+
+class QTcpSocket;
+
+namespace SigDigger {
+  class RMSStream;
+
+  //
+  // Owns the sockets of a set of streams and decodes whatever they
+  // receive, in the thread the worker lives in. RMSViewer spreads the
+  // connections over a few of these. Once a stream is offline, the
+  // worker no longer touches it and the GUI may delete it.
+  //
+  class RMSIngestWorker : public QObject
+  {
+    Q_OBJECT
+
+    QMap<QTcpSocket *, RMSStream *> streams;
+
+    QTcpSocket *findSocket(RMSStream *) const;
+    void drop(QTcpSocket *);
+
+  public:
+    explicit RMSIngestWorker(QObject *parent = nullptr);
+    ~RMSIngestWorker() override;
+
+  public slots:
+    // The socket must have no parent and live in this worker's thread
+    void onAdopt(QTcpSocket *, SigDigger::RMSStream *);
+    void onClose(SigDigger::RMSStream *);
+    void onReadyRead(void);
+    void onDisconnected(void);
+  };
+}
+
+#endif // RMSINGESTWORKER_H
@@ -0,0 +1,137 @@
+//
+//    RMSLog.h: Compact binary power logs
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RMSLOG_H
+#define RMSLOG_H
+
+#include <QFile>
+#include <QString>
+#include <QElapsedTimer>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <RMSHistory.h>
+#include <cli/datasaver.h>
+
+//
+// Binary RMS log layout, all little endian:
+//
+//   Header (RMS_LOG_HEADER_SIZE bytes)
+//     char[8]  RMS_LOG_MAGIC
+//     uint32   version
+//     uint32   flags
+//     uint32   measures per block
+//     uint32   reserved
+//     double   measures per second (0 if unknown)
+//
+//   Blocks, one after another:
+//     uint32   measures in this block (only the last one may be short)
+//     float    min, max, mean         (if RMS_LOG_FLAG_SUMMARY)
+//     records  of RMS_LOG_RECORD_SIZE bytes: timestamp (double, seconds
+//              since the epoch) and linear power (float), like the
+//              binary mode of the RMS feed protocol.
+//
+// The block summaries let readers build the coarse decimation tiers
+// without touching the records.
+//
+// Writers sync the block being filled to disk every RMS_LOG_SYNC_INTERVAL
+// seconds, as a short block with its current count. Later syncs rewrite
+// that block in place until it is full, so a killed logger leaves a
+// valid file that is at most RMS_LOG_SYNC_INTERVAL seconds behind.
+//
+#define RMS_LOG_MAGIC          "SDRMSLOG"
+#define RMS_LOG_VERSION        1
+#define RMS_LOG_HEADER_SIZE    32
+#define RMS_LOG_RECORD_SIZE    (sizeof(double) + sizeof(float))
+#define RMS_LOG_FLAG_SUMMARY   1
+#define RMS_LOG_BLOCK_SIZE     4096 // RMS_HISTORY_FACTOR^4
+#define RMS_LOG_EXTENSION      "rmslog"
+#define RMS_LOG_SYNC_INTERVAL  2    // Seconds
+
+namespace SigDigger {
+  class RMSLogFileWriter {
+    FILE *m_fp = nullptr;
+    std::vector<char> m_block;
+    uint32_t m_count = 0;
+    bool m_summary = true;
+    RMSHistoryBucket m_stats;
+    double m_sum = 0;
+
+    long m_blockOffset = 0;  // File offset of the block being filled
+    uint32_t m_synced = 0;   // Records of that block already on disk
+    QElapsedTimer m_lastSync;
+
+    bool flush(void);
+
+  public:
+    RMSLogFileWriter(bool summary = true);
+    ~RMSLogFileWriter();
+
+    bool open(std::string const &path, qreal rate);
+    bool write(qreal timeStamp, float power);
+    bool close(void);
+  };
+
+  class RMSLogReader {
+    struct Block {
+      qint64 offset; // Of the first record
+      uint32_t count;
+    };
+
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_size = 0;
+    QString m_error;
+
+    uint32_t m_flags = 0;
+    uint32_t m_blockSize = 0;
+    qreal m_rate = 0;
+
+    std::vector<Block> m_blocks;
+    std::vector<RMSHistoryBucket> m_summaries;
+    uint64_t m_count = 0;
+
+    qreal timeStampAt(uint64_t) const;
+    bool fail(QString const &);
+
+  public:
+    ~RMSLogReader();
+
+    bool open(QString const &path);
+    void close(void);
+
+    // Records are decoded in parallel, block by block
+    void load(RMSHistory &) const;
+
+    QString getError(void) const;
+    uint64_t size(void) const;
+    qreal getRate(void) const;
+    qreal getFirstTimeStamp(void) const;
+    qreal getLastTimeStamp(void) const;
+  };
+
+  extern "C" {
+    // Makes the binary log available as a suscli datasaver
+    void sigdigger_rms_log_params_init(
+        struct suscli_datasaver_params *self,
+        const hashlist_t *params);
+  }
+}
+
+#endif // RMSLOG_H
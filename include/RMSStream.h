@@ -0,0 +1,115 @@
+//
+//    RMSStream.h: One remote power meter, independent of any widget
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef RMSSTREAM_H
+#define RMSSTREAM_H
+
+#include <QMutex>
+#include <QString>
+#include <vector>
+
+class QIODevice;
+
+//
+// RMS feed protocol. Text lines by default:
+//
+//   DESC,<title>
+//   RATE,<samples per second>
+//   <seconds>,<fraction of second>,<linear power>,<power in dB>
+//
+// Right after connecting, the viewer sends RMS_STREAM_CAPS_LINE. A peer
+// that understands it may answer RMS_STREAM_BINARY_LINE, and everything
+// that follows is binary records of RMS_STREAM_RECORD_SIZE bytes: a
+// timestamp (double, seconds since the epoch) and the linear power
+// (float), both little endian. Peers that ignore the greeting keep
+// talking text.
+//
+#define RMS_STREAM_CAPS_LINE     "CAPS,BINARY\n"
+#define RMS_STREAM_BINARY_LINE   "MODE,BINARY"
+#define RMS_STREAM_RECORD_SIZE   (sizeof(double) + sizeof(float))
+
+#define RMS_STREAM_MAX_LINE_SIZE 4096
+
+// Bytes read from the socket at once
+#define RMS_STREAM_READ_SIZE     65536
+
+// Measures waiting for a view. Beyond this, the oldest are dropped.
+#define RMS_STREAM_MAX_PENDING   (1 << 20)
+
+namespace SigDigger {
+  struct RMSMeasure {
+    qreal timeStamp;
+    qreal mag;
+  };
+
+  // What the summary grid shows. Copied out under the stream lock.
+  struct RMSStreamInfo {
+    QString peer;
+    QString title;
+    qreal   rate = 0;
+    bool    online = true;
+    quint64 count = 0;      // Measures since the connection was made
+    qreal   last = 0;       // Latest linear power
+    qreal   min = 0;
+    qreal   max = 0;
+    qreal   lastTime = 0;
+    unsigned int titleSerial = 0; // Changes with every new title
+    unsigned int rateSerial  = 0; // Changes with every new rate
+  };
+
+  //
+  // The decoding side runs in an ingest thread (see RMSIngestWorker)
+  // and the rest in the GUI thread. Measures are only queued while a
+  // view keeps them (setKeepMeasures()); otherwise just the summary is
+  // updated, which costs next to nothing per stream.
+  //
+  class RMSStream
+  {
+      // Ingest thread only
+      std::vector<char> rxBuffer;
+      size_t rxLen = 0;
+      bool binary = false;
+
+      // Shared with the GUI thread
+      mutable QMutex mutex;
+      RMSStreamInfo info;
+      std::vector<RMSMeasure> pending;
+      bool keep = false;
+
+      // Called with the mutex held
+      bool parseLine(char *line, size_t len);
+      size_t parseText(char *data, size_t len);
+      size_t parseBinary(const char *data, size_t len);
+      void measure(qreal timeStamp, qreal mag);
+
+    public:
+      RMSStream(QString const &peer);
+
+      // Ingest thread. Returns false if the peer misbehaved.
+      bool ingest(QIODevice *);
+      void setOnline(bool);
+
+      // GUI thread
+      void setKeepMeasures(bool);
+      bool takeMeasures(std::vector<RMSMeasure> &dest);
+      RMSStreamInfo getInfo(void) const;
+  };
+}
+
+#endif // RMSSTREAM_H
@@ -21,25 +21,37 @@
 
 #include <QWidget>
 #include <QTimer>
-#include <QTcpSocket>
 #include <sigutils/types.h>
 #include <vector>
 #include <ColorConfig.h>
+#include <RMSHistory.h>
+#include <RMSStream.h>
 #include <Waveform.h>
 
 namespace Ui {
   class RMSViewTab;
 }
 
+// Points handed to the waveform. Beyond this, the whole plot is rebuilt
+// from the history with twice the decimation.
+#define RMS_VIEW_TAB_MAX_DISPLAY   (1 << 20)
+
 namespace SigDigger {
   class RMSViewTab : public QWidget
   {
       Q_OBJECT
 
-      QTcpSocket *socket = nullptr;
       QTimer timer;
-      std::string line;
+      RMSStream *m_stream = nullptr;        // Owned by RMSViewer
+      std::vector<RMSMeasure> m_measures;   // Drained from m_stream
+      unsigned int m_titleSerial = 0;
+      unsigned int m_rateSerial = 0;
       std::vector<SUCOMPLEX> data;
+      RMSHistory m_history;       // Every integrated measure, bounded
+      quint64 m_decimation = 1;   // Measures per point of `data'
+      bool m_dirty = false;       // Waveform must be refreshed
+      bool m_haveLog = false;     // Showing a log instead of live data
+      qreal m_liveRate = 1;       // Rate to restore when going live again
 
       qreal rate = 1;
       qreal first;
@@ -68,10 +80,12 @@ namespace SigDigger {
       void refreshSampleRate();
       void connectAll();
       void integrateMeasure(qreal timestamp, SUFLOAT mag);
-      bool parseLine();
-      void processSocketData();
+      void appendMeasure(SUFLOAT mag);
+      void refreshWaveform();
+      void rebuildData();
+      void drainStream();
+      void detachStream();
       bool saveToMatlab(QString const &);
-      void disconnectSocket();
       void fitVertical();
       void toggleModes(QObject *sender);
 
@@ -103,12 +117,14 @@ namespace SigDigger {
       qreal getIntegrationTimeHint() const;
 
       void setSampleRate(qreal);
+      void setHistoryMemory(size_t);
       void feed(qreal, qreal);
+      bool loadLog(QString const &);
       void setColorConfig(ColorConfig const &);
 
       bool running() const;
 
-      explicit RMSViewTab(QWidget *parent, QTcpSocket *socket);
+      explicit RMSViewTab(QWidget *parent, RMSStream *stream = nullptr);
       ~RMSViewTab();
 
     private:
@@ -119,15 +135,16 @@ namespace SigDigger {
       void viewTypeChanged();
       void integrationTimeChanged(qreal);
       void toggleState();
+      void closeRequested();
 
     public slots:
       void onTimeChanged(qreal, qreal);
       void onTimeout();
       void onToggleStartStop();
       void onSave();
+      void onOpen();
       void onToggleModes();
       void onResetZoom();
-      void onSocketDisconnected();
       void onValueChanged(int);
       void onPointClicked(qreal, qreal, Qt::KeyboardModifiers);
       void onToolTip(int, int, qreal, qreal);
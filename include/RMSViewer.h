@@ -22,9 +22,18 @@
 
 #include <QMainWindow>
 #include <QTcpServer>
+#include <QTimer>
+#include <QThread>
+#include <QMap>
 #include <vector>
 #include <QAbstractSocket>
 
+// Threads reading the feeds. Each one serves many connections.
+#define RMS_VIEWER_MAX_INGEST_THREADS 4
+
+// Summary grid refresh
+#define RMS_VIEWER_SUMMARY_INTERVAL_MS 1000
+
 namespace Ui {
   class RMSViewer;
 }
@@ -32,6 +41,8 @@ namespace Ui {
 namespace SigDigger {
   class RMSViewTab;
   class RMSViewerSettingsDialog;
+  class RMSStream;
+  class RMSIngestWorker;
 
   class RMSViewer : public QMainWindow
   {
@@ -40,11 +51,24 @@ namespace SigDigger {
       QTcpServer server;
       RMSViewerSettingsDialog *settingsDialog = nullptr;
 
+      // Every stream is decoded in the ingest pool, but only those with
+      // an open tab keep their measures and have a plot.
+      std::vector<QThread *> ingestThreads;
+      std::vector<RMSIngestWorker *> ingestWorkers;
+      unsigned int nextWorker = 0;
+      std::vector<RMSStream *> streams; // One per summary row
+      QMap<RMSStream *, RMSIngestWorker *> owners;
+      QMap<RMSStream *, RMSViewTab *> views;
+      QTimer summaryTimer;
+
       bool     listening  = false;
       QString  listenAddr = "";
       uint16_t listenPort = 0;
 
-      void openNewView(QTcpSocket *);
+      void addStream(QTcpSocket *);
+      void openView(RMSStream *);
+      RMSStream *findStream(RMSViewTab *) const;
+      void refreshSummaryRow(int);
       void connectAll(void);
 
       bool haveAddrData(void) const;
@@ -69,6 +93,11 @@ namespace SigDigger {
 
       void onTitleChanged(QString);
       void onTabCloseRequested(int);
+      void onViewCloseRequested(void);
+      void onSummaryActivated(int, int);
+      void onRefreshSummary(void);
+      void onPurge(void);
+      void onOpenLog(void);
   };
 };
 
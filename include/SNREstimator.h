@@ -22,56 +22,57 @@
 
 #include <cmath>
 #include <vector>
+#include <sigutils/types.h>
 
 //
 // Note: this class assumes a normalized interval (with x in range [0, 1))
 // SNR needs to be readjusted to the size of the decision interval
 //
+// The model is a Gaussian of width sigma centered in each decision
+// interval. Instead of fitting it to the histogram, sigma is derived from
+// the running second moment of the distance of every sample to the center
+// of its interval, which is O(1) per sample.
+//
+
+#define SNR_ESTIMATOR_DEFAULT_SIGMA  (1.f / 8.f)
 
-#define SNR_ESTIMATOR_DEFAULT_SIGMA (1.f / 8.f)
-#define SNR_ESTIMATOR_DEFAULT_ALPHA 1.f
+// Time constant of the running moment, in samples
+#define SNR_ESTIMATOR_DEFAULT_WINDOW 8192
 
 namespace SigDigger {
   class SNREstimator
   {
       float sigma = SNR_ESTIMATOR_DEFAULT_SIGMA;
-      float alpha = SNR_ESTIMATOR_DEFAULT_ALPHA;
+      float alpha = 1.f / SNR_ESTIMATOR_DEFAULT_WINDOW;
+
+      bool modulus = false;
+      float min = -static_cast<float>(M_PI);
+      float range = 2 * static_cast<float>(M_PI);
 
       unsigned int bps = 0;
       unsigned int intervals = 0;
-      float hx = 0;
-      float delta = 0;
-      unsigned int length = 0;
-      std::vector<float> gaussian;
+
+      // Running mean of the squared offset to the interval center, in
+      // interval units. Equally weighted until the window fills up.
+      float m2 = 0;
+      unsigned int count = 0;
+
       std::vector<float> Hi;     // Model histogram
-      std::vector<float> Htilde; // Actual histogram
-      float sqerr = INFINITY;
-      bool dirty = false;
-      void recalculateModel(void);
-      void calculateSquareError(void);
-      void iterate(void);
+      bool dirty = true;
+
+      void recalculateModel(unsigned int length);
 
     public:
       SNREstimator();
       void setBps(unsigned int bps);
-      void feed(std::vector<unsigned int> const &history);
-      void setAlpha(float alpha);
-      void setSigma(float sigma);
+      void setDecisionMode(bool modulus);
+      void setRange(float min, float max);
+      void setWindow(unsigned int samples);
+      void feed(const SUCOMPLEX *data, size_t size);
+      void reset(void);
 
-      std::vector<float> const &
-      getModel(void) const
-      {
-        return this->Hi;
-      }
-
-      float
-      getMSE(void)
-      {
-        if (this->dirty)
-          this->calculateSquareError();
-
-        return this->sqerr / this->length;
-      }
+      // Model sampled on `length' bins, peak normalized to 1
+      std::vector<float> const &getModel(unsigned int length);
 
       float
       getSigma(void) const
@@ -0,0 +1,89 @@
+//
+//    SPSCRing.h: Lock-free single producer, single consumer ring
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <QAtomicInteger>
+
+namespace SigDigger {
+  //
+  // Fixed-capacity FIFO of trivially copyable items (typically pointers
+  // to preallocated buffers). push() must always be called from the same
+  // thread, and so must pop(). Neither blocks nor allocates.
+  //
+  template<typename T, unsigned int N>
+  class SPSCRing {
+    static_assert((N & (N - 1)) == 0, "SPSCRing size must be a power of 2");
+
+    T m_items[N];
+    QAtomicInteger<unsigned int> m_head; // Next to pop, owned by consumer
+    QAtomicInteger<unsigned int> m_tail; // Next to push, owned by producer
+
+  public:
+    SPSCRing()
+    {
+      m_head.storeRelease(0);
+      m_tail.storeRelease(0);
+    }
+
+    bool
+    push(T item)
+    {
+      unsigned int tail = m_tail.loadAcquire();
+
+      if (tail - m_head.loadAcquire() == N)
+        return false;
+
+      m_items[tail & (N - 1)] = item;
+      m_tail.storeRelease(tail + 1);
+
+      return true;
+    }
+
+    bool
+    pop(T &item)
+    {
+      unsigned int head = m_head.loadAcquire();
+
+      if (head == m_tail.loadAcquire())
+        return false;
+
+      item = m_items[head & (N - 1)];
+      m_head.storeRelease(head + 1);
+
+      return true;
+    }
+
+    // Approximate when called from a third thread
+    unsigned int
+    size(void) const
+    {
+      return m_tail.loadAcquire() - m_head.loadAcquire();
+    }
+
+    static constexpr unsigned int
+    capacity(void)
+    {
+      return N;
+    }
+  };
+}
+
+#endif // SPSCRING_H
@@ -0,0 +1,99 @@
+//
+//    SharedMemoryForwarder.h: Export samples through a shared memory ring
+//    Copyright (C) 2024 Gonzalo José Carracedo Carballal
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as
+//    published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+//    WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public
+//    License along with this program.  If not, see
+//    <http://www.gnu.org/licenses/>
+//
+
+#ifndef SHAREDMEMORYFORWARDER_H
+#define SHAREDMEMORYFORWARDER_H
+
+#include "GenericDataSaver.h"
+#include <atomic>
+#include <string>
+
+#define SIGDIGGER_SHM_RING_MAGIC            0x52534453 // "SDSR"
+#define SIGDIGGER_SHM_RING_VERSION          2
+#define SIGDIGGER_SHM_RING_HEADER_SIZE      4096
+#define SIGDIGGER_SHM_RING_DEFAULT_CAPACITY (64 << 20)
+
+#define SIGDIGGER_SHM_RING_FORMAT_CF32      0 // Complex float32 (I, Q)
+#define SIGDIGGER_SHM_RING_FORMAT_F32       1 // Real float32
+#define SIGDIGGER_SHM_RING_FORMAT_U8        2 // Symbols, one per byte
+#define SIGDIGGER_SHM_RING_FORMAT_PACKED    3 // Symbols, bitsPerSymbol each
+
+#define SIGDIGGER_SHM_RING_FLAG_ACTIVE      1
+
+namespace SigDigger {
+  class SharedMemoryDataWriter;
+
+  //
+  // The shared memory segment starts with this header, padded to
+  // SIGDIGGER_SHM_RING_HEADER_SIZE bytes, followed by `capacity' bytes of
+  // sample data. Byte n of the stream lives at data[n % capacity].
+  //
+  // Indices count bytes since the writer was started and never wrap. The
+  // writer moves `reserveIndex' forward before overwriting anything and
+  // `writeIndex' after the data is in place, so a reader can do:
+  //
+  //   w = load_acquire(writeIndex)
+  //   copy bytes [r, w)
+  //   fence_acquire(); q = load_relaxed(reserveIndex)
+  //   bytes below q - capacity may have been overwritten during the copy
+  //
+  // Any number of readers can attach, and they never block the writer.
+  // When the writer stops it clears FLAG_ACTIVE and unlinks the segment.
+  // A segment that is already there is only replaced if it is inactive or
+  // its writer process is gone; otherwise forwarding fails to start.
+  //
+  // Samples reach the ring through the GenericDataSaver double buffer, so
+  // they are copied twice and show up one commit late. This saves the
+  // trip through the network stack, not the copies.
+  //
+  struct SharedMemoryRingHeader {
+    uint32_t magic       = SIGDIGGER_SHM_RING_MAGIC;
+    uint32_t version     = SIGDIGGER_SHM_RING_VERSION;
+    uint32_t headerSize  = SIGDIGGER_SHM_RING_HEADER_SIZE;
+    uint32_t format      = SIGDIGGER_SHM_RING_FORMAT_CF32;
+    uint32_t sampleSize  = sizeof(SUCOMPLEX);
+    uint32_t sampleRate  = 0;
+    uint64_t capacity    = 0;
+    uint32_t writerPid   = 0;
+    uint32_t bitsPerSymbol = 0; // FORMAT_PACKED only
+    std::atomic<uint32_t> flags;
+    std::atomic<uint64_t> reserveIndex;
+    std::atomic<uint64_t> writeIndex;
+  };
+
+  struct SharedMemoryForwarderParams {
+    std::string  name;
+    unsigned int format     = SIGDIGGER_SHM_RING_FORMAT_CF32;
+    unsigned int sampleSize = sizeof(SUCOMPLEX);
+    unsigned int sampleRate = 0;
+    size_t       capacity   = SIGDIGGER_SHM_RING_DEFAULT_CAPACITY;
+    unsigned int bitsPerSymbol = 0;
+  };
+
+  class SharedMemoryForwarder : public GenericDataSaver {
+    Q_OBJECT
+
+  public:
+    SharedMemoryForwarder(
+        SharedMemoryForwarderParams const &params,
+        QObject *parent = nullptr);
+  };
+}
+
+#endif // SHAREDMEMORYFORWARDER_H
@@ -21,24 +21,87 @@
 
 #include "GenericDataSaver.h"
 
-#define SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE 508
-#define SIGDIGGER_UDPFORWARDER_MAX_UDP_SAMPLES \
-  (SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE / static_cast<ssize_t>(sizeof(float _Complex)))
+#define SIGDIGGER_UDPFORWARDER_MAX_UDP_PAYLOAD_SIZE     65507
+#define SIGDIGGER_UDPFORWARDER_DEFAULT_UDP_PAYLOAD_SIZE 1472
+#define SIGDIGGER_UDPFORWARDER_MAX_BATCH                64
+#define SIGDIGGER_UDPFORWARDER_HEADER_MAGIC             0x5344
+#define SIGDIGGER_UDPFORWARDER_HEADER_VERSION           1
+#define SIGDIGGER_UDPFORWARDER_DEFAULT_CLIENT_QUEUE     (4 << 20)
+#define SIGDIGGER_UDPFORWARDER_MAX_CLIENTS              32
+#define SIGDIGGER_UDPFORWARDER_CLIENT_FRAME_SIZE        65536
+#define SIGDIGGER_UDPFORWARDER_SERVICE_INTERVAL_MS      100
 
 namespace SigDigger {
   class SocketDataWriter;
 
+  //
+  // Optional per-frame header. All fields are in network byte order. In
+  // UDP mode there is one header per datagram, in TCP mode one header
+  // precedes every frame of at most `frameLen' bytes.
+  //
+  //   sequence:    frame counter, starting from 0. Gaps mean lost frames.
+  //   payloadSize: bytes following this header.
+  //   sampleIndex: index of the first sample in the payload, counted
+  //                from the start of the forwarding session.
+  //   timestamp:   wall clock time (microseconds since the epoch) at which
+  //                the frame was sent.
+  //   bitsPerSymbol: for packed symbol streams, bits per symbol (see
+  //                PackedSymbolStream). sampleIndex then counts bytes.
+  //                Zero for every other kind of data.
+  //
+  struct SocketForwarderHeader {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  sampleSize;
+    uint32_t sequence;
+    uint32_t payloadSize;
+    uint8_t  bitsPerSymbol;
+    uint8_t  reserved[3];
+    uint64_t sampleIndex;
+    uint64_t timestamp;
+  };
+
+  //
+  // What to do with a listen-mode client whose queue is full. Dropping
+  // always discards whole frames, so the stream stays sample-aligned (and
+  // the header sequence number reveals the gap).
+  //
+  enum SlowClientPolicy {
+    SLOW_CLIENT_POLICY_DROP,
+    SLOW_CLIENT_POLICY_DISCONNECT
+  };
+
+  //
+  // In listen mode (tcp == true, listen == true) `host' is the address
+  // to bind to (empty means any address, IPv4 or IPv6) and every client
+  // that connects gets a copy of the stream. Each client has its own
+  // queue of at most `clientQueueSize' bytes, so a slow client never
+  // stalls the rest. Clients are accepted and their queues drained from
+  // a service thread, as soon as their sockets are ready, not only when
+  // the saver commits. Without headers, data is still queued in frames
+  // of at most SIGDIGGER_UDPFORWARDER_CLIENT_FRAME_SIZE bytes, so a full
+  // queue drops a bounded amount of data.
+  //
+  struct SocketForwarderParams {
+    std::string      host;
+    uint16_t         port       = 0;
+    unsigned int     frameLen   = SIGDIGGER_UDPFORWARDER_DEFAULT_UDP_PAYLOAD_SIZE;
+    unsigned int     sampleSize = sizeof(SUCOMPLEX);
+    unsigned int     bitsPerSymbol = 0; // Packed symbols only
+    bool             tcp        = false;
+    bool             listen     = false;
+    bool             header     = false;
+    SlowClientPolicy policy     = SLOW_CLIENT_POLICY_DROP;
+    size_t           clientQueueSize =
+        SIGDIGGER_UDPFORWARDER_DEFAULT_CLIENT_QUEUE;
+  };
+
   class SocketForwarder : public GenericDataSaver {
     Q_OBJECT
 
-    SocketDataWriter *writer = nullptr;
-
   public:
     SocketForwarder(
-        std::string const &host,
-        uint16_t port,
-        unsigned int size,
-        bool tcp,
+        SocketForwarderParams const &params,
         QObject *parent = nullptr);
   };
 }
@@ -22,6 +22,16 @@
 #include <QObject>
 #include <QThread>
 
+//
+// Tasks call work() back to back until this much time has passed, and
+// only then report progress and go back to the event loop. This keeps
+// the controller round trip out of the per-block cost, and bounds both
+// the progress update rate and the cancellation latency. Tasks that
+// hand data to the GUI call yieldSlice() after each emit, so that the
+// round trip through the controller throttles them to the GUI's pace.
+//
+#define SUSCAN_CANCELLABLE_TASK_BUDGET_MS 100
+
 namespace Suscan {
   class CancellableTask : public QObject
   {
@@ -30,8 +40,10 @@ namespace Suscan {
     qreal prog;
     QString status;
     quint64 dataSize = 0;
+    bool yielding = false;
 
   protected:
+    void yieldSlice(void);
     void setDataSize(quint64);
     void setProgress(qreal progress);
     void setStatus(QString status);
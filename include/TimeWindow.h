@@ -20,6 +20,7 @@
 #define TIMEWINDOW_H
 
 #include <QMainWindow>
+#include <QVector>
 
 #include "SamplingProperties.h"
 #include <Suscan/CancellableTask.h>
@@ -192,7 +193,7 @@ namespace SigDigger {
 
     void onTriggerHistogram();
     void onHistogramBlanked();
-    void onHistogramSamples(const float *data, unsigned int len);
+    void onHistogramSamples(QVector<float>);
 
     void onTriggerSampler();
     void onResample();
@@ -29,6 +29,7 @@
 #include <sigutils/version.h>
 #include <analyzer/version.h>
 #include <FileViewer.h>
+#include <FFTWPlanCache.h>
 
 #include <cstring>
 #include <getopt.h>
@@ -109,6 +110,7 @@ static int
 runSigDigger(QApplication &app)
 {
   int ret = 1;
+  FFTWPlanCache *planCache = nullptr;
 
   try {
     Application main_app;
@@ -118,6 +120,9 @@ runSigDigger(QApplication &app)
     fmt.setSamples(16);
     QSurfaceFormat::setDefaultFormat(fmt);
 
+    // Create the plan cache before any worker can ask for a plan
+    planCache = FFTWPlanCache::instance();
+
     loader.load();
 
     ret = app.exec();
@@ -137,6 +142,10 @@ runSigDigger(QApplication &app)
     app.quit();
   }
 
+  // Analyzer and workers are gone by now, nobody else is planning
+  if (planCache != nullptr)
+    planCache->finish();
+
   return ret;
 }
 